@@ -0,0 +1,91 @@
+#include "capturegen.h"
+#include <QFile>
+#include <cstring>
+
+namespace {
+
+// xorshift64*: fast enough that generating a capture costs less than splitting it.
+class Random {
+public:
+    explicit Random(quint64 seed) : m_state(seed ? seed : 0x9e3779b97f4a7c15ull) {}
+
+    quint64 next() {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * 0x2545f4914f6cdd1dull;
+    }
+
+    void fill(char *data, int size) {
+        for (; size >= 8; data += 8, size -= 8) {
+            const quint64 word = next();
+            std::memcpy(data, &word, 8);
+        }
+        if (size > 0) {
+            const quint64 word = next();
+            std::memcpy(data, &word, size);
+        }
+    }
+
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    int below(int bound) { return bound > 0 ? static_cast<int>(next() % quint64(bound)) : 0; }
+
+private:
+    quint64 m_state;
+};
+
+} // namespace
+
+bool writeSyntheticCapture(const QString &path, const CaptureSpec &spec, CaptureStats *stats) {
+    const int frameSize = spec.frameSizeBytes;
+    const int syncSize = spec.syncWord.size();
+    if (frameSize <= 0 || syncSize > frameSize || spec.sizeBytes < 0) return false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    // Frames are assembled in a block of about 4 MB so the file sees few, large
+    // writes; the slack holds the garbage a corrupted frame may insert.
+    const int blockFrames = qMax(1, (4 * 1024 * 1024) / frameSize);
+    QByteArray block;
+    block.reserve(blockFrames * qint64(frameSize) * 2);
+    Random random(spec.seed);
+    CaptureStats counts;
+    qint64 written = 0;
+
+    while (written < spec.sizeBytes) {
+        block.resize(0);
+        for (int i = 0; i < blockFrames; ++i) {
+            const int start = block.size();
+            block.resize(start + frameSize);
+            char *frame = block.data() + start;
+            random.fill(frame, frameSize);
+            std::memcpy(frame, spec.syncWord.constData(), syncSize);
+            ++counts.frames;
+
+            if (spec.corruptionRate <= 0 || random.uniform() >= spec.corruptionRate) continue;
+            ++counts.corruptedFrames;
+            switch (random.below(3)) {
+            case 0:  // Bit error in the sync word
+                frame[random.below(syncSize)] ^= static_cast<char>(1 << random.below(8));
+                break;
+            case 1:  // Frame cut short, so the next sync word arrives early
+                block.resize(start + syncSize + random.below(frameSize - syncSize));
+                break;
+            default: {  // Stray bytes between this frame and the next
+                const int extra = 1 + random.below(frameSize);
+                block.resize(block.size() + extra);
+                random.fill(block.data() + block.size() - extra, extra);
+                break;
+            }
+            }
+        }
+
+        const qint64 chunk = qMin<qint64>(block.size(), spec.sizeBytes - written);
+        if (file.write(block.constData(), chunk) != chunk) return false;
+        written += chunk;
+    }
+
+    if (stats) *stats = counts;
+    return true;
+}
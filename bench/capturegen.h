@@ -0,0 +1,26 @@
+#ifndef CAPTUREGEN_H
+#define CAPTUREGEN_H
+
+#include <QByteArray>
+#include <QString>
+
+// A synthetic capture: frames of frameSizeBytes that start with syncWord and
+// carry pseudo-random payload. corruptionRate is the share of frames damaged
+// the way real links fail: a broken sync word, a frame cut short, or stray
+// bytes inserted after it. The same spec always produces the same file.
+struct CaptureSpec {
+    qint64 sizeBytes = 512LL * 1024 * 1024;
+    int frameSizeBytes = 1111;
+    QByteArray syncWord = QByteArray::fromHex("4711");
+    double corruptionRate = 0.0;
+    quint64 seed = 1;
+};
+
+struct CaptureStats {
+    qint64 frames = 0;
+    qint64 corruptedFrames = 0;
+};
+
+bool writeSyntheticCapture(const QString &path, const CaptureSpec &spec, CaptureStats *stats = nullptr);
+
+#endif // CAPTUREGEN_H
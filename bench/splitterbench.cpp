@@ -0,0 +1,360 @@
+// Benchmark suite for the splitter. Generates synthetic captures, sweeps frame
+// size, bulk size, buffer size and I/O backend through
+// BinarySplitterCore::splitBinaryFile, and times detectFrameSize and the sync
+// word search. Every measurement reports GB/s, I/O syscalls, heap allocations
+// per GB and peak RSS as JSON, so a pipeline can gate on regressions.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include "binarysplittercore.h"
+#include "capturegen.h"
+#include "framesync.h"
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+std::atomic<bool> g_countAllocations(false);
+std::atomic<qint64> g_allocations(0);
+
+} // namespace
+
+#ifdef __GLIBC__
+// Count every heap allocation in the process, including the ones Qt containers
+// make through malloc and the page-aligned I/O buffers the engine takes from
+// posix_memalign, while a measurement is running.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size) {
+    if (g_countAllocations.load(std::memory_order_relaxed)) ++g_allocations;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    if (g_countAllocations.load(std::memory_order_relaxed)) ++g_allocations;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (g_countAllocations.load(std::memory_order_relaxed)) ++g_allocations;
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    if (g_countAllocations.load(std::memory_order_relaxed)) ++g_allocations;
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    if (g_countAllocations.load(std::memory_order_relaxed)) ++g_allocations;
+    return __libc_memalign(alignment, size);
+}
+
+// glibc exports no __libc_ entry for posix_memalign, so its argument checks
+// are repeated here in front of memalign.
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0) return EINVAL;
+    if (g_countAllocations.load(std::memory_order_relaxed)) ++g_allocations;
+    void *memory = __libc_memalign(alignment, size);
+    if (!memory) return ENOMEM;
+    *memptr = memory;
+    return 0;
+}
+}
+#endif
+
+namespace {
+
+// Read and write calls of every thread in the process, from /proc/self/io
+// (syscr + syscw); -1 where the kernel does not provide it.
+qint64 ioSyscalls() {
+    QFile file("/proc/self/io");
+    if (!file.open(QIODevice::ReadOnly)) return -1;
+    qint64 count = 0;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+        if (line.startsWith("syscr:") || line.startsWith("syscw:")) count += line.mid(6).trimmed().toLongLong();
+    }
+    return count;
+}
+
+// Linux lets a process reset its high-water mark, which makes the peak RSS of
+// each measurement independent of the ones before it.
+void resetPeakRss() {
+    QFile file("/proc/self/clear_refs");
+    if (file.open(QIODevice::WriteOnly)) file.write("5");
+}
+
+qint64 peakRssKb() {
+    QFile file("/proc/self/status");
+    if (file.open(QIODevice::ReadOnly)) {
+        for (const QByteArray &line : file.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:")) return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+    return -1;
+}
+
+// Brackets one benchmarked operation and turns the counters into per-GB rates.
+class Measurement {
+public:
+    Measurement() {
+        resetPeakRss();
+        m_syscalls = ioSyscalls();
+        g_allocations = 0;
+        m_timer.start();
+        g_countAllocations = true;
+    }
+
+    QJsonObject finish(qint64 bytes) {
+        g_countAllocations = false;
+        const double seconds = m_timer.nsecsElapsed() / 1e9;
+        const qint64 syscallsAfter = ioSyscalls();
+        const double gigabytes = bytes / (1024.0 * 1024.0 * 1024.0);
+
+        QJsonObject result;
+        result["bytes"] = bytes;
+        result["seconds"] = seconds;
+        result["gb_per_s"] = seconds > 0 ? gigabytes / seconds : 0.0;
+        if (m_syscalls >= 0 && syscallsAfter >= 0) {
+            result["io_syscalls"] = syscallsAfter - m_syscalls;
+            result["syscalls_per_gb"] = gigabytes > 0 ? (syscallsAfter - m_syscalls) / gigabytes : 0.0;
+        }
+        result["allocations"] = g_allocations.load();
+        result["allocations_per_gb"] = gigabytes > 0 ? g_allocations.load() / gigabytes : 0.0;
+        result["peak_rss_kb"] = peakRssKb();
+        return result;
+    }
+
+private:
+    QElapsedTimer m_timer;
+    qint64 m_syscalls = -1;
+};
+
+QList<int> parseList(const QString &value) {
+    QList<int> numbers;
+    for (const QString &item : value.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int number = item.trimmed().toInt(&ok);
+        if (ok && number > 0) numbers.append(number);
+    }
+    return numbers;
+}
+
+void removeBulks(const QString &dirPath) {
+    QDir dir(dirPath);
+    for (const QString &name : dir.entryList({"bench_*"}, QDir::Files)) dir.remove(name);
+}
+
+QJsonObject runSplit(const QString &inputPath, const QString &backend, qint64 sizeBytes, int frameSizeBytes,
+                     int bulkSizeMb, int bufferSizeKb, const QString &syncWordHex) {
+    BinarySplitterCore core;
+    core.setPipelined(backend == "pipelined");
+    core.setIoBackend(backend == "uring" || backend == "qt" ? backend : QString("posix"));
+    core.setBufferSizeKb(bufferSizeKb);
+    core.setResync(backend == "resync");
+    core.setSyncWord(syncWordHex);
+    QString error;
+    QObject::connect(&core, &BinarySplitterCore::splitError, [&error](const QString &message) {
+        error = message;
+    });
+
+    Measurement measurement;
+    core.splitBinaryFile(inputPath, bulkSizeMb / 1024.0, frameSizeBytes, "bench");
+    QJsonObject result = measurement.finish(sizeBytes);
+    removeBulks(QFileInfo(inputPath).absolutePath());
+
+    result["backend"] = backend;
+    result["frame_size_bytes"] = frameSizeBytes;
+    result["bulk_size_mb"] = bulkSizeMb;
+    result["buffer_size_kb"] = bufferSizeKb;
+    if (!error.isEmpty()) result["error"] = error;
+    return result;
+}
+
+QJsonObject runDetect(const QString &inputPath, qint64 sizeBytes, const QString &syncWordHex) {
+    BinarySplitterCore core;
+    Measurement measurement;
+    const QJsonObject detection = core.analyzeFrameSize(inputPath, syncWordHex);
+    // Detection samples the file, so bytes is the capture size and GB/s is the
+    // effective rate, not the amount actually read.
+    QJsonObject result = measurement.finish(sizeBytes);
+    result["detected_frame_size"] = detection["frame_size"];
+    result["confidence"] = detection["confidence"];
+    result["lock_ratio"] = detection["lock_ratio"];
+    return result;
+}
+
+// Counts sync word hits over the whole mapped capture, once with the
+// QByteArray::indexOf loop the splitter originally used and once with
+// findSyncWord(), which replaced it.
+QJsonArray runSyncSearch(const QString &inputPath, const QByteArray &syncWord) {
+    QJsonArray results;
+    QFile file(inputPath);
+    if (!file.open(QIODevice::ReadOnly) || syncWord.isEmpty()) return results;
+    const qint64 size = file.size();
+    const char *mapped = reinterpret_cast<const char *>(file.map(0, size));
+    if (!mapped) return results;
+
+    {
+        const QByteArray data = QByteArray::fromRawData(mapped, static_cast<qsizetype>(size));
+        Measurement measurement;
+        qint64 hits = 0;
+        for (qsizetype pos = data.indexOf(syncWord); pos >= 0; pos = data.indexOf(syncWord, pos + 1)) ++hits;
+        QJsonObject result = measurement.finish(data.size());
+        result["method"] = "QByteArray::indexOf";
+        result["hits"] = hits;
+        results.append(result);
+    }
+    {
+        Measurement measurement;
+        qint64 hits = 0;
+        const char *end = mapped + size;
+        for (const char *p = findSyncWord(mapped, size, syncWord.constData(), syncWord.size()); p;
+             p = findSyncWord(p + 1, end - p - 1, syncWord.constData(), syncWord.size())) {
+            ++hits;
+        }
+        QJsonObject result = measurement.finish(size);
+        result["method"] = "findSyncWord";
+        result["hits"] = hits;
+        results.append(result);
+    }
+    return results;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption("size-mb", "Size of the generated capture in MB (default: 512)", "mb"));
+    parser.addOption(QCommandLineOption("frame-sizes", "Comma-separated frame sizes in bytes (default: 1111)", "list"));
+    parser.addOption(QCommandLineOption("bulk-sizes-mb", "Comma-separated bulk sizes in MB (default: 128)", "list"));
+    parser.addOption(QCommandLineOption("buffer-sizes-kb", "Comma-separated pipeline buffer sizes in KiB (default: 1024)", "list"));
+    parser.addOption(QCommandLineOption("backends", "Comma-separated modes: zero-copy, pipelined, uring, qt, resync "
+                                                    "(default: zero-copy,pipelined,uring,qt)", "list"));
+    parser.addOption(QCommandLineOption("sync-word", "Sync word in hex (default: 4711)", "hex"));
+    parser.addOption(QCommandLineOption("corruption-rate", "Share of corrupted frames, 0 to 1 (default: 0)", "rate"));
+    parser.addOption(QCommandLineOption("seed", "Seed of the capture generator (default: 1)", "n"));
+    parser.addOption(QCommandLineOption("generate", "Only write a synthetic capture to file and exit", "file"));
+    parser.addOption(QCommandLineOption("output", "Write the JSON report to file instead of stdout", "file"));
+    parser.process(app);
+
+    CaptureSpec spec;
+    spec.sizeBytes = qint64(parser.isSet("size-mb") ? parser.value("size-mb").toInt() : 512) * 1024 * 1024;
+    spec.syncWord = QByteArray::fromHex(parser.isSet("sync-word") ? parser.value("sync-word").toUtf8() : "4711");
+    spec.corruptionRate = parser.isSet("corruption-rate") ? parser.value("corruption-rate").toDouble() : 0.0;
+    spec.seed = parser.isSet("seed") ? parser.value("seed").toULongLong() : 1;
+    const QString syncWordHex = QString::fromLatin1(spec.syncWord.toHex());
+    const QList<int> frameSizes = parseList(parser.isSet("frame-sizes") ? parser.value("frame-sizes") : "1111");
+    const QList<int> bulkSizes = parseList(parser.isSet("bulk-sizes-mb") ? parser.value("bulk-sizes-mb") : "128");
+    const QList<int> bufferSizes = parseList(parser.isSet("buffer-sizes-kb") ? parser.value("buffer-sizes-kb") : "1024");
+    const QStringList backends = (parser.isSet("backends") ? parser.value("backends")
+                                                           : QString("zero-copy,pipelined,uring,qt"))
+                                     .split(',', Qt::SkipEmptyParts);
+
+    QTextStream err(stderr);
+    if (spec.sizeBytes <= 0 || spec.syncWord.isEmpty() || frameSizes.isEmpty() || bulkSizes.isEmpty()
+        || bufferSizes.isEmpty()) {
+        err << "Error: Invalid benchmark parameters.\n";
+        return 1;
+    }
+
+    if (parser.isSet("generate")) {
+        spec.frameSizeBytes = frameSizes.first();
+        if (!writeSyntheticCapture(parser.value("generate"), spec)) {
+            err << "Error: Cannot write " << parser.value("generate") << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        err << "Error: Cannot create a temporary directory.\n";
+        return 1;
+    }
+
+    QJsonArray captures;
+    QJsonArray splits;
+    QJsonArray detections;
+    QJsonArray searches;
+    for (int frameSize : frameSizes) {
+        spec.frameSizeBytes = frameSize;
+        const QString inputPath = dir.filePath(QString("capture_%1.bin").arg(frameSize));
+        CaptureStats stats;
+        if (!writeSyntheticCapture(inputPath, spec, &stats)) {
+            err << "Error: Cannot generate the benchmark capture.\n";
+            return 1;
+        }
+        QJsonObject capture;
+        capture["frame_size_bytes"] = frameSize;
+        capture["size_bytes"] = spec.sizeBytes;
+        capture["frames"] = stats.frames;
+        capture["corrupted_frames"] = stats.corruptedFrames;
+        captures.append(capture);
+
+        for (const QString &backend : backends) {
+            // Only the ring-based modes have a buffer size; the others run once per bulk size.
+            const bool buffered = backend == "pipelined" || backend == "uring" || backend == "resync";
+            for (int bulkSize : bulkSizes) {
+                for (int bufferSize : buffered ? bufferSizes : QList<int>{bufferSizes.first()}) {
+                    splits.append(runSplit(inputPath, backend, spec.sizeBytes, frameSize, bulkSize, bufferSize,
+                                           syncWordHex));
+                }
+            }
+        }
+
+        QJsonObject detection = runDetect(inputPath, spec.sizeBytes, syncWordHex);
+        detection["frame_size_bytes"] = frameSize;
+        detections.append(detection);
+        for (const QJsonValue &search : runSyncSearch(inputPath, spec.syncWord)) {
+            QJsonObject entry = search.toObject();
+            entry["frame_size_bytes"] = frameSize;
+            searches.append(entry);
+        }
+        QFile::remove(inputPath);
+    }
+
+    QJsonObject report;
+    report["sync_word_hex"] = syncWordHex;
+    report["corruption_rate"] = spec.corruptionRate;
+    report["captures"] = captures;
+    report["split"] = splits;
+    report["detect_frame_size"] = detections;
+    report["sync_search"] = searches;
+
+    const QByteArray json = QJsonDocument(report).toJson();
+    if (parser.isSet("output")) {
+        QFile file(parser.value("output"));
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+            err << "Error: Cannot write " << parser.value("output") << "\n";
+            return 1;
+        }
+    } else {
+        QTextStream out(stdout);
+        out << json;
+    }
+    return 0;
+}
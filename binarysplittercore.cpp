@@ -1,16 +1,50 @@
 #include "binarysplittercore.h"
 #include <QFile>
+#include <QSaveFile>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QDir>
-#include <QCoreApplication>  // For processEvents()
+#include <QMap>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QElapsedTimer>
+#include "bulkplan.h"
+#include "framedetect.h"
+#include "splitstats.h"
+#ifdef Q_OS_UNIX
+#include "checksum.h"
+#include "framedemux.h"
+#include "splitbatch.h"
+#include "splitengine.h"
+#include "splitjoin.h"
+#include <sys/stat.h>
+#endif
 
-BinarySplitterCore::BinarySplitterCore(QObject *parent) : QObject(parent), m_stopFlag(false) {}
+BinarySplitterCore::BinarySplitterCore(QObject *parent) : QObject(parent), m_jobs(1),
+    m_pipelined(false), m_ringDepth(4), m_bufferSizeKb(1024), m_ioBackend("posix"),
+    m_resync(false), m_syncWordHex("4711"), m_writeIndex(false), m_resume(false), m_verifyResumed(false),
+    m_writeManifest(false), m_follow(false), m_followIdleSeconds(600),
+    m_batchJobs(QThread::idealThreadCount()), m_deviceJobs(4),
+    m_directIo(false), m_sparse(false), m_demuxMemoryMb(64), m_chunkMinBytes(0), m_chunkAvgBytes(0), m_chunkMaxBytes(0),
+    m_compressThreads(0) {}
 
 QJsonObject BinarySplitterCore::loadConfigDefaults(const QString &configFilePath) {
     QJsonObject defaults;
     defaults["default_frame_size_bytes"] = 1111;
     defaults["default_bulk_size_gb"] = 2.0;
     defaults["default_sync_word_hex"] = "4711";
+    defaults["default_ring_depth"] = 4;
+    defaults["default_buffer_size_kb"] = 1024;
+    defaults["default_io_backend"] = "posix";
+    defaults["default_write_index"] = false;
+    defaults["default_write_manifest"] = false;
+    defaults["default_device_jobs"] = 4;
+    defaults["default_direct_io"] = false;
+    defaults["default_sparse"] = false;
+    defaults["default_compression"] = "";
+    defaults["default_frame_transform"] = "";
+    defaults["default_demux_memory_mb"] = 64;
 
     QFile file(configFilePath);
     if (file.open(QIODevice::ReadOnly)) {
@@ -27,109 +61,970 @@ QJsonObject BinarySplitterCore::loadConfigDefaults(const QString &configFilePath
 
 int BinarySplitterCore::detectFrameSize(const QString &inputFilePath, const QString &syncWordHex,
                                         int searchChunkSize, int maxFrameSizeGuess) {
+    QJsonObject detection = analyzeFrameSize(inputFilePath, syncWordHex, searchChunkSize, maxFrameSizeGuess);
+    return detection["frame_size"].toInt(-1);
+}
+
+// Samples a fixed number of windows spread over the whole file, so the cost does
+// not grow with the input size. Each window is memory mapped and only the pages
+// actually scanned are read; files too small to sample are scanned completely.
+QJsonObject BinarySplitterCore::analyzeFrameSize(const QString &inputFilePath, const QString &syncWordHex,
+                                                 int searchChunkSize, int maxFrameSizeGuess) {
+    const int windowCount = 32;
+    QJsonObject result;
+    result["frame_size"] = -1;
+
     QByteArray syncWordBytes = QByteArray::fromHex(syncWordHex.toUtf8());
-    if (syncWordBytes.isEmpty()) return -1;
+    if (syncWordBytes.isEmpty() || maxFrameSizeGuess <= 0) return result;
 
     QFile file(inputFilePath);
-    if (!file.open(QIODevice::ReadOnly)) return -1;
+    if (!file.open(QIODevice::ReadOnly)) return result;
 
-    QByteArray chunk = file.read(searchChunkSize);
-    int firstSyncIndex = chunk.indexOf(syncWordBytes);
-    if (firstSyncIndex == -1) return -1;
+#ifdef Q_OS_UNIX
+    // An index written by a resync split of this very file already knows the answer.
+    const QByteArray encodedPath = QFile::encodeName(inputFilePath);
+    FrameIndex index;
+    struct stat st;
+    if (::stat(encodedPath.constData(), &st) == 0 && index.open(frameIndexPath(encodedPath.toStdString()))
+        && index.matches(st.st_size, modificationTimeNs(st)) && (index.flags() & FrameIndexRun::SyncChecked)
+        && index.syncWord() == syncWordBytes.toStdString() && index.frameSize() <= maxFrameSizeGuess) {
+        qint64 validBytes = 0;
+        for (size_t i = 0; i < index.runCount(); ++i) {
+            const FrameIndexRun &run = index.run(i);
+            if (run.flags & FrameIndexRun::SyncValid) validBytes += qint64(run.count) * run.stride;
+        }
+        result["frame_size"] = index.frameSize();
+        result["confidence"] = 1.0;
+        result["lock_ratio"] = index.inputSize() > 0 ? double(validBytes) / index.inputSize() : 0.0;
+        result["sync_count"] = qint64(index.frameCount());
+        result["windows"] = 0;
+        result["source"] = "index";
+        return result;
+    }
+#endif
 
-    file.seek(firstSyncIndex + syncWordBytes.length());
-    QByteArray nextChunk = file.read(maxFrameSizeGuess);
-    int secondSyncIndex = nextChunk.indexOf(syncWordBytes);
+    // Every window has to hold a few frames of the largest size considered.
+    const qint64 fileSize = file.size();
+    const qint64 windowBytes = qMax<qint64>(qMax(searchChunkSize, 256 * 1024),
+                                            4 * (qint64(maxFrameSizeGuess) + syncWordBytes.size()));
+    const int windows = (fileSize <= windowBytes * windowCount) ? 1 : windowCount;
+    const qint64 sampleBytes = (windows == 1) ? fileSize : windowBytes;
 
-    if (secondSyncIndex == -1) return -1;
-    int detectedFrameSize = secondSyncIndex + syncWordBytes.length();
+    FramePeriodDetector detector(syncWordBytes.toStdString(), maxFrameSizeGuess);
+    QByteArray buffer;
+    for (int i = 0; i < windows; ++i) {
+        const qint64 offset = (windows == 1) ? 0 : (fileSize - sampleBytes) / (windows - 1) * i / 4096 * 4096;
+        if (uchar *mapped = file.map(offset, sampleBytes)) {
+            detector.addWindow(reinterpret_cast<const char *>(mapped), static_cast<size_t>(sampleBytes));
+            file.unmap(mapped);
+        } else if (file.seek(offset)) {
+            buffer = file.read(sampleBytes);
+            detector.addWindow(buffer.constData(), static_cast<size_t>(buffer.size()));
+        }
+    }
 
-    return (detectedFrameSize > syncWordBytes.length()) ? detectedFrameSize : -1;
+    FrameDetection detection = detector.result();
+    result["frame_size"] = detection.frameSize;
+    result["confidence"] = detection.confidence;
+    result["lock_ratio"] = detection.lockRatio;
+    result["sync_count"] = qint64(detection.syncCount);
+    result["windows"] = detection.windows;
+    result["source"] = "samples";
+    return result;
 }
 
 void BinarySplitterCore::splitBinaryFile(const QString &inputFilePath, double bulkSizeGb,
                                          int frameSizeBytes, const QString &outputPrefix) {
-    const qint64 bufferSize = 1024 * 1024; // 1MB buffer
     qint64 bulkSizeBytes = static_cast<qint64>(bulkSizeGb * 1024 * 1024 * 1024);
-    int bulkCount = 1;
-    qint64 currentBulkSize = 0;
+    // "-" reads stdin; its bulks go to the working directory.
+    const bool fromStdin = (inputFilePath == "-");
+    QString outputDir = fromStdin ? QDir::currentPath() : QFileInfo(inputFilePath).absolutePath();
+    QString prefix = (outputPrefix == "output_bulk") ?
+                         (fromStdin ? QString("stdin") : QFileInfo(inputFilePath).baseName()) : outputPrefix;
+
+#ifdef Q_OS_UNIX
+    ChannelField channelField;
+    std::string fieldError;
+    if (!m_channelField.isEmpty() && !parseChannelField(m_channelField.toStdString(), &channelField, &fieldError)) {
+        emit splitError(QString::fromStdString(fieldError));
+        return;
+    }
+    // The QFile loop only splits sequentially; every other option needs the engine.
+    if (m_ioBackend == "qt" && m_jobs <= 1 && !m_pipelined && !m_writeIndex && !m_resync && !m_resume
+        && !m_writeManifest && !m_follow && !m_directIo && !m_sparse && !m_frameFilter.isActive()
+        && m_channelField.isEmpty() && m_chunkAvgBytes <= 0 && m_compression.isEmpty() && !m_frameTransform.isActive()
+        && !fromStdin) {
+        splitWithQFile(inputFilePath, bulkSizeBytes, frameSizeBytes, outputDir, prefix);
+        return;
+    }
+
+    SplitEngine engine(engineOptions(inputFilePath, outputDir, prefix, bulkSizeBytes, frameSizeBytes));
+    engine.setProgress(&m_progress);
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    const bool ok = engine.run();
+    emit statsReported(statsReport(engine.stats(), engine.inputBytes(), elapsed.nsecsElapsed(),
+                                   engine.ioBackendUsed() == IoBackend::Uring ? "uring" : "posix"));
+    if (!ok) {
+        if (engine.wasCancelled()) {
+            emit splitFinished("Split operation stopped.");
+        } else {
+            emit splitError(QString::fromStdString(engine.errorString()));
+        }
+        return;
+    }
+    const QString manifestPath = QString("%1/%2_manifest.json").arg(outputDir, prefix);
+    if ((m_writeManifest || m_chunkAvgBytes > 0) && !writeManifest(manifestPath, inputFilePath, frameSizeBytes, engine)) {
+        emit splitError("Cannot write manifest: " + manifestPath);
+        return;
+    }
+    // One headline for the kind of run, then a sentence for everything worth
+    // reporting about it.
+    QString headline = "Binary file splitting complete";
+    QStringList details;
+    if (m_chunkAvgBytes > 0) {
+        headline = "Content-defined split complete";
+        details << QString("%1 bulks, %2 of them already present (%3 MiB not written)")
+                       .arg(qint64(engine.finishedBulks().size())).arg(engine.reusedBulks())
+                       .arg(engine.reusedBytes() / (1024.0 * 1024.0), 0, 'f', 1)
+                << "Manifest: " + manifestPath;
+    } else if (!m_channelField.isEmpty()) {
+        headline = "Demultiplexing complete";
+        details << QString("Wrote %1 bulks for %2 channels").arg(engine.demuxBulks()).arg(engine.demuxChannels());
+    } else if (m_frameFilter.isActive()) {
+        const qint64 framesPerBulk = qMax<qint64>(1, bulkSizeBytes / frameSizeBytes);
+        headline = "Frame extraction complete";
+        details << QString("Kept %1 frames in %2 bulks")
+                       .arg(engine.extractedFrames())
+                       .arg((engine.extractedFrames() + framesPerBulk - 1) / framesPerBulk);
+    }
+    if (engine.usedFrameIndex()) headline += " using the frame index";
+    if (m_frameTransform.isActive()) {
+        details << QString("Wrote the %1-byte payloads of %2-byte frames")
+                       .arg(engine.outputFrameBytes()).arg(frameSizeBytes);
+    }
+    if (engine.skippedBytes() > 0) {
+        const QString reportPath = QString("%1/%2_resync.json").arg(outputDir, prefix);
+        if (!writeSyncGapReport(reportPath, inputFilePath, frameSizeBytes, engine.syncGaps())) {
+            emit splitError("Cannot write resync report: " + reportPath);
+            return;
+        }
+        details << QString("Skipped %1 bytes in %2 gaps, see %3")
+                       .arg(engine.skippedBytes()).arg(qint64(engine.syncGaps().size())).arg(reportPath);
+    }
+    if (engine.streamed()) {
+        const double seconds = qMax<qint64>(1, elapsed.elapsed()) / 1000.0;
+        details << QString("Streamed %1 MiB at %2 MiB/s")
+                       .arg(engine.inputBytes() / (1024.0 * 1024.0), 0, 'f', 1)
+                       .arg(engine.inputBytes() / (1024.0 * 1024.0) / seconds, 0, 'f', 1);
+    }
+    if (engine.resumedBulks() > 0) {
+        details << QString("Resumed after %1 verified bulks").arg(engine.resumedBulks());
+    }
+    if (!m_compression.isEmpty()) {
+        details << QString("Compressed %1 MiB to %2 MiB (%3%) with %4")
+                       .arg(engine.inputBytes() / (1024.0 * 1024.0), 0, 'f', 1)
+                       .arg(engine.compressedBytes() / (1024.0 * 1024.0), 0, 'f', 1)
+                       .arg(engine.inputBytes() > 0 ? 100.0 * engine.compressedBytes() / engine.inputBytes() : 100.0,
+                            0, 'f', 1)
+                       .arg(m_compression);
+    }
+    if (engine.sparseBytes() > 0) {
+        details << QString("Left %1 MiB of holes and zero frames unwritten")
+                       .arg(engine.sparseBytes() / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    details.prepend(headline);
+    emit splitFinished(details.join(". ") + ".");
+#else
+    // Only the QFile split exists here; every engine mode is refused up front.
+    // These are the options the UNIX qt shortcut above sends to the engine.
+    const struct {
+        bool active;
+        const char *mode;
+    } engineModes[] = {
+        {m_jobs > 1, "Writing bulks in parallel"},
+        {m_pipelined, "Pipelined splitting"},
+        {m_ioBackend == "uring", "The io_uring backend"},
+        {m_follow || fromStdin, "Streaming input"},
+        {m_resync, "Resynchronizing on the sync word"},
+        {m_writeIndex, "Writing a frame index"},
+        {m_resume, "Resuming a split"},
+        {m_writeManifest, "Writing a checksum manifest"},
+        {m_directIo, "Direct I/O"},
+        {m_frameFilter.isActive(), "Extracting frames"},
+        {!m_channelField.isEmpty(), "Demultiplexing"},
+        {m_chunkAvgBytes > 0, "Content-defined splitting"},
+        {m_sparse, "Sparse output"},
+        {!m_compression.isEmpty(), "Compressing bulks"},
+        {m_frameTransform.isActive(), "Transforming frames"},
+    };
+    for (const auto &engineMode : engineModes) {
+        if (engineMode.active) {
+            emit splitError(QString("%1 is not supported on this platform.").arg(engineMode.mode));
+            return;
+        }
+    }
+    splitWithQFile(inputFilePath, bulkSizeBytes, frameSizeBytes, outputDir, prefix);
+#endif
+}
+
+void BinarySplitterCore::verifyBulks(const QString &inputFilePath, const QString &outputPrefix) {
     QString outputDir = QFileInfo(inputFilePath).absolutePath();
     QString prefix = (outputPrefix == "output_bulk") ?
                          QFileInfo(inputFilePath).baseName() : outputPrefix;
+    const QString manifestPath = QString("%1/%2_manifest.json").arg(outputDir, prefix);
+
+#ifdef Q_OS_UNIX
+    QFile manifestFile(manifestPath);
+    if (!manifestFile.open(QIODevice::ReadOnly)) {
+        emit splitError("Manifest not found: " + manifestPath);
+        return;
+    }
+    const QJsonObject manifest = QJsonDocument::fromJson(manifestFile.readAll()).object();
+    if (manifest["algorithm"].toString() != "crc32c") {
+        emit splitError("Unsupported manifest: " + manifestPath);
+        return;
+    }
+
+    std::vector<FileChecksum> files;
+    const QJsonArray bulks = manifest["bulks"].toArray();
+    for (const QJsonValue &value : bulks) {
+        const QJsonObject bulk = value.toObject();
+        FileChecksum file;
+        file.path = QFile::encodeName(outputDir + "/" + bulk["name"].toString()).toStdString();
+        file.length = static_cast<int64_t>(bulk["length"].toDouble());
+        file.crc32c = bulk["crc32c"].toString().toUInt(nullptr, 16);
+        files.push_back(file);
+    }
+
+    std::vector<VerifyFailure> failures;
+    const bool completed = verifyFiles(files, m_jobs, &m_progress, &failures);
+    if (!completed) {
+        emit splitFinished("Verification stopped.");
+        return;
+    }
+    if (!failures.empty()) {
+        QStringList lines;
+        for (const VerifyFailure &failure : failures) {
+            lines << QString("%1: %2").arg(bulks[int(failure.file)].toObject()["name"].toString(),
+                                           QString::fromStdString(failure.reason));
+        }
+        emit splitError(QString("%1 of %2 bulks failed verification:\n%3")
+                            .arg(qint64(failures.size())).arg(qint64(files.size())).arg(lines.join("\n")));
+        return;
+    }
+
+    // When the bulks tile the input, their checksums must chain into the input's,
+    // which also catches a bulk missing from the manifest.
+    uint32_t chained = 0;
+    qint64 expectedOffset = 0;
+    for (size_t i = 0; i < files.size() && expectedOffset >= 0; ++i) {
+        const QJsonObject bulk = bulks[int(i)].toObject();
+        if (static_cast<qint64>(bulk["offset"].toDouble()) != expectedOffset) {
+            expectedOffset = -1;
+            break;
+        }
+        chained = crc32cCombine(chained, files[i].crc32c, files[i].length);
+        expectedOffset += files[i].length;
+    }
+    if (expectedOffset == static_cast<qint64>(manifest["input_size"].toDouble()) && manifest.contains("input_crc32c")
+        && chained != manifest["input_crc32c"].toString().toUInt(nullptr, 16)) {
+        emit splitError("The bulk checksums do not add up to the input checksum in " + manifestPath);
+        return;
+    }
+
+    emit splitFinished(QString("Verified %1 bulks against %2: all checksums match.")
+                           .arg(qint64(files.size())).arg(manifestPath));
+#else
+    Q_UNUSED(manifestPath);
+    emit splitError("Verifying checksums is not supported on this platform.");
+#endif
+}
+
+void BinarySplitterCore::joinBulks(const QString &inputFilePath, const QString &outputPrefix,
+                                   const QString &outputFilePath) {
+    QString outputDir = QFileInfo(inputFilePath).absolutePath();
+    QString prefix = (outputPrefix == "output_bulk") ?
+                         QFileInfo(inputFilePath).baseName() : outputPrefix;
+    const QString joinedPath = outputFilePath.isEmpty() ? inputFilePath : outputFilePath;
+    const QString manifestPath = QString("%1/%2_manifest.json").arg(outputDir, prefix);
+
+#ifdef Q_OS_UNIX
+    if (QFileInfo::exists(joinedPath)) {
+        emit splitError("Output file already exists: " + joinedPath);
+        return;
+    }
+
+    JoinOptions options;
+    options.outputPath = QFile::encodeName(joinedPath).toStdString();
+    options.jobs = m_jobs;
+    QStringList names;
+    QFile manifestFile(manifestPath);
+    if (manifestFile.open(QIODevice::ReadOnly)) {
+        const QJsonObject manifest = QJsonDocument::fromJson(manifestFile.readAll()).object();
+        if (manifest["algorithm"].toString() != "crc32c") {
+            emit splitError("Unsupported manifest: " + manifestPath);
+            return;
+        }
+        if (manifest.contains("codec") || manifest.contains("frame_transform")) {
+            emit splitError(QString(manifest.contains("codec") ? "Compressed" : "Transformed")
+                            + " bulks cannot be joined back into the input: " + manifestPath);
+            return;
+        }
+        // As in verifyBulks(), bulks that tile the input must also reproduce its checksum.
+        qint64 expectedOffset = 0;
+        for (const QJsonValue &value : manifest["bulks"].toArray()) {
+            const QJsonObject bulk = value.toObject();
+            if (bulk.contains("channel")) {
+                emit splitError("Demultiplexed bulks cannot be joined back into the input: " + manifestPath);
+                return;
+            }
+            JoinPart part;
+            part.path = QFile::encodeName(outputDir + "/" + bulk["name"].toString()).toStdString();
+            part.length = static_cast<int64_t>(bulk["length"].toDouble());
+            part.hasChecksum = true;
+            part.crc32c = bulk["crc32c"].toString().toUInt(nullptr, 16);
+            if (expectedOffset >= 0 && static_cast<qint64>(bulk["offset"].toDouble()) == expectedOffset) {
+                expectedOffset += part.length;
+            } else {
+                expectedOffset = -1;
+            }
+            options.parts.push_back(part);
+            names << bulk["name"].toString();
+        }
+        if (expectedOffset == static_cast<qint64>(manifest["input_size"].toDouble()) && manifest.contains("input_crc32c")) {
+            options.hasOutputChecksum = true;
+            options.outputCrc32c = manifest["input_crc32c"].toString().toUInt(nullptr, 16);
+        }
+    } else {
+        // Without a manifest the bulk numbers give the order, and a gap means a lost bulk.
+        QMap<int, QString> numbered;
+        const QDir dir(outputDir);
+        for (const QString &name : dir.entryList(QStringList() << prefix + "_*.bin", QDir::Files)) {
+            bool isNumber = false;
+            const int number = name.mid(prefix.size() + 1, name.size() - prefix.size() - 5).toInt(&isNumber);
+            if (isNumber && number > 0) numbered.insert(number, name);
+        }
+        if (numbered.isEmpty()) {
+            emit splitError(QString("No bulks named %1_NNN.bin found in %2").arg(prefix, outputDir));
+            return;
+        }
+        int expected = 1;
+        for (auto it = numbered.constBegin(); it != numbered.constEnd(); ++it, ++expected) {
+            if (it.key() != expected) {
+                emit splitError(QString("Bulk %1 of %2 is missing").arg(expected).arg(prefix));
+                return;
+            }
+            JoinPart part;
+            part.path = QFile::encodeName(outputDir + "/" + it.value()).toStdString();
+            options.parts.push_back(part);
+            names << it.value();
+        }
+    }
+
+    JoinEngine engine(options);
+    engine.setProgress(&m_progress);
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    const bool ok = engine.run();
+    emit statsReported(statsReport(engine.stats(), engine.outputBytes(), elapsed.nsecsElapsed(),
+                                   copyMethodName(engine.copyMethodUsed())));
+    if (!ok) {
+        if (engine.wasCancelled()) {
+            emit splitFinished("Join operation stopped.");
+            return;
+        }
+        QStringList lines;
+        for (const VerifyFailure &failure : engine.failures()) {
+            lines << QString("%1: %2").arg(names[int(failure.file)], QString::fromStdString(failure.reason));
+        }
+        emit splitError(lines.isEmpty() ? QString::fromStdString(engine.errorString())
+                                        : QString("%1 of %2 bulks cannot be joined:\n%3")
+                                              .arg(qint64(lines.size())).arg(qint64(names.size())).arg(lines.join("\n")));
+        return;
+    }
+
+    emit splitFinished(QString("Joined %1 bulks into %2 (%3 bytes, %4).")
+                           .arg(qint64(names.size())).arg(joinedPath).arg(qint64(engine.outputBytes()))
+                           .arg(options.hasOutputChecksum ? "matches the input checksum"
+                                : options.parts.front().hasChecksum ? "bulk checksums verified"
+                                                                    : "no manifest to verify against"));
+#else
+    Q_UNUSED(joinedPath);
+    Q_UNUSED(manifestPath);
+    emit splitError("Joining bulks is not supported on this platform.");
+#endif
+}
+
+namespace {
+
+// Files a split writes next to its input, which a batch over a directory or a
+// pattern must not pick up as captures on its next run.
+bool isSplitOutput(const QString &fileName) {
+    static const char *const suffixes[] = {".part", ".fidx", ".journal", "_manifest.json", "_resync.json"};
+    for (const char *suffix : suffixes) {
+        if (fileName.endsWith(QLatin1String(suffix))) return true;
+    }
+    // Bulks are <prefix>_NNN.bin or .cbin, or chunk_<hash>.bin from a content-defined split
+    if (fileName.startsWith(QLatin1String("chunk_")) && fileName.endsWith(QLatin1String(".bin"))) return true;
+    const int underscore = fileName.lastIndexOf('_');
+    const int dot = fileName.lastIndexOf('.');
+    if (underscore <= 0 || (!fileName.endsWith(QLatin1String(".bin")) && !fileName.endsWith(QLatin1String(".cbin")))) {
+        return false;
+    }
+    const QString number = fileName.mid(underscore + 1, dot - underscore - 1);
+    bool isNumber = false;
+    number.toInt(&isNumber);
+    return isNumber && number.size() >= 3;
+}
+
+} // namespace
+
+QStringList BinarySplitterCore::expandBatchInputs(const QString &spec, QString *error) {
+    QStringList inputs;
+    if (spec.startsWith('@')) {
+        const QString listPath = spec.mid(1);
+        QFile list(listPath);
+        if (!list.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            *error = "Cannot read input list: " + listPath;
+            return inputs;
+        }
+        const QDir base = QFileInfo(listPath).dir();
+        QTextStream lines(&list);
+        while (!lines.atEnd()) {
+            const QString line = lines.readLine().trimmed();
+            if (!line.isEmpty() && !line.startsWith('#')) inputs << QFileInfo(base, line).absoluteFilePath();
+        }
+        return inputs;
+    }
+
+    QDir dir;
+    QStringList patterns;
+    const QFileInfo info(spec);
+    if (info.isDir()) {
+        dir = QDir(spec);
+    } else if (spec.contains('*') || spec.contains('?') || spec.contains('[')) {
+        dir = info.dir();
+        patterns << info.fileName();
+    } else {
+        *error = "Not a directory, pattern or @list: " + spec;
+        return inputs;
+    }
+    for (const QString &name : dir.entryList(patterns, QDir::Files, QDir::Name)) {
+        if (!isSplitOutput(name)) inputs << dir.absoluteFilePath(name);
+    }
+    if (inputs.isEmpty()) *error = "No input files match " + spec;
+    return inputs;
+}
+
+void BinarySplitterCore::splitBatch(const QStringList &inputFilePaths, double bulkSizeGb, int frameSizeBytes,
+                                    const QString &reportPath) {
+#ifdef Q_OS_UNIX
+    ChannelField channelField;
+    std::string fieldError;
+    if (!m_channelField.isEmpty() && !parseChannelField(m_channelField.toStdString(), &channelField, &fieldError)) {
+        emit splitError(QString::fromStdString(fieldError));
+        return;
+    }
+    const qint64 bulkSizeBytes = static_cast<qint64>(bulkSizeGb * 1024 * 1024 * 1024);
+    std::vector<BatchJob> jobs;
+    std::vector<int> frameSizes;
+    QStringList undetected;
+    QSet<QString> outputNames;
+    for (const QString &inputFilePath : inputFilePaths) {
+        const QFileInfo info(inputFilePath);
+        const int frameSize = frameSizeBytes > 0 ? frameSizeBytes : detectFrameSize(inputFilePath, m_syncWordHex);
+        if (frameSize <= 0) {
+            undetected << inputFilePath;
+            continue;
+        }
+        // "a.bin" and "a.dat" in one directory would otherwise write the same bulks.
+        QString prefix = info.baseName();
+        if (outputNames.contains(info.absolutePath() + "/" + prefix)) prefix = info.fileName().replace('.', '_');
+        outputNames.insert(info.absolutePath() + "/" + prefix);
+
+        BatchJob job;
+        job.options = engineOptions(inputFilePath, info.absolutePath(), prefix, bulkSizeBytes, frameSize);
+        jobs.push_back(job);
+        frameSizes.push_back(frameSize);
+    }
+
+    BatchScheduler scheduler(m_batchJobs, m_deviceJobs);
+    scheduler.setJobFinished([this, &frameSizes, &jobs](BatchJob &job, const SplitEngine &engine) {
+        if (!job.ok) return;
+        const QString input = QFile::decodeName(job.options.inputPath.c_str());
+        const QString outputDir = QFile::decodeName(job.options.outputDir.c_str());
+        const QString prefix = QFile::decodeName(job.options.prefix.c_str());
+        const int frameSize = frameSizes[&job - jobs.data()];
+        const QString manifestPath = QString("%1/%2_manifest.json").arg(outputDir, prefix);
+        if ((m_writeManifest || m_chunkAvgBytes > 0) && !writeManifest(manifestPath, input, frameSize, engine)) {
+            job.ok = false;
+            job.error = "Cannot write manifest: " + QFile::encodeName(manifestPath).toStdString();
+        }
+        const QString reportPath = QString("%1/%2_resync.json").arg(outputDir, prefix);
+        if (job.ok && engine.skippedBytes() > 0
+            && !writeSyncGapReport(reportPath, input, frameSize, engine.syncGaps())) {
+            job.ok = false;
+            job.error = "Cannot write resync report: " + QFile::encodeName(reportPath).toStdString();
+        }
+    });
+    QElapsedTimer elapsed;
+    elapsed.start();
+    const bool completed = scheduler.run(jobs, &m_progress);
+    const double seconds = qMax<qint64>(1, elapsed.elapsed()) / 1000.0;
+
+    QJsonArray jobArray;
+    QJsonObject devices;
+    qint64 splitBytes = 0;
+    int succeeded = 0;
+    int failed = undetected.size();
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const BatchJob &job = jobs[i];
+        const double jobSeconds = (job.endNs - job.startNs) / 1e9;
+        QJsonObject entry;
+        entry["input"] = QFile::decodeName(job.options.inputPath.c_str());
+        entry["device"] = QString::fromStdString(job.device);
+        entry["frame_size_bytes"] = frameSizes[i];
+        entry["status"] = job.ok ? "ok" : job.started ? "failed" : "skipped";
+        if (!job.error.empty()) entry["error"] = QString::fromStdString(job.error);
+        entry["input_bytes"] = qint64(job.inputBytes);
+        entry["bulks"] = qint64(job.bulks);
+        entry["seconds"] = jobSeconds;
+        if (jobSeconds > 0) entry["mb_per_s"] = job.inputBytes / (1024.0 * 1024.0) / jobSeconds;
+        jobArray.append(entry);
+
+        if (job.started && !job.ok && job.error != "cancelled") ++failed;
+        if (!job.ok) continue;
+        ++succeeded;
+        splitBytes += job.inputBytes;
+        QJsonObject device = devices[QString::fromStdString(job.device)].toObject();
+        device["files"] = device["files"].toInt() + 1;
+        device["input_bytes"] = device["input_bytes"].toDouble() + job.inputBytes;
+        device["busy_seconds"] = device["busy_seconds"].toDouble() + jobSeconds;
+        devices[QString::fromStdString(job.device)] = device;
+    }
+    for (const QString &input : undetected) {
+        QJsonObject entry;
+        entry["input"] = input;
+        entry["status"] = "failed";
+        entry["error"] = "Frame size detection failed";
+        jobArray.append(entry);
+    }
+
+    QJsonObject report;
+    report["files"] = qint64(inputFilePaths.size());
+    report["succeeded"] = succeeded;
+    report["failed"] = failed;
+    report["cancelled"] = !completed;
+    report["input_bytes"] = splitBytes;
+    report["seconds"] = seconds;
+    report["gb_per_s"] = splitBytes / (1024.0 * 1024.0 * 1024.0) / seconds;
+    report["batch_jobs"] = m_batchJobs;
+    report["device_jobs"] = m_deviceJobs;
+    report["devices"] = devices;
+    report["jobs"] = jobArray;
+    QSaveFile reportFile(reportPath);
+    const bool reportWritten = reportFile.open(QIODevice::WriteOnly)
+                               && reportFile.write(QJsonDocument(report).toJson()) >= 0 && reportFile.commit();
+    const QString reportNote = reportWritten ? "Report: " + reportPath : "Cannot write report: " + reportPath;
+
+    if (!completed) {
+        emit splitFinished(QString("Batch stopped. %1 of %2 files split. %3")
+                               .arg(succeeded).arg(inputFilePaths.size()).arg(reportNote));
+    } else if (failed > 0 || !reportWritten) {
+        emit splitError(QString("%1 of %2 files failed. %3").arg(failed).arg(inputFilePaths.size()).arg(reportNote));
+    } else {
+        emit splitFinished(QString("Batch complete: %1 files, %2 GiB at %3 MiB/s. %4")
+                               .arg(inputFilePaths.size())
+                               .arg(splitBytes / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2)
+                               .arg(splitBytes / (1024.0 * 1024.0) / seconds, 0, 'f', 1)
+                               .arg(reportNote));
+    }
+#else
+    Q_UNUSED(inputFilePaths);
+    Q_UNUSED(bulkSizeGb);
+    Q_UNUSED(frameSizeBytes);
+    Q_UNUSED(reportPath);
+    emit splitError("Batch splitting is not supported on this platform.");
+#endif
+}
+
+#ifdef Q_OS_UNIX
+SplitOptions BinarySplitterCore::engineOptions(const QString &inputFilePath, const QString &outputDir,
+                                               const QString &prefix, qint64 bulkSizeBytes,
+                                               int frameSizeBytes) const {
+    SplitOptions options;
+    options.inputPath = QFile::encodeName(inputFilePath).toStdString();
+    options.outputDir = QFile::encodeName(outputDir).toStdString();
+    options.prefix = QFile::encodeName(prefix).toStdString();
+    options.bulkSizeBytes = bulkSizeBytes;
+    options.frameSizeBytes = frameSizeBytes;
+    options.jobs = m_jobs;
+    options.pipelined = m_pipelined;
+    options.ringDepth = m_ringDepth;
+    options.bufferBytes = static_cast<qint64>(m_bufferSizeKb) * 1024;
+    options.ioBackend = (m_ioBackend == "uring") ? IoBackend::Uring : IoBackend::Posix;
+    options.resync = m_resync;
+    options.syncWord = QByteArray::fromHex(m_syncWordHex.toUtf8()).toStdString();
+    options.writeIndex = m_writeIndex;
+    options.resume = m_resume;
+    options.verifyResumed = m_verifyResumed;
+    options.checksums = m_writeManifest;
+    options.follow = m_follow;
+    options.followIdleSeconds = m_followIdleSeconds;
+    options.directIo = m_directIo;
+    options.sparse = m_sparse;
+    options.extract = m_frameFilter;
+    if (!m_channelField.isEmpty()) {
+        std::string error;
+        parseChannelField(m_channelField.toStdString(), &options.demux, &error);  // Checked before the split
+    }
+    options.demuxMemoryBytes = static_cast<int64_t>(m_demuxMemoryMb) * 1024 * 1024;
+    options.chunking.minBytes = m_chunkMinBytes;
+    options.chunking.avgBytes = m_chunkAvgBytes;
+    options.chunking.maxBytes = m_chunkMaxBytes;
+    options.codec = m_compression.toStdString();
+    options.codecThreads = m_compressThreads;
+    options.transform = m_frameTransform;
+    return options;
+}
+
+// Lists the input ranges dropped while regaining frame lock.
+bool BinarySplitterCore::writeSyncGapReport(const QString &reportPath, const QString &inputFilePath,
+                                            int frameSizeBytes, const std::vector<SyncGap> &gaps) {
+    QJsonArray gapArray;
+    qint64 skippedBytes = 0;
+    for (const SyncGap &gap : gaps) {
+        QJsonObject entry;
+        entry["offset"] = qint64(gap.offset);
+        entry["length"] = qint64(gap.length);
+        gapArray.append(entry);
+        skippedBytes += gap.length;
+    }
+
+    QJsonObject report;
+    report["input"] = inputFilePath;
+    report["frame_size_bytes"] = frameSizeBytes;
+    report["sync_word_hex"] = m_syncWordHex;
+    report["skipped_bytes"] = skippedBytes;
+    report["gaps"] = gapArray;
+
+    QSaveFile file(reportPath);
+    return file.open(QIODevice::WriteOnly) && file.write(QJsonDocument(report).toJson()) >= 0 && file.commit();
+}
+
+// Lists every bulk with its CRC32C, plus the checksum of the whole input, so
+// the output can be checked later with verifyBulks() or any CRC32C tool.
+bool BinarySplitterCore::writeManifest(const QString &manifestPath, const QString &inputFilePath,
+                                       int frameSizeBytes, const SplitEngine &engine) {
+    QJsonArray bulkArray;
+    for (const FinishedBulk &bulk : engine.finishedBulks()) {
+        QJsonObject entry;
+        entry["name"] = QFileInfo(QFile::decodeName(engine.bulkFilePath(bulk.index, bulk.channel).c_str())).fileName();
+        if (bulk.channel >= 0) entry["channel"] = qint64(bulk.channel);
+        entry["offset"] = qint64(bulk.offset);
+        entry["length"] = qint64(bulk.length);
+        // Compressed bulks hold rawLength bytes of the input in a file of length bytes.
+        const qint64 rawLength = bulk.rawLength >= 0 ? bulk.rawLength : bulk.length;
+        if (bulk.rawLength >= 0) entry["raw_length"] = rawLength;
+        entry["frames"] = qint64((rawLength + engine.outputFrameBytes() - 1) / engine.outputFrameBytes());
+        entry["crc32c"] = QString("%1").arg(bulk.crc32c, 8, 16, QChar('0'));
+        if (m_chunkAvgBytes > 0) entry["xxh64"] = QString("%1").arg(engine.chunkHash(bulk.index), 16, 16, QChar('0'));
+        bulkArray.append(entry);
+    }
+
+    QJsonObject manifest;
+    manifest["input"] = inputFilePath;
+    manifest["input_size"] = qint64(engine.inputBytes());
+    // An extraction never reads all of the input, so it has no checksum to record.
+    if (engine.hasInputCrc()) manifest["input_crc32c"] = QString("%1").arg(engine.inputCrc32c(), 8, 16, QChar('0'));
+    manifest["frame_size_bytes"] = frameSizeBytes;
+    manifest["algorithm"] = "crc32c";
+    if (!m_compression.isEmpty()) manifest["codec"] = m_compression;
+    if (m_frameTransform.isActive()) {
+        manifest["frame_transform"] = m_frameTransformSpec;
+        manifest["payload_bytes"] = qint64(engine.outputFrameBytes());
+    }
+    if (m_chunkAvgBytes > 0) {
+        QJsonObject chunking;
+        chunking["min_bytes"] = m_chunkMinBytes;
+        chunking["avg_bytes"] = m_chunkAvgBytes;
+        chunking["max_bytes"] = m_chunkMaxBytes;
+        manifest["chunking"] = chunking;
+    }
+    manifest["bulks"] = bulkArray;
+
+    QSaveFile file(manifestPath);
+    return file.open(QIODevice::WriteOnly) && file.write(QJsonDocument(manifest).toJson()) >= 0 && file.commit();
+}
+#endif
+
+// Per-stage totals of the engine. Stage seconds are summed over all threads,
+// so with --jobs or a pipeline they can add up to more than the wall time.
+QJsonObject BinarySplitterCore::statsReport(const SplitStats &stats, qint64 inputBytes, qint64 elapsedNs,
+                                            const QString &ioBackend) {
+    QJsonObject stages;
+    for (int i = 0; i < static_cast<int>(SplitStage::Count); ++i) {
+        const SplitStage stage = static_cast<SplitStage>(i);
+        if (stats.calls(stage) == 0) continue;
+        QJsonObject entry;
+        const double seconds = stats.nanos(stage) / 1e9;
+        entry["seconds"] = seconds;
+        entry["bytes"] = qint64(stats.bytes(stage));
+        entry["calls"] = qint64(stats.calls(stage));
+        if (seconds > 0 && stats.bytes(stage) > 0) entry["mb_per_s"] = stats.bytes(stage) / (1024.0 * 1024.0) / seconds;
+        stages[splitStageName(stage)] = entry;
+    }
+
+    QJsonArray histogram;
+    int lastBucket = -1;
+    for (int i = 0; i < SplitStats::kLatencyBuckets; ++i) {
+        if (stats.latencyBucket(i) > 0) lastBucket = i;
+    }
+    for (int i = 0; i <= lastBucket; ++i) {
+        QJsonObject bucket;
+        bucket["below_ms"] = qint64(1) << i;
+        bucket["count"] = qint64(stats.latencyBucket(i));
+        histogram.append(bucket);
+    }
+    QJsonObject bulks;
+    bulks["count"] = qint64(stats.bulkCount());
+    bulks["latency_avg_ms"] = stats.bulkCount() > 0 ? stats.bulkLatencySumNs() / 1e6 / stats.bulkCount() : 0.0;
+    bulks["latency_max_ms"] = stats.bulkLatencyMaxNs() / 1e6;
+    bulks["latency_histogram"] = histogram;
+
+    const double seconds = elapsedNs / 1e9;
+    QJsonObject report;
+    report["seconds"] = seconds;
+    report["input_bytes"] = inputBytes;
+    report["gb_per_s"] = seconds > 0 ? inputBytes / (1024.0 * 1024.0 * 1024.0) / seconds : 0.0;
+    report["io_backend"] = ioBackend;
+    report["stages"] = stages;
+    report["bulks"] = bulks;
+    return report;
+}
+
+// Portable buffered fallback for platforms without the POSIX engine, also used
+// for the "qt" I/O backend. Each bulk is
+// copied in runs of whole frames through one reused buffer, so the loop neither
+// allocates nor issues a write per frame.
+void BinarySplitterCore::splitWithQFile(const QString &inputFilePath, qint64 bulkSizeBytes,
+                                        int frameSizeBytes, const QString &outputDir,
+                                        const QString &prefix) {
+    if (frameSizeBytes <= 0) {
+        emit splitError(QString("Invalid frame size: %1").arg(frameSizeBytes));
+        return;
+    }
 
     QFile inFile(inputFilePath);
-    if (!inFile.open(QIODevice::ReadOnly)) {
+    if (!inFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
         emit splitError("Input file not found: " + inputFilePath);
         return;
     }
 
-    qint64 totalSize = inFile.size();
+    // Largest run of whole frames that fits into about 1MB
+    const qint64 spanSize = qMax<qint64>(1, (1024 * 1024) / frameSizeBytes) * frameSizeBytes;
+    const qint64 totalSize = inFile.size();
+    const std::vector<BulkRange> plan = planBulks(totalSize, bulkSizeBytes, frameSizeBytes);
+    QByteArray buffer(spanSize, Qt::Uninitialized);
     qint64 bytesProcessed = 0;
-    QFile *outFile = nullptr;
-    int lastPercentage = -1;
-    QByteArray buffer;
+    SplitStats stats;
+    QElapsedTimer elapsed;
+    elapsed.start();
 
-    while (!inFile.atEnd()) {
-        if (m_stopFlag) {
-            emit splitFinished("Split operation stopped.");
-            if (outFile) delete outFile;
+    for (const BulkRange &bulk : plan) {
+        QString outPath = QString("%1/%2_%3.bin").arg(outputDir, prefix).arg(bulk.index, 3, 10, QChar('0'));
+        // QSaveFile writes to a temporary file and only renames it on commit(),
+        // so a stopped or failed split never leaves a truncated bulk behind.
+        const qint64 openedNs = SplitStats::nowNs();
+        QSaveFile outFile(outPath);
+        bool opened;
+        {
+            StageTimer timer(stats, SplitStage::Open);
+            opened = outFile.open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+        }
+        if (!opened) {
+            emit splitError("Cannot create output file: " + outPath);
             return;
         }
 
-        // Read a large chunk
-        buffer = inFile.read(bufferSize);
-        if (buffer.isEmpty()) break;
-
-        qint64 offset = 0;
-        while (offset < buffer.size()) {
-            qint64 remaining = buffer.size() - offset;
-            qint64 bytesToProcess = qMin(remaining, static_cast<qint64>(frameSizeBytes));
-            QByteArray frameData = buffer.mid(offset, bytesToProcess);
-
-            if (!outFile || (currentBulkSize + frameData.length() > bulkSizeBytes)) {
-                if (outFile) {
-                    outFile->close();
-                    delete outFile;
-                }
-                QString outPath = QString("%1/%2_%3.bin").arg(outputDir, prefix).arg(bulkCount++, 3, 10, QChar('0'));
-                outFile = new QFile(outPath);
-                if (!outFile->open(QIODevice::WriteOnly)) {
-                    emit splitError("Cannot create output file: " + outPath);
-                    delete outFile;
-                    return;
-                }
-                currentBulkSize = 0;
+        // Bulks start on a frame boundary, so every span is a run of whole frames.
+        for (qint64 written = 0; written < bulk.length;) {
+            if (m_progress.cancelRequested()) {
+                emit statsReported(statsReport(stats, bytesProcessed, elapsed.nsecsElapsed(), "qt"));
+                emit splitFinished("Split operation stopped.");
+                return;
             }
 
-            outFile->write(frameData);
-            currentBulkSize += frameData.length();
-            bytesProcessed += frameData.length();
-            offset += frameData.length();
-
-            if (totalSize > 0) {
-                int percentage = static_cast<int>((bytesProcessed * 100) / totalSize);
-                if (percentage > lastPercentage) {
-                    emit progressUpdated(percentage);
-                    lastPercentage = percentage;
-                }
+            const qint64 span = qMin(spanSize, bulk.length - written);
+            qint64 got;
+            {
+                StageTimer timer(stats, SplitStage::Read, span);
+                got = inFile.read(buffer.data(), span);
+            }
+            if (got != span) {
+                emit splitError("Failed to read input file: " + inputFilePath);
+                return;
+            }
+            qint64 put;
+            {
+                StageTimer timer(stats, SplitStage::Write, span);
+                put = outFile.write(buffer.constData(), span);
             }
+            if (put != span) {
+                emit splitError("Failed to write output file: " + outPath);
+                return;
+            }
+            written += span;
+            bytesProcessed += span;
+            m_progress.publish(bytesProcessed, totalSize);
         }
-
-        QCoreApplication::processEvents(); // Process events to handle stopOperation
+        bool committed;
+        {
+            StageTimer timer(stats, SplitStage::Close);
+            committed = outFile.commit();
+        }
+        if (!committed) {
+            emit splitError("Failed to write output file: " + outPath);
+            return;
+        }
+        stats.addBulkLatency(SplitStats::nowNs() - openedNs);
     }
 
-    if (outFile) {
-        outFile->close();
-        delete outFile;
-    }
+    emit statsReported(statsReport(stats, bytesProcessed, elapsed.nsecsElapsed(), "qt"));
     emit splitFinished("Binary file splitting complete.");
 }
 
 void BinarySplitterCore::stopOperation() {
-    m_stopFlag = true;
+    m_progress.requestCancel();
     emit stopRequested();
 }
 
 void BinarySplitterCore::resetStopFlag() {
-    m_stopFlag = false; // Reset the stop flag for a new operation
+    m_progress.reset();
+}
+
+void BinarySplitterCore::setJobs(int jobs) {
+    m_jobs = qMax(1, jobs);
+}
+
+void BinarySplitterCore::setPipelined(bool pipelined) {
+    m_pipelined = pipelined;
+}
+
+void BinarySplitterCore::setRingDepth(int depth) {
+    m_ringDepth = qBound(2, depth, 256);
+}
+
+void BinarySplitterCore::setBufferSizeKb(int sizeKb) {
+    m_bufferSizeKb = qBound(4, sizeKb, 256 * 1024);
+}
+
+void BinarySplitterCore::setIoBackend(const QString &backend) {
+    if (backend == "posix" || backend == "uring" || backend == "qt") {
+        m_ioBackend = backend;
+    }
+}
+
+void BinarySplitterCore::setResync(bool resync) {
+    m_resync = resync;
+}
+
+void BinarySplitterCore::setResume(bool resume) {
+    m_resume = resume;
+}
+
+void BinarySplitterCore::setVerifyResumed(bool verify) {
+    m_verifyResumed = verify;
+}
+
+void BinarySplitterCore::setWriteManifest(bool writeManifest) {
+    m_writeManifest = writeManifest;
+}
+
+void BinarySplitterCore::setFollow(bool follow) {
+    m_follow = follow;
+}
+
+void BinarySplitterCore::setFollowIdleSeconds(int seconds) {
+    m_followIdleSeconds = qMax(0, seconds);
+}
+
+void BinarySplitterCore::setBatchJobs(int jobs) {
+    m_batchJobs = qMax(1, jobs);
+}
+
+void BinarySplitterCore::setDeviceJobs(int jobs) {
+    m_deviceJobs = qMax(1, jobs);
+}
+
+void BinarySplitterCore::setDirectIo(bool directIo) {
+    m_directIo = directIo;
+}
+
+void BinarySplitterCore::setSparse(bool sparse) {
+    m_sparse = sparse;
+}
+
+void BinarySplitterCore::setFrameFilter(qint64 firstFrame, qint64 endFrame, qint64 everyNth,
+                                        const QStringList &headerPredicates) {
+    FrameFilter filter;
+    filter.firstFrame = qMax<qint64>(0, firstFrame);
+    filter.endFrame = endFrame;
+    filter.everyNth = qMax<qint64>(1, everyNth);
+    for (const QString &text : headerPredicates) {
+        HeaderPredicate predicate;
+        std::string error;
+        if (!parseHeaderPredicate(text.toStdString(), &predicate, &error)) {
+            emit splitError(QString::fromStdString(error));
+            return;
+        }
+        filter.predicates.push_back(predicate);
+    }
+    m_frameFilter = filter;
+}
+
+void BinarySplitterCore::setChannelField(const QString &spec) {
+    m_channelField = spec;
+}
+
+void BinarySplitterCore::setDemuxMemoryMb(int memoryMb) {
+    m_demuxMemoryMb = qMax(1, memoryMb);
+}
+
+void BinarySplitterCore::setCompression(const QString &codec) {
+    m_compression = codec;
+}
+
+void BinarySplitterCore::setCompressThreads(int threads) {
+    m_compressThreads = qMax(0, threads);
+}
+
+void BinarySplitterCore::setFrameTransform(const QString &spec) {
+    FrameTransform transform;
+    std::string error;
+    if (!spec.isEmpty() && !parseFrameTransform(spec.toStdString(), &transform, &error)) {
+        emit splitError(QString::fromStdString(error));
+        return;
+    }
+    m_frameTransformSpec = spec;
+    m_frameTransform = transform;
+}
+
+void BinarySplitterCore::setChunking(qint64 minBytes, qint64 avgBytes, qint64 maxBytes) {
+    m_chunkAvgBytes = qMax<qint64>(0, avgBytes);
+    m_chunkMinBytes = qBound<qint64>(0, minBytes, m_chunkAvgBytes);
+    m_chunkMaxBytes = qMax(maxBytes, m_chunkAvgBytes);
+}
+
+void BinarySplitterCore::setWriteIndex(bool writeIndex) {
+    m_writeIndex = writeIndex;
+}
+
+void BinarySplitterCore::setSyncWord(const QString &syncWordHex) {
+    if (!QByteArray::fromHex(syncWordHex.toUtf8()).isEmpty()) {
+        m_syncWordHex = syncWordHex;
+    }
 }
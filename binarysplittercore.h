@@ -3,6 +3,18 @@
 
 #include <QObject>
 #include <QJsonObject>
+#include <QStringList>
+#include "frameextract.h"
+#include "frametransform.h"
+#include "splitprogress.h"
+#ifdef Q_OS_UNIX
+#include <vector>
+#include "framesync.h"
+class SplitEngine;
+struct SplitOptions;
+#endif
+
+class SplitStats;
 
 class BinarySplitterCore : public QObject {
     Q_OBJECT
@@ -12,21 +24,125 @@ public:
     Q_INVOKABLE QJsonObject loadConfigDefaults(const QString &configFilePath = "config.json");
     Q_INVOKABLE int detectFrameSize(const QString &inputFilePath, const QString &syncWordHex,
                                     int searchChunkSize = 4096, int maxFrameSizeGuess = 65536);
+    // Like detectFrameSize, but also reports how well the capture follows the
+    // detected period: frame_size, confidence, lock_ratio, sync_count, windows.
+    Q_INVOKABLE QJsonObject analyzeFrameSize(const QString &inputFilePath, const QString &syncWordHex,
+                                             int searchChunkSize = 4096, int maxFrameSizeGuess = 65536);
     Q_INVOKABLE void splitBinaryFile(const QString &inputFilePath, double bulkSizeGb,
                                      int frameSizeBytes, const QString &outputPrefix = "output_bulk");
+    // Re-hashes the bulks listed in the manifest of an earlier split of
+    // inputFilePath, m_jobs files at a time, and reports the result through
+    // splitFinished() or splitError().
+    Q_INVOKABLE void verifyBulks(const QString &inputFilePath, const QString &outputPrefix = "output_bulk");
+    // Reassembles an earlier split of inputFilePath into outputFilePath (the
+    // input path itself when empty), m_jobs pieces at a time. The manifest,
+    // when present, names the bulks and their checksums; otherwise every
+    // <prefix>_NNN.bin is joined in order. Refuses to overwrite an existing file.
+    Q_INVOKABLE void joinBulks(const QString &inputFilePath, const QString &outputPrefix = "output_bulk",
+                               const QString &outputFilePath = QString());
+    // Splits every input with the current settings, m_batchJobs at a time and
+    // limited per disk, then writes one JSON summary to reportPath. Each input
+    // gets its own prefix and frame size detection when frameSizeBytes <= 0.
+    Q_INVOKABLE void splitBatch(const QStringList &inputFilePaths, double bulkSizeGb, int frameSizeBytes,
+                                const QString &reportPath);
+
+    // Inputs named by a directory, a wildcard pattern or "@list" (one path per
+    // line, relative to the list). Bulks and sidecars of earlier splits are left out.
+    static QStringList expandBatchInputs(const QString &spec, QString *error);
+
+    // Position of the running split or verification. Safe to sample from any
+    // thread; the UI polls it on a timer instead of receiving a signal per step.
+    const SplitProgress &progress() const { return m_progress; }
 
 signals:
-    void progressUpdated(int percentage);
+    // Per-stage timings of the engine, sent once a split has ended.
+    void statsReported(const QJsonObject &stats);
     void splitFinished(const QString &message);
     void splitError(const QString &error);
     void stopRequested();
 
 public slots:
+    // Both are thread-safe and meant to be called directly from the UI thread:
+    // a queued call would wait behind the operation it is meant to stop.
     void stopOperation();
-    void resetStopFlag();  // New slot to reset the stop flag
+    void resetStopFlag();  // Clears the stop request and the progress counters
+    void setJobs(int jobs);  // Bulks written concurrently by the next split
+    void setPipelined(bool pipelined);  // Overlap reads and writes through a buffer ring
+    void setRingDepth(int depth);
+    void setBufferSizeKb(int sizeKb);
+    void setIoBackend(const QString &backend);  // "posix", "uring" or "qt"
+    void setResync(bool resync);  // Cut only at validated sync words, skipping corruption
+    void setSyncWord(const QString &syncWordHex);
+    void setWriteIndex(bool writeIndex);  // Write a .fidx frame index next to the input
+    void setResume(bool resume);  // Journal bulks and continue an interrupted split
+    void setVerifyResumed(bool verify);  // Re-hash kept bulks instead of trusting their size and time
+    void setWriteManifest(bool writeManifest);  // Checksum the bulks and write <prefix>_manifest.json
+    void setFollow(bool follow);  // Split a still-growing file as data arrives
+    void setFollowIdleSeconds(int seconds);  // Stop following after this long without growth; 0 never
+    void setBatchJobs(int jobs);  // Inputs split concurrently by splitBatch()
+    void setDeviceJobs(int jobs);  // Concurrent inputs per SSD; rotational disks always take one
+    void setDirectIo(bool directIo);  // Bypass the page cache for planned splits
+    void setSparse(bool sparse);  // Leave holes and all-zero frames of the input as holes in the bulks
+    // Keeps only every everyNth frame of [firstFrame, endFrame) whose header
+    // matches all predicates ("<offset>=<hex>[/<mask>]"); endFrame -1 runs to the end.
+    void setFrameFilter(qint64 firstFrame, qint64 endFrame, qint64 everyNth, const QStringList &headerPredicates);
+    // Routes each frame to a bulk series of its own channel, read from the header
+    // field "<offset>[/<mask>]"; an empty spec turns demultiplexing off.
+    void setChannelField(const QString &spec);
+    void setDemuxMemoryMb(int memoryMb);  // Write-combining budget shared by all channels
+    // Cuts bulks where the content says, between minBytes and maxBytes and about
+    // avgBytes apart, and skips bulks already in the output directory; the
+    // manifest is always written. avgBytes 0 returns to fixed-size bulks.
+    void setChunking(qint64 minBytes, qint64 avgBytes, qint64 maxBytes);
+    // Writes each bulk as <prefix>_NNN.cbin, compressed in independent blocks
+    // with "lz" or, where built in, "zstd"; an empty name writes raw bulks.
+    void setCompression(const QString &codec);
+    void setCompressThreads(int threads);  // Threads compressing blocks; 0 uses one per CPU
+    // Writes only the payload of each frame, e.g. "strip=sync,swap=16"; see
+    // parseFrameTransform(). An empty spec writes whole frames.
+    void setFrameTransform(const QString &spec);
 
 private:
-    bool m_stopFlag;
+    void splitWithQFile(const QString &inputFilePath, qint64 bulkSizeBytes, int frameSizeBytes,
+                        const QString &outputDir, const QString &prefix);
+#ifdef Q_OS_UNIX
+    bool writeSyncGapReport(const QString &reportPath, const QString &inputFilePath,
+                            int frameSizeBytes, const std::vector<SyncGap> &gaps);
+    bool writeManifest(const QString &manifestPath, const QString &inputFilePath, int frameSizeBytes,
+                       const SplitEngine &engine);
+    SplitOptions engineOptions(const QString &inputFilePath, const QString &outputDir, const QString &prefix,
+                               qint64 bulkSizeBytes, int frameSizeBytes) const;
+#endif
+    QJsonObject statsReport(const SplitStats &stats, qint64 inputBytes, qint64 elapsedNs, const QString &ioBackend);
+
+    SplitProgress m_progress;
+    int m_jobs;
+    bool m_pipelined;
+    int m_ringDepth;
+    int m_bufferSizeKb;
+    QString m_ioBackend;
+    bool m_resync;
+    QString m_syncWordHex;
+    bool m_writeIndex;
+    bool m_resume;
+    bool m_verifyResumed;
+    bool m_writeManifest;
+    bool m_follow;
+    int m_followIdleSeconds;
+    int m_batchJobs;
+    int m_deviceJobs;
+    bool m_directIo;
+    bool m_sparse;
+    FrameFilter m_frameFilter;
+    QString m_channelField;
+    int m_demuxMemoryMb;
+    qint64 m_chunkMinBytes;
+    qint64 m_chunkAvgBytes;
+    qint64 m_chunkMaxBytes;
+    QString m_compression;
+    int m_compressThreads;
+    QString m_frameTransformSpec;
+    FrameTransform m_frameTransform;
 };
 
 #endif // BINARYSPLITTERCORE_H
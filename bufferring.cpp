@@ -0,0 +1,111 @@
+#include "bufferring.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Page alignment keeps the buffers usable for O_DIRECT and avoids false sharing.
+const size_t kBufferAlignment = 4096;
+
+size_t alignUp(size_t bytes) {
+    return (bytes + kBufferAlignment - 1) / kBufferAlignment * kBufferAlignment;
+}
+}
+
+BufferPool::~BufferPool() {
+    for (const std::pair<size_t, char *> &block : m_free) std::free(block.second);
+}
+
+char *BufferPool::acquire(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_free.size(); ++i) {
+            if (m_free[i].first != bytes) continue;
+            char *block = m_free[i].second;
+            m_free[i] = m_free.back();
+            m_free.pop_back();
+            return block;
+        }
+    }
+    void *memory = nullptr;
+    if (posix_memalign(&memory, kBufferAlignment, bytes) != 0) throw std::bad_alloc();
+    return static_cast<char *>(memory);
+}
+
+void BufferPool::release(char *block, size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.emplace_back(bytes, block);
+}
+
+BufferRing::BufferRing(int depth, size_t bufferBytes, size_t headroomBytes, BufferPool *pool)
+    : m_slots(static_cast<size_t>(std::max(depth, 2))), m_bufferBytes(std::max<size_t>(bufferBytes, 1)),
+      m_headroomBytes(alignUp(headroomBytes)), m_pool(pool) {
+    const size_t stride = m_headroomBytes + alignUp(m_bufferBytes);
+    m_memoryBytes = stride * m_slots.size();
+    if (m_pool) {
+        m_memory = m_pool->acquire(m_memoryBytes);
+    } else {
+        void *memory = nullptr;
+        if (posix_memalign(&memory, kBufferAlignment, m_memoryBytes) != 0) throw std::bad_alloc();
+        m_memory = static_cast<char *>(memory);
+    }
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        m_slots[i] = {m_memory + i * stride + m_headroomBytes, 0, 0};
+    }
+}
+
+BufferRing::~BufferRing() {
+    if (m_pool) {
+        m_pool->release(m_memory, m_memoryBytes);
+    } else {
+        std::free(m_memory);
+    }
+}
+
+BufferRing::Slot *BufferRing::beginWrite() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_canWrite.wait(lock, [this] { return m_cancelled || m_filled < m_slots.size(); });
+    return m_cancelled ? nullptr : &m_slots[m_head];
+}
+
+void BufferRing::endWrite() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_head = (m_head + 1) % m_slots.size();
+        ++m_filled;
+    }
+    m_canRead.notify_one();
+}
+
+void BufferRing::finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
+    }
+    m_canRead.notify_one();
+}
+
+BufferRing::Slot *BufferRing::beginRead() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_canRead.wait(lock, [this] { return m_cancelled || m_filled > 0 || m_finished; });
+    return (m_cancelled || m_filled == 0) ? nullptr : &m_slots[m_tail];
+}
+
+void BufferRing::endRead() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tail = (m_tail + 1) % m_slots.size();
+        --m_filled;
+    }
+    m_canWrite.notify_one();
+}
+
+void BufferRing::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = true;
+    }
+    m_canRead.notify_all();
+    m_canWrite.notify_all();
+}
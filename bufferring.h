@@ -0,0 +1,83 @@
+#ifndef BUFFERRING_H
+#define BUFFERRING_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Page-aligned blocks that are kept for reuse once released. Batch jobs take
+// their buffers from one pool, so each split after the first runs on memory
+// that is already allocated and faulted in, and the total stays bounded by the
+// number of jobs running at once. Thread-safe.
+class BufferPool {
+public:
+    BufferPool() = default;
+    ~BufferPool();
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    char *acquire(size_t bytes);  // Throws std::bad_alloc
+    void release(char *block, size_t bytes);
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::pair<size_t, char *>> m_free;
+};
+
+// Fixed ring of preallocated buffers shared by one producer and one consumer.
+// Slots are handed out strictly in order, so the consumer sees the data in the
+// order it was produced and no memory is allocated after construction. Each slot
+// can reserve headroom in front of its data, where the consumer may place bytes
+// carried over from the previous slot to make them contiguous with the new ones.
+class BufferRing {
+public:
+    struct Slot {
+        char *data;
+        size_t size;     // Valid bytes in data
+        int64_t offset;  // Input offset of data[0]
+    };
+
+    // With a pool, the buffers are borrowed from it and returned on destruction.
+    BufferRing(int depth, size_t bufferBytes, size_t headroomBytes = 0, BufferPool *pool = nullptr);
+    ~BufferRing();
+    BufferRing(const BufferRing &) = delete;
+    BufferRing &operator=(const BufferRing &) = delete;
+
+    int depth() const { return static_cast<int>(m_slots.size()); }
+    size_t bufferBytes() const { return m_bufferBytes; }
+    size_t headroomBytes() const { return m_headroomBytes; }
+
+    // Producer side: waits for an empty slot, fills it, then publishes it.
+    // Returns nullptr once the ring has been cancelled.
+    Slot *beginWrite();
+    void endWrite();
+    void finish();  // No more slots will be published
+
+    // Consumer side: waits for the next filled slot, then hands it back.
+    // Returns nullptr once finished and drained, or when cancelled.
+    Slot *beginRead();
+    void endRead();
+
+    void cancel();  // Wakes both sides; used on errors and stop requests
+
+private:
+    std::vector<Slot> m_slots;
+    size_t m_bufferBytes;
+    size_t m_headroomBytes;
+    BufferPool *m_pool;
+    size_t m_memoryBytes;
+    char *m_memory;
+    size_t m_head = 0;    // Next slot to fill
+    size_t m_tail = 0;    // Next slot to drain
+    size_t m_filled = 0;  // Slots published and not yet drained
+    bool m_finished = false;
+    bool m_cancelled = false;
+    std::mutex m_mutex;
+    std::condition_variable m_canWrite;
+    std::condition_variable m_canRead;
+};
+
+#endif // BUFFERRING_H
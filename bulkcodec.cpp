@@ -0,0 +1,221 @@
+#include "bulkcodec.h"
+
+#include <algorithm>
+#include <cstring>
+#ifdef SPLITTER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+// Byte-aligned LZ77 in the manner of LZ4. A block is a series of sequences:
+//   token      high nibble literal count, low nibble match length - 4; 15 in
+//              either means more follows as bytes of 255 ended by a smaller one
+//   literals   copied as they are
+//   offset     2 bytes little-endian, 1 to 65535 back into the output
+// The last sequence has literals only and ends where the input ends.
+// Matches are found through one hash table slot per 4-byte prefix, and on
+// data that does not match the search skips ahead faster and faster, so
+// incompressible blocks cost little more than a copy.
+class LzCodec : public BulkCodec {
+public:
+    uint32_t id() const override { return 1; }
+    const char *name() const override { return "lz"; }
+    size_t bound(size_t size) const override { return size + size / 255 + 16; }
+    size_t compress(const char *src, size_t size, char *dst, size_t capacity) const override;
+    bool decompress(const char *src, size_t size, char *dst, size_t rawSize) const override;
+};
+
+const int kLzHashBits = 14;
+const size_t kLzMinMatch = 4;
+const size_t kLzMaxOffset = 65535;
+const size_t kLzLastLiterals = 5;    // The block always ends in this many literals
+const size_t kLzMatchSearchEnd = 12;  // No match starts this close to the end
+
+inline uint32_t load32(const unsigned char *p) {
+    uint32_t word;
+    std::memcpy(&word, p, 4);
+    return word;
+}
+
+inline uint32_t lzHash(uint32_t word) {
+    return (word * 2654435761u) >> (32 - kLzHashBits);
+}
+
+// Appends a length beyond the nibble as 255s and a final byte.
+inline bool putLength(unsigned char *&op, const unsigned char *end, size_t length) {
+    for (; length >= 255; length -= 255) {
+        if (op >= end) return false;
+        *op++ = 255;
+    }
+    if (op >= end) return false;
+    *op++ = static_cast<unsigned char>(length);
+    return true;
+}
+
+inline bool getLength(const unsigned char *&ip, const unsigned char *end, size_t *length) {
+    unsigned char byte;
+    do {
+        if (ip >= end) return false;
+        byte = *ip++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+size_t LzCodec::compress(const char *source, size_t size, char *dest, size_t capacity) const {
+    if (size < kLzMatchSearchEnd + 1) return 0;
+    const unsigned char *src = reinterpret_cast<const unsigned char *>(source);
+    unsigned char *op = reinterpret_cast<unsigned char *>(dest);
+    // Never more than the raw size: a block that does not shrink is stored.
+    const unsigned char *opEnd = op + std::min(capacity, size - 1);
+    const size_t searchEnd = size - kLzMatchSearchEnd;
+    const size_t matchEnd = size - kLzLastLiterals;
+    uint32_t table[1 << kLzHashBits] = {};
+
+    // Emits anchor..ip as literals followed by a match, or only the literals
+    // when matchLength is 0.
+    const auto emit = [&](size_t anchor, size_t ip, size_t offset, size_t matchLength) {
+        const size_t literals = ip - anchor;
+        if (op >= opEnd) return false;
+        unsigned char *token = op++;
+        *token = static_cast<unsigned char>(std::min<size_t>(literals, 15) << 4);
+        if (literals >= 15 && !putLength(op, opEnd, literals - 15)) return false;
+        if (literals > static_cast<size_t>(opEnd - op)) return false;
+        std::memcpy(op, src + anchor, literals);
+        op += literals;
+        if (matchLength == 0) return true;
+        if (opEnd - op < 2) return false;
+        *op++ = static_cast<unsigned char>(offset);
+        *op++ = static_cast<unsigned char>(offset >> 8);
+        const size_t extra = matchLength - kLzMinMatch;
+        *token |= static_cast<unsigned char>(std::min<size_t>(extra, 15));
+        return extra < 15 || putLength(op, opEnd, extra - 15);
+    };
+
+    size_t anchor = 0;
+    size_t ip = 1;
+    while (ip < searchEnd) {
+        const uint32_t word = load32(src + ip);
+        const uint32_t slot = lzHash(word);
+        const size_t ref = table[slot];
+        table[slot] = static_cast<uint32_t>(ip);
+        if (ref >= ip || ip - ref > kLzMaxOffset || load32(src + ref) != word) {
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+        size_t start = ip;
+        size_t from = ref;
+        while (start > anchor && from > 0 && src[start - 1] == src[from - 1]) {
+            --start;
+            --from;
+        }
+        size_t end = ip + kLzMinMatch;
+        while (end + 8 <= matchEnd) {
+            uint64_t a, b;
+            std::memcpy(&a, src + end, 8);
+            std::memcpy(&b, src + end - (ip - ref), 8);
+            if (a != b) {
+                end += static_cast<size_t>(__builtin_ctzll(a ^ b)) >> 3;
+                break;
+            }
+            end += 8;
+        }
+        while (end < matchEnd && src[end] == src[end - (ip - ref)]) ++end;
+        if (!emit(anchor, start, ip - ref, end - start)) return 0;
+        anchor = ip = end;
+        if (ip - 2 < searchEnd) table[lzHash(load32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+    }
+    if (!emit(anchor, size, 0, 0)) return 0;
+    return static_cast<size_t>(op - reinterpret_cast<unsigned char *>(dest));
+}
+
+bool LzCodec::decompress(const char *source, size_t size, char *dest, size_t rawSize) const {
+    const unsigned char *ip = reinterpret_cast<const unsigned char *>(source);
+    const unsigned char *const ipEnd = ip + size;
+    unsigned char *op = reinterpret_cast<unsigned char *>(dest);
+    unsigned char *const opStart = op;
+    unsigned char *const opEnd = op + rawSize;
+    for (;;) {
+        if (ip >= ipEnd) return false;
+        const unsigned token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !getLength(ip, ipEnd, &literals)) return false;
+        if (literals > static_cast<size_t>(ipEnd - ip) || literals > static_cast<size_t>(opEnd - op)) return false;
+        std::memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == ipEnd) return op == opEnd;
+
+        if (ipEnd - ip < 2) return false;
+        const size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        size_t length = token & 15;
+        if (length == 15 && !getLength(ip, ipEnd, &length)) return false;
+        length += kLzMinMatch;
+        if (offset == 0 || offset > static_cast<size_t>(op - opStart) || length > static_cast<size_t>(opEnd - op)) {
+            return false;
+        }
+        // An overlapping match repeats its first offset bytes; once those are
+        // out, every copy can take twice as much as the one before.
+        const unsigned char *match = op - offset;
+        if (offset >= length) {
+            std::memcpy(op, match, length);
+        } else {
+            std::memcpy(op, match, offset);
+            for (size_t copied = offset; copied < length; copied *= 2) {
+                std::memcpy(op + copied, op, std::min(copied, length - copied));
+            }
+        }
+        op += length;
+    }
+}
+
+#ifdef SPLITTER_HAVE_ZSTD
+// Contexts are reused per thread; allocating one per block would cost more
+// than compressing a small block.
+class ZstdCodec : public BulkCodec {
+public:
+    uint32_t id() const override { return 2; }
+    const char *name() const override { return "zstd"; }
+    size_t bound(size_t size) const override { return ZSTD_compressBound(size); }
+
+    size_t compress(const char *src, size_t size, char *dst, size_t capacity) const override {
+        thread_local std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx *)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+        const size_t packed = ZSTD_compressCCtx(context.get(), dst, capacity, src, size, 3);
+        return ZSTD_isError(packed) || packed >= size ? 0 : packed;
+    }
+
+    bool decompress(const char *src, size_t size, char *dst, size_t rawSize) const override {
+        thread_local std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx *)> context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+        const size_t restored = ZSTD_decompressDCtx(context.get(), dst, rawSize, src, size);
+        return !ZSTD_isError(restored) && restored == rawSize;
+    }
+};
+#endif
+
+} // namespace
+
+std::unique_ptr<BulkCodec> createBulkCodec(const std::string &name) {
+    if (name == "lz") return std::unique_ptr<BulkCodec>(new LzCodec);
+#ifdef SPLITTER_HAVE_ZSTD
+    if (name == "zstd") return std::unique_ptr<BulkCodec>(new ZstdCodec);
+#endif
+    return nullptr;
+}
+
+std::unique_ptr<BulkCodec> createBulkCodec(uint32_t id) {
+    for (const std::string &name : bulkCodecNames()) {
+        std::unique_ptr<BulkCodec> codec = createBulkCodec(name);
+        if (codec->id() == id) return codec;
+    }
+    return nullptr;
+}
+
+std::vector<std::string> bulkCodecNames() {
+#ifdef SPLITTER_HAVE_ZSTD
+    return {"lz", "zstd"};
+#else
+    return {"lz"};
+#endif
+}
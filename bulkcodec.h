@@ -0,0 +1,35 @@
+#ifndef BULKCODEC_H
+#define BULKCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Compresses independent blocks of a bulk. Implementations keep no state
+// between calls and are safe to use from several threads at once.
+class BulkCodec {
+public:
+    virtual ~BulkCodec() = default;
+
+    // Stored in compressed bulks, so a reader finds the codec again; never reused.
+    virtual uint32_t id() const = 0;
+    virtual const char *name() const = 0;
+
+    // Largest output compress() may need for size input bytes.
+    virtual size_t bound(size_t size) const = 0;
+    // Returns the compressed size, or 0 when the block would not shrink, in
+    // which case the caller stores it raw.
+    virtual size_t compress(const char *src, size_t size, char *dst, size_t capacity) const = 0;
+    // Restores exactly rawSize bytes; false when src is corrupt.
+    virtual bool decompress(const char *src, size_t size, char *dst, size_t rawSize) const = 0;
+};
+
+// "lz" is built in; "zstd" exists when the build found libzstd. Null for
+// other names and ids.
+std::unique_ptr<BulkCodec> createBulkCodec(const std::string &name);
+std::unique_ptr<BulkCodec> createBulkCodec(uint32_t id);
+std::vector<std::string> bulkCodecNames();
+
+#endif // BULKCODEC_H
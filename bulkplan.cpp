@@ -0,0 +1,16 @@
+#include "bulkplan.h"
+
+#include <algorithm>
+
+std::vector<BulkRange> planBulks(int64_t totalSize, int64_t bulkSizeBytes, int frameSizeBytes) {
+    std::vector<BulkRange> plan;
+    if (totalSize <= 0 || frameSizeBytes <= 0) return plan;
+
+    const int64_t framesPerBulk = std::max<int64_t>(1, bulkSizeBytes / frameSizeBytes);
+    const int64_t bulkBytes = framesPerBulk * frameSizeBytes;
+    plan.reserve(static_cast<size_t>((totalSize + bulkBytes - 1) / bulkBytes));
+    for (int64_t offset = 0; offset < totalSize; offset += bulkBytes) {
+        plan.push_back({static_cast<int>(plan.size()) + 1, offset, std::min(bulkBytes, totalSize - offset)});
+    }
+    return plan;
+}
@@ -0,0 +1,17 @@
+#ifndef BULKPLAN_H
+#define BULKPLAN_H
+
+#include <cstdint>
+#include <vector>
+
+// One output bulk: a contiguous byte range of the input file.
+struct BulkRange {
+    int index;       // 1-based number used in the _NNN.bin suffix
+    int64_t offset;  // Start of the range in the input file
+    int64_t length;  // Whole frames; only the last bulk may end in a partial frame
+};
+
+// Bulks hold as many whole frames as fit into bulkSizeBytes, but at least one.
+std::vector<BulkRange> planBulks(int64_t totalSize, int64_t bulkSizeBytes, int frameSizeBytes);
+
+#endif // BULKPLAN_H
@@ -0,0 +1,262 @@
+#include "checksum.h"
+#include "posixio.h"
+#include "splitprogress.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace {
+
+const uint32_t kCastagnoli = 0x82f63b78u;  // Reflected polynomial
+
+// Slicing-by-8 tables, built on first use.
+struct Crc32cTables {
+    uint32_t table[8][256];
+
+    Crc32cTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (kCastagnoli & (0u - (crc & 1u)));
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+        }
+    }
+};
+
+uint32_t crc32cSoftware(uint32_t crc, const unsigned char *p, size_t size) {
+    static const Crc32cTables tables;
+    const auto &t = tables.table;
+    while (size >= 8) {
+        uint32_t low;
+        uint32_t high;
+        std::memcpy(&low, p, 4);
+        std::memcpy(&high, p + 4, 4);
+        low ^= crc;
+        crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24]
+              ^ t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+    return crc;
+}
+
+// CRC registers are linear over GF(2), so appending zero bytes is a 32x32 bit
+// matrix, stored as one column per uint32_t as in zlib's crc32_combine().
+uint32_t gf2Times(const uint32_t *matrix, uint32_t vector) {
+    uint32_t sum = 0;
+    for (; vector; vector >>= 1, ++matrix) {
+        if (vector & 1) sum ^= *matrix;
+    }
+    return sum;
+}
+
+void gf2Compose(uint32_t *result, const uint32_t *outer, const uint32_t *inner) {
+    uint32_t composed[32];
+    for (int n = 0; n < 32; ++n) composed[n] = gf2Times(outer, inner[n]);
+    std::memcpy(result, composed, sizeof(composed));
+}
+
+// Operator that advances a CRC register over length zero bytes.
+void zerosOperator(int64_t length, uint32_t *result) {
+    uint32_t power[32];
+    power[0] = kCastagnoli;  // One zero bit
+    for (int n = 1; n < 32; ++n) power[n] = 1u << (n - 1);
+    for (int i = 0; i < 3; ++i) gf2Compose(power, power, power);  // One zero byte
+
+    for (int n = 0; n < 32; ++n) result[n] = 1u << n;
+    for (; length > 0; length >>= 1) {
+        if (length & 1) gf2Compose(result, power, result);
+        gf2Compose(power, power, power);
+    }
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SPLITTER_HAVE_SSE42_CRC 1
+
+// Bytes per lane in the interleaved loop. crc32 has a latency of three cycles
+// but a throughput of one, so three independent lanes keep the unit busy.
+const size_t kLaneBytes = 8192;
+
+struct LaneShifts {
+    uint32_t one[32];  // Advances a register over one lane
+    uint32_t two[32];  // ... and over two lanes
+
+    LaneShifts() {
+        zerosOperator(kLaneBytes, one);
+        zerosOperator(2 * kLaneBytes, two);
+    }
+};
+
+__attribute__((target("sse4.2")))
+uint32_t crc32cHardware(uint32_t crc, const unsigned char *p, size_t size) {
+    if (size >= 3 * kLaneBytes) {
+        static const LaneShifts shifts;
+        do {
+            uint64_t lane0 = crc;
+            uint64_t lane1 = 0;
+            uint64_t lane2 = 0;
+            for (size_t i = 0; i < kLaneBytes; i += 8) {
+                uint64_t word0, word1, word2;
+                std::memcpy(&word0, p + i, 8);
+                std::memcpy(&word1, p + kLaneBytes + i, 8);
+                std::memcpy(&word2, p + 2 * kLaneBytes + i, 8);
+                lane0 = __builtin_ia32_crc32di(lane0, word0);
+                lane1 = __builtin_ia32_crc32di(lane1, word1);
+                lane2 = __builtin_ia32_crc32di(lane2, word2);
+            }
+            crc = gf2Times(shifts.two, static_cast<uint32_t>(lane0)) ^ gf2Times(shifts.one, static_cast<uint32_t>(lane1))
+                  ^ static_cast<uint32_t>(lane2);
+            p += 3 * kLaneBytes;
+            size -= 3 * kLaneBytes;
+        } while (size >= 3 * kLaneBytes);
+    }
+
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+    while (size--) crc = __builtin_ia32_crc32qi(crc, *p++);
+    return crc;
+}
+#endif
+
+} // namespace
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+#ifdef SPLITTER_HAVE_SSE42_CRC
+    static const bool hardware = __builtin_cpu_supports("sse4.2");
+    crc = hardware ? crc32cHardware(crc, p, size) : crc32cSoftware(crc, p, size);
+#else
+    crc = crc32cSoftware(crc, p, size);
+#endif
+    return ~crc;
+}
+
+uint32_t crc32cZeros(uint32_t crc, int64_t length) {
+    uint32_t shift[32];
+    zerosOperator(length, shift);
+    return ~gf2Times(shift, ~crc);
+}
+
+uint32_t crc32cCombine(uint32_t crcA, uint32_t crcB, int64_t lengthB) {
+    return Crc32cAppender(lengthB).combine(crcA, crcB);
+}
+
+Crc32cAppender::Crc32cAppender(int64_t lengthB) {
+    zerosOperator(lengthB, m_shift);
+}
+
+uint32_t Crc32cAppender::combine(uint32_t crcA, uint32_t crcB) const {
+    return gf2Times(m_shift, crcA) ^ crcB;
+}
+
+bool crc32cFile(int fd, int64_t length, uint32_t *crc) {
+    std::vector<char> buffer(1024 * 1024);
+    uint32_t value = 0;
+    for (int64_t offset = 0; offset < length;) {
+        const int64_t wanted = std::min<int64_t>(static_cast<int64_t>(buffer.size()), length - offset);
+        const int64_t got = preadFully(fd, buffer.data(), wanted, offset);
+        if (got != wanted) {
+            if (got >= 0) errno = EIO;
+            return false;
+        }
+        value = crc32c(value, buffer.data(), static_cast<size_t>(got));
+        offset += got;
+    }
+    *crc = value;
+    return true;
+}
+
+bool verifyFiles(const std::vector<FileChecksum> &files, int jobs, SplitProgress *progress,
+                 std::vector<VerifyFailure> *failures) {
+    int64_t totalBytes = 0;
+    for (const FileChecksum &file : files) totalBytes += file.length;
+
+    std::vector<std::string> reasons(files.size());
+    std::atomic<size_t> nextFile(0);
+    std::atomic<int64_t> bytesDone(0);
+    std::mutex mutex;
+    std::condition_variable finished;
+    const size_t workerCount = std::max<size_t>(1, std::min(files.size(), static_cast<size_t>(std::max(jobs, 1))));
+    size_t running = workerCount;
+
+    const auto stopping = [&]() { return progress && progress->cancelRequested(); };
+
+    // Same shape as SplitEngine::runParallel(): workers claim whole files and the
+    // calling thread publishes progress.
+    auto worker = [&]() {
+        std::vector<char> buffer(1024 * 1024);
+        for (size_t i = nextFile++; i < files.size() && !stopping(); i = nextFile++) {
+            const FileChecksum &file = files[i];
+            UniqueFd fd(::open(file.path.c_str(), O_RDONLY | O_CLOEXEC));
+            struct stat st;
+            if (!fd.isValid() || fstat(fd.get(), &st) != 0) {
+                reasons[i] = std::string("cannot open (") + std::strerror(errno) + ")";
+                bytesDone += file.length;
+                continue;
+            }
+            if (st.st_size != file.length) {
+                reasons[i] = "size is " + std::to_string(static_cast<long long>(st.st_size)) + " bytes, expected "
+                             + std::to_string(static_cast<long long>(file.length));
+                bytesDone += file.length;
+                continue;
+            }
+            posix_fadvise(fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+            uint32_t crc = 0;
+            for (int64_t offset = 0; offset < file.length && !stopping();) {
+                const int64_t wanted = std::min<int64_t>(static_cast<int64_t>(buffer.size()), file.length - offset);
+                const int64_t got = preadFully(fd.get(), buffer.data(), wanted, offset);
+                if (got != wanted) {
+                    reasons[i] = got < 0 ? std::string("read error (") + std::strerror(errno) + ")" : "file shrank";
+                    bytesDone += file.length - offset;
+                    break;
+                }
+                crc = crc32c(crc, buffer.data(), static_cast<size_t>(got));
+                offset += got;
+                bytesDone += got;
+            }
+            if (reasons[i].empty() && !stopping() && crc != file.crc32c) reasons[i] = "checksum mismatch";
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        --running;
+        finished.notify_one();
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) workers.emplace_back(worker);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running > 0) {
+            finished.wait_for(lock, std::chrono::milliseconds(100));
+            lock.unlock();
+            if (progress) progress->publish(bytesDone.load(), totalBytes);
+            lock.lock();
+        }
+    }
+    for (std::thread &thread : workers) thread.join();
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!reasons[i].empty()) failures->push_back({i, reasons[i]});
+    }
+    return !stopping();
+}
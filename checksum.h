@@ -0,0 +1,58 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SplitProgress;
+
+// CRC32C (Castagnoli) of size bytes, continuing from crc; start with 0. Uses the
+// SSE4.2 crc32 instruction when the CPU has it and a table-driven loop otherwise.
+uint32_t crc32c(uint32_t crc, const void *data, size_t size);
+
+// crc32c() continued over length zero bytes without reading any, in
+// O(log length); hashes holes that are never read.
+uint32_t crc32cZeros(uint32_t crc, int64_t length);
+
+// CRC32C of A followed by B, from the CRCs of both parts and the length of B.
+// Lets parts hashed out of order, or on different threads, form one checksum.
+uint32_t crc32cCombine(uint32_t crcA, uint32_t crcB, int64_t lengthB);
+
+// crc32cCombine() for a fixed lengthB; building the shift is the expensive part,
+// so hot paths that append equally sized parts set it up once.
+class Crc32cAppender {
+public:
+    explicit Crc32cAppender(int64_t lengthB);
+    uint32_t combine(uint32_t crcA, uint32_t crcB) const;
+
+private:
+    uint32_t m_shift[32];
+};
+
+// CRC32C of the first length bytes of fd, read with pread() so the file position
+// is untouched. Returns false with errno set on a read error or a short file.
+bool crc32cFile(int fd, int64_t length, uint32_t *crc);
+
+// A file and the size and CRC32C it is expected to have.
+struct FileChecksum {
+    std::string path;
+    int64_t length;
+    uint32_t crc32c;
+};
+
+struct VerifyFailure {
+    size_t file;  // Index into the list passed to verifyFiles()
+    std::string reason;
+};
+
+// Checks files on up to jobs threads. The calling thread publishes the bytes
+// hashed so far to progress, if given; a cancel requested on it stops the
+// workers within one buffer and makes verifyFiles() return false. Files that
+// are missing, have another size or another checksum are listed in failures,
+// in file order.
+bool verifyFiles(const std::vector<FileChecksum> &files, int jobs, SplitProgress *progress,
+                 std::vector<VerifyFailure> *failures);
+
+#endif // CHECKSUM_H
@@ -1,7 +1,12 @@
 #include "cliinterface.h"
 #include <QThread>
+#include <QTimer>
+#include <QCommandLineParser>
+#include <QJsonDocument>
 #include <QTextStream>
 #include <qcoreapplication.h>
+#include "frameextract.h"
+#include "frametransform.h"
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
@@ -9,26 +14,70 @@
 CliInterface::CliInterface(QObject *parent) : QObject(parent),
     m_splitter(new BinarySplitterCore),
     m_workerThread(new QThread),
+    m_progressTimer(new QTimer(this)),
     m_inputFile(""),
     m_bulkSizeGb(2.0),
     m_frameSize(1111),
     m_outputPrefix("output_bulk"),
     m_autoDetect(false),
-    m_syncWord("4711") {
+    m_syncWord("4711"),
+    m_jobs(1),
+    m_pipelined(false),
+    m_ringDepth(4),
+    m_bufferSizeKb(1024),
+    m_ioBackend("posix"),
+    m_resync(false),
+    m_writeIndex(false),
+    m_resume(false),
+    m_verifyResumed(false),
+    m_writeManifest(false),
+    m_verify(false),
+    m_join(false),
+    m_follow(false),
+    m_followIdleSeconds(600),
+    m_batchJobs(0),
+    m_deviceJobs(4),
+    m_directIo(false),
+    m_sparse(false),
+    m_firstFrame(0),
+    m_endFrame(-1),
+    m_everyNth(1),
+    m_demuxMemoryMb(64),
+    m_chunkMinBytes(0),
+    m_chunkAvgBytes(0),
+    m_chunkMaxBytes(0),
+    m_compressThreads(0),
+    m_reportPath("batch_report.json") {
     // Load defaults
     QJsonObject defaults = m_splitter->loadConfigDefaults();
     m_bulkSizeGb = defaults["default_bulk_size_gb"].toDouble();
     m_frameSize = defaults["default_frame_size_bytes"].toInt();
     m_syncWord = defaults["default_sync_word_hex"].toString();
+    m_ringDepth = defaults["default_ring_depth"].toInt();
+    m_bufferSizeKb = defaults["default_buffer_size_kb"].toInt();
+    m_ioBackend = defaults["default_io_backend"].toString();
+    m_writeIndex = defaults["default_write_index"].toBool();
+    m_writeManifest = defaults["default_write_manifest"].toBool();
+    m_deviceJobs = defaults["default_device_jobs"].toInt();
+    m_directIo = defaults["default_direct_io"].toBool();
+    m_sparse = defaults["default_sparse"].toBool();
+    m_demuxMemoryMb = defaults["default_demux_memory_mb"].toInt();
+    m_compression = defaults["default_compression"].toString();
+    m_frameTransform = defaults["default_frame_transform"].toString();
 
     // Set up thread and splitter
     m_splitter->moveToThread(m_workerThread);
-    connect(m_splitter, &BinarySplitterCore::progressUpdated, this, &CliInterface::handleProgress);
+    connect(m_splitter, &BinarySplitterCore::statsReported, this, &CliInterface::statsReported);
     connect(m_splitter, &BinarySplitterCore::splitFinished, this, &CliInterface::handleFinished);
     connect(m_splitter, &BinarySplitterCore::splitError, this, &CliInterface::handleError);
-    connect(this, &CliInterface::stopRequested, m_splitter, &BinarySplitterCore::stopOperation);
+    // Direct, so the stop reaches the running split instead of queueing behind it
+    connect(this, &CliInterface::stopRequested, m_splitter, &BinarySplitterCore::stopOperation,
+            Qt::DirectConnection);
     m_workerThread->start();
 
+    m_progressTimer->setInterval(250);
+    connect(m_progressTimer, &QTimer::timeout, this, &CliInterface::sampleProgress);
+
 #ifdef Q_OS_WIN
     // Windows-specific Ctrl+C handler
     SetConsoleCtrlHandler([](DWORD ctrlType) -> BOOL {
@@ -84,32 +133,240 @@ void CliInterface::setSyncWord(const QString &word) {
     }
 }
 
+void CliInterface::setJobs(int jobs) {
+    if (jobs > 0 && jobs <= 256) {
+        m_jobs = jobs;
+    }
+}
+
+void CliInterface::setPipelined(bool pipelined) {
+    m_pipelined = pipelined;
+}
+
+void CliInterface::setRingDepth(int depth) {
+    if (depth >= 2 && depth <= 256) {
+        m_ringDepth = depth;
+    }
+}
+
+void CliInterface::setBufferSizeKb(int sizeKb) {
+    if (sizeKb >= 4 && sizeKb <= 256 * 1024) {
+        m_bufferSizeKb = sizeKb;
+    }
+}
+
+void CliInterface::setIoBackend(const QString &backend) {
+    if (backend == "posix" || backend == "uring" || backend == "qt") {
+        m_ioBackend = backend;
+    }
+}
+
+void CliInterface::setResync(bool resync) {
+    m_resync = resync;
+}
+
+void CliInterface::setWriteIndex(bool writeIndex) {
+    m_writeIndex = writeIndex;
+}
+
+void CliInterface::setResume(bool resume) {
+    m_resume = resume;
+}
+
+void CliInterface::setVerifyResumed(bool verify) {
+    m_verifyResumed = verify;
+}
+
+void CliInterface::setWriteManifest(bool writeManifest) {
+    m_writeManifest = writeManifest;
+}
+
+void CliInterface::setVerify(bool verify) {
+    m_verify = verify;
+}
+
+void CliInterface::setJoin(bool join) {
+    m_join = join;
+}
+
+void CliInterface::setOutputFile(const QString &file) {
+    m_outputFile = file;
+}
+
+void CliInterface::setFollow(bool follow) {
+    m_follow = follow;
+}
+
+void CliInterface::setFollowIdleSeconds(int seconds) {
+    m_followIdleSeconds = seconds;
+}
+
+void CliInterface::setBatch(const QString &spec) {
+    m_batch = spec;
+}
+
+void CliInterface::setBatchJobs(int jobs) {
+    m_batchJobs = jobs;
+}
+
+void CliInterface::setDeviceJobs(int jobs) {
+    m_deviceJobs = jobs;
+}
+
+void CliInterface::setDirectIo(bool directIo) {
+    m_directIo = directIo;
+}
+
+void CliInterface::setSparse(bool sparse) {
+    m_sparse = sparse;
+}
+
+void CliInterface::setFrameFilter(qint64 firstFrame, qint64 endFrame, qint64 everyNth,
+                                  const QStringList &headerPredicates) {
+    m_firstFrame = firstFrame;
+    m_endFrame = endFrame;
+    m_everyNth = everyNth;
+    m_headerPredicates = headerPredicates;
+}
+
+void CliInterface::setChannelField(const QString &spec) {
+    m_channelField = spec;
+}
+
+void CliInterface::setDemuxMemoryMb(int memoryMb) {
+    m_demuxMemoryMb = memoryMb;
+}
+
+void CliInterface::setChunking(qint64 minBytes, qint64 avgBytes, qint64 maxBytes) {
+    m_chunkMinBytes = minBytes;
+    m_chunkAvgBytes = avgBytes;
+    m_chunkMaxBytes = maxBytes;
+}
+
+void CliInterface::setCompression(const QString &codec) {
+    m_compression = codec;
+}
+
+void CliInterface::setCompressThreads(int threads) {
+    m_compressThreads = threads;
+}
+
+void CliInterface::setFrameTransform(const QString &spec) {
+    m_frameTransform = spec;
+}
+
+void CliInterface::setReportPath(const QString &path) {
+    m_reportPath = path;
+}
+
 void CliInterface::startSplit() {
-    if (m_inputFile.isEmpty()) {
+    if (m_inputFile.isEmpty() && m_batch.isEmpty()) {
         emit operationError("Input file is required.");
         return;
     }
 
-    QMetaObject::invokeMethod(m_splitter, "resetStopFlag", Qt::QueuedConnection);
+    m_splitter->resetStopFlag();
+    QMetaObject::invokeMethod(m_splitter, "setJobs", Qt::QueuedConnection, Q_ARG(int, m_jobs));
+    QMetaObject::invokeMethod(m_splitter, "setPipelined", Qt::QueuedConnection, Q_ARG(bool, m_pipelined));
+    QMetaObject::invokeMethod(m_splitter, "setRingDepth", Qt::QueuedConnection, Q_ARG(int, m_ringDepth));
+    QMetaObject::invokeMethod(m_splitter, "setBufferSizeKb", Qt::QueuedConnection, Q_ARG(int, m_bufferSizeKb));
+    QMetaObject::invokeMethod(m_splitter, "setIoBackend", Qt::QueuedConnection, Q_ARG(QString, m_ioBackend));
+    QMetaObject::invokeMethod(m_splitter, "setResync", Qt::QueuedConnection, Q_ARG(bool, m_resync));
+    QMetaObject::invokeMethod(m_splitter, "setSyncWord", Qt::QueuedConnection, Q_ARG(QString, m_syncWord));
+    QMetaObject::invokeMethod(m_splitter, "setWriteIndex", Qt::QueuedConnection, Q_ARG(bool, m_writeIndex));
+    QMetaObject::invokeMethod(m_splitter, "setResume", Qt::QueuedConnection, Q_ARG(bool, m_resume));
+    QMetaObject::invokeMethod(m_splitter, "setVerifyResumed", Qt::QueuedConnection, Q_ARG(bool, m_verifyResumed));
+    QMetaObject::invokeMethod(m_splitter, "setWriteManifest", Qt::QueuedConnection, Q_ARG(bool, m_writeManifest));
+    QMetaObject::invokeMethod(m_splitter, "setFollow", Qt::QueuedConnection, Q_ARG(bool, m_follow));
+    QMetaObject::invokeMethod(m_splitter, "setFollowIdleSeconds", Qt::QueuedConnection,
+                              Q_ARG(int, m_followIdleSeconds));
+    QMetaObject::invokeMethod(m_splitter, "setDirectIo", Qt::QueuedConnection, Q_ARG(bool, m_directIo));
+    QMetaObject::invokeMethod(m_splitter, "setSparse", Qt::QueuedConnection, Q_ARG(bool, m_sparse));
+    QMetaObject::invokeMethod(m_splitter, "setFrameFilter", Qt::QueuedConnection, Q_ARG(qint64, m_firstFrame),
+                              Q_ARG(qint64, m_endFrame), Q_ARG(qint64, m_everyNth),
+                              Q_ARG(QStringList, m_headerPredicates));
+    QMetaObject::invokeMethod(m_splitter, "setChannelField", Qt::QueuedConnection, Q_ARG(QString, m_channelField));
+    QMetaObject::invokeMethod(m_splitter, "setDemuxMemoryMb", Qt::QueuedConnection, Q_ARG(int, m_demuxMemoryMb));
+    QMetaObject::invokeMethod(m_splitter, "setChunking", Qt::QueuedConnection, Q_ARG(qint64, m_chunkMinBytes),
+                              Q_ARG(qint64, m_chunkAvgBytes), Q_ARG(qint64, m_chunkMaxBytes));
+    QMetaObject::invokeMethod(m_splitter, "setCompression", Qt::QueuedConnection, Q_ARG(QString, m_compression));
+    QMetaObject::invokeMethod(m_splitter, "setCompressThreads", Qt::QueuedConnection, Q_ARG(int, m_compressThreads));
+    QMetaObject::invokeMethod(m_splitter, "setFrameTransform", Qt::QueuedConnection, Q_ARG(QString, m_frameTransform));
+
+    if (!m_batch.isEmpty()) {
+        QString error;
+        const QStringList inputs = BinarySplitterCore::expandBatchInputs(m_batch, &error);
+        if (inputs.isEmpty()) {
+            emit operationError(error);
+            return;
+        }
+        if (m_batchJobs > 0) {
+            QMetaObject::invokeMethod(m_splitter, "setBatchJobs", Qt::QueuedConnection, Q_ARG(int, m_batchJobs));
+        }
+        QMetaObject::invokeMethod(m_splitter, "setDeviceJobs", Qt::QueuedConnection, Q_ARG(int, m_deviceJobs));
+        emit statusChanged(QString("Splitting %1 files...").arg(inputs.size()));
+        m_progressTimer->start();
+        // A frame size of 0 asks the core to detect it for every input.
+        const int frameSize = m_autoDetect ? 0 : m_frameSize;
+        QMetaObject::invokeMethod(m_splitter, "splitBatch", Qt::QueuedConnection,
+                                  Q_ARG(QStringList, inputs),
+                                  Q_ARG(double, m_bulkSizeGb),
+                                  Q_ARG(int, frameSize),
+                                  Q_ARG(QString, m_reportPath));
+        return;
+    }
+
+    if (m_verify) {
+        emit statusChanged("Verifying bulk checksums...");
+        m_progressTimer->start();
+        QMetaObject::invokeMethod(m_splitter, "verifyBulks", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_inputFile),
+                                  Q_ARG(QString, m_outputPrefix));
+        return;
+    }
+
+    if (m_join) {
+        emit statusChanged("Joining bulks...");
+        m_progressTimer->start();
+        QMetaObject::invokeMethod(m_splitter, "joinBulks", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_inputFile),
+                                  Q_ARG(QString, m_outputPrefix),
+                                  Q_ARG(QString, m_outputFile));
+        return;
+    }
 
     int frameSizeToUse;
+    if (m_autoDetect && m_inputFile == "-") {
+        // Sampling would consume the stream before it is split.
+        emit operationError("Frame size detection needs a file; pass --frame-size when reading stdin.");
+        return;
+    }
     if (m_autoDetect) {
-        bool ok = QMetaObject::invokeMethod(m_splitter, "detectFrameSize",
+        QJsonObject detection;
+        bool ok = QMetaObject::invokeMethod(m_splitter, "analyzeFrameSize",
                                             Qt::BlockingQueuedConnection,
-                                            Q_RETURN_ARG(int, frameSizeToUse),
+                                            Q_RETURN_ARG(QJsonObject, detection),
                                             Q_ARG(QString, m_inputFile),
                                             Q_ARG(QString, m_syncWord));
+        frameSizeToUse = detection["frame_size"].toInt(-1);
         if (!ok || frameSizeToUse <= 0) {
             emit operationError("Frame size detection failed.");
             return;
         }
         m_frameSize = frameSizeToUse;
-        emit statusChanged(QString("Detected frame size: %1 bytes").arg(frameSizeToUse));
+        const double confidence = detection["confidence"].toDouble();
+        QString status = QString("Detected frame size: %1 bytes (confidence %2%, lock ratio %3%)")
+                             .arg(frameSizeToUse)
+                             .arg(confidence * 100, 0, 'f', 1)
+                             .arg(detection["lock_ratio"].toDouble() * 100, 0, 'f', 1);
+        if (confidence < 0.5) status += "\nWarning: low confidence, check the sync word.";
+        emit statusChanged(status);
     } else {
         frameSizeToUse = m_frameSize;
     }
 
     emit statusChanged("Splitting in progress...");
+    m_progressTimer->start();
     QMetaObject::invokeMethod(m_splitter, "splitBinaryFile", Qt::QueuedConnection,
                               Q_ARG(QString, m_inputFile),
                               Q_ARG(double, m_bulkSizeGb),
@@ -121,16 +378,353 @@ void CliInterface::stopSplit() {
     emit stopRequested();
 }
 
-void CliInterface::handleProgress(int percentage) {
-    emit progressUpdated(percentage);
+// Polls the core's counters, so a split of many tiny bulks costs one console
+// update per tick instead of a queued signal per bulk.
+void CliInterface::sampleProgress() {
+    const SplitProgress::Sample sample = m_splitter->progress().sample();
+    if (sample.totalBytes != 0) {
+        emit throughputUpdated(sample.bytesDone, sample.totalBytes, sample.bytesPerSecond);
+    }
 }
 
 void CliInterface::handleFinished(const QString &message) {
+    m_progressTimer->stop();
+    sampleProgress();
     emit statusChanged(message);
     QCoreApplication::quit();
 }
 
 void CliInterface::handleError(const QString &error) {
+    m_progressTimer->stop();
     emit operationError(error);
-    QCoreApplication::quit();
+    QCoreApplication::exit(1);  // Batch callers see the failure in the exit status
+}
+
+void printCliUsage(QTextStream &out, const QString &programName, bool withGui) {
+    // The GUI executable needs --cli to stay on the console; the lean one is always there
+    const QString cliFlag = withGui ? QStringLiteral(" --cli") : QString();
+    out << "Binary File Splitter\n"
+        << "Splits large binary files into smaller chunks based on bulk size or frame size.\n\n"
+        << "Usage examples:\n"
+        << "  CLI mode with explicit frame size:\n"
+        << "    " << programName << cliFlag << " --input file.bin --bulk-size 2.0 --frame-size 1111\n"
+        << "  CLI mode with auto-detected frame size:\n"
+        << "    " << programName << cliFlag << " --input file.bin --auto-detect --sync-word 4711\n"
+        << "  CLI batch over a night of captures, writing one summary report:\n"
+        << "    " << programName << cliFlag << " --batch '/data/captures/*.bin' --frame-size 1111\n";
+    if (withGui) {
+        out << "  GUI mode:\n"
+            << "    " << programName << "\n";
+    }
+    out << "\nOptions:\n";
+    if (withGui) {
+        out << "  --cli                       Run in command-line interface mode (non-GUI)\n";
+    }
+    out << "  --input <file>              Input binary file, or - for stdin (required in CLI mode without --batch)\n"
+        << "  --bulk-size <size>          Bulk size in GB (default: 2.0)\n"
+        << "  --frame-size <bytes>        Frame size in bytes (default: 1111)\n"
+        << "  --output-prefix <prefix>    Output file prefix (default: input filename)\n"
+        << "  --auto-detect               Auto-detect frame size using sync word\n"
+        << "  --sync-word <hex>           Sync word in hex for auto-detection and resync (default: 4711)\n"
+        << "  --resync                    Cut only at validated sync words and skip corrupt bytes\n"
+        << "  --index                     Write a <input>.fidx frame index for later re-splits\n"
+        << "  --resume                    Journal finished bulks; rerun to continue an interrupted split\n"
+        << "  --resume-verify             Re-read kept bulks on resume instead of trusting their size and time\n"
+        << "  --manifest                  Checksum every bulk (CRC32C) into <prefix>_manifest.json\n"
+        << "  --verify                    Check the bulks against the manifest instead of splitting\n"
+        << "  --join                      Reassemble <input> from its bulks, checking the manifest checksums\n"
+        << "  --output <file>             File written by --join (default: the input path)\n"
+        << "  --follow                    Split a file that is still being written until no process has it open for\n"
+        << "                              writing any more\n"
+        << "  --follow-idle <seconds>     Also stop following after this long without new data, 0 for never (default: 600)\n"
+        << "  --frames <first>-<last>     Extract only frames first to last, counted from 0 (either end may be omitted)\n"
+        << "  --every <n>                 Extract only every nth frame of the range\n"
+        << "  --where <offset>=<hex>[/<mask>]\n"
+        << "                              Extract only frames whose header bytes match; repeat to require several\n"
+        << "  --demux <offset>[/<mask>]   Write each channel of the header field to its own <prefix>_chNN_NNN.bin series\n"
+        << "  --demux-memory <MiB>        Write buffer shared by all channels when demultiplexing (default: 64)\n"
+        << "  --cdc <min>,<avg>,<max>     Cut bulks by content, sizes in MiB, and skip bulks already in the output directory\n"
+        << "  --compress <codec>          Write bulks as <prefix>_NNN.cbin compressed in seekable blocks: lz or zstd\n"
+        << "  --compress-threads <n>      Threads compressing blocks (default: one per CPU)\n"
+        << "  --transform <steps>         Write only frame payloads: strip=<bytes>|sync, payload=<bytes>, swap=16|32|64\n"
+        << "  --stats=json                Print per-stage I/O timings and bulk latencies when the split ends\n"
+        << "  --batch <spec>              Split every file in a directory, matching a pattern or listed in @file\n"
+        << "  --batch-jobs <n>            Files split concurrently in batch mode (default: one per CPU)\n"
+        << "  --device-jobs <n>           Concurrent files per SSD in batch mode; HDDs take one (default: 4)\n"
+        << "  --report <file>             Summary report of a batch (default: batch_report.json)\n"
+        << "  --jobs <n>                  Number of bulk files written in parallel (default: 1)\n"
+        << "  --pipeline                  Overlap reads and writes through a ring of buffers\n"
+        << "  --ring-depth <n>            Buffers in the pipeline ring (default: 4)\n"
+        << "  --buffer-size <KiB>         Size of each pipeline buffer in KiB (default: 1024)\n"
+        << "  --io-backend <name>         I/O backend: posix, uring or qt (default: posix)\n"
+        << "  --direct-io                 Bypass the page cache (O_DIRECT) when reading and writing bulks\n"
+        << "  --sparse                    Leave holes and all-zero frames of the input as holes in the bulks\n"
+        << "  --help, -h                  Show this help message\n";
+    out.flush();
+}
+
+int runCli(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption("batch", "Split every file in a directory, matching a pattern or listed in @file", "spec"));
+    parser.addOption(QCommandLineOption("batch-jobs", "Files split concurrently in batch mode (default: one per CPU)", "n"));
+    parser.addOption(QCommandLineOption("device-jobs", "Concurrent files per SSD in batch mode; HDDs take one (default: 4)", "n"));
+    parser.addOption(QCommandLineOption("report", "Summary report of a batch (default: batch_report.json)", "file"));
+    // --cli selects this mode in the GUI executable; it is accepted here so scripts can switch binaries
+    parser.addOption(QCommandLineOption("cli", "Run in command-line interface mode (non-GUI)"));
+    parser.addOption(QCommandLineOption("input", "Input binary file, or - for stdin (required in CLI mode)", "file"));
+    parser.addOption(QCommandLineOption("bulk-size", "Bulk size in GB (default: 2.0)", "size"));
+    parser.addOption(QCommandLineOption("frame-size", "Frame size in bytes (default: 1111)", "bytes"));
+    parser.addOption(QCommandLineOption("output-prefix", "Output file prefix (default: input filename)", "prefix"));
+    parser.addOption(QCommandLineOption("auto-detect", "Auto-detect frame size using sync word"));
+    parser.addOption(QCommandLineOption("sync-word", "Sync word in hex for auto-detection and resync (default: 4711)", "hex"));
+    parser.addOption(QCommandLineOption("resync", "Cut only at validated sync words and skip corrupt bytes"));
+    parser.addOption(QCommandLineOption("index", "Write a <input>.fidx frame index for later re-splits"));
+    parser.addOption(QCommandLineOption("resume", "Journal finished bulks; rerun to continue an interrupted split"));
+    parser.addOption(QCommandLineOption("resume-verify", "Re-read kept bulks on resume instead of trusting their size and time"));
+    parser.addOption(QCommandLineOption("manifest", "Checksum every bulk (CRC32C) into <prefix>_manifest.json"));
+    parser.addOption(QCommandLineOption("verify", "Check the bulks against the manifest instead of splitting"));
+    parser.addOption(QCommandLineOption("join", "Reassemble <input> from its bulks, checking the manifest checksums"));
+    parser.addOption(QCommandLineOption("output", "File written by --join (default: the input path)", "file"));
+    parser.addOption(QCommandLineOption("follow", "Split a file that is still being written until no process has it open for writing any more"));
+    parser.addOption(QCommandLineOption("follow-idle", "Also stop following after this long without new data, 0 for never (default: 600)", "seconds"));
+    parser.addOption(QCommandLineOption("frames", "Extract only frames first to last, counted from 0 (either end may be omitted)", "first-last"));
+    parser.addOption(QCommandLineOption("every", "Extract only every nth frame of the range", "n"));
+    parser.addOption(QCommandLineOption("where", "Extract only frames whose header bytes match; repeat to require several", "offset=hex[/mask]"));
+    parser.addOption(QCommandLineOption("demux", "Write each channel of the header field to its own <prefix>_chNN_NNN.bin series", "offset[/mask]"));
+    parser.addOption(QCommandLineOption("demux-memory", "Write buffer shared by all channels when demultiplexing (default: 64)", "MiB"));
+    parser.addOption(QCommandLineOption("cdc", "Cut bulks by content, sizes in MiB, and skip bulks already in the output directory", "min,avg,max"));
+    parser.addOption(QCommandLineOption("compress", "Write bulks as <prefix>_NNN.cbin compressed in seekable blocks: lz or zstd", "codec"));
+    parser.addOption(QCommandLineOption("compress-threads", "Threads compressing blocks (default: one per CPU)", "n"));
+    parser.addOption(QCommandLineOption("transform", "Write only frame payloads: strip=<bytes>|sync, payload=<bytes>, swap=16|32|64", "steps"));
+    parser.addOption(QCommandLineOption("stats", "Print per-stage timings when the split ends; format: json", "format"));
+    parser.addOption(QCommandLineOption("jobs", "Number of bulk files written in parallel (default: 1)", "n"));
+    parser.addOption(QCommandLineOption("pipeline", "Overlap reads and writes through a ring of buffers"));
+    parser.addOption(QCommandLineOption("ring-depth", "Buffers in the pipeline ring (default: 4)", "n"));
+    parser.addOption(QCommandLineOption("buffer-size", "Size of each pipeline buffer in KiB (default: 1024)", "KiB"));
+    parser.addOption(QCommandLineOption("io-backend", "I/O backend: posix, uring or qt (default: posix)", "name"));
+    parser.addOption(QCommandLineOption("direct-io", "Bypass the page cache (O_DIRECT) when reading and writing bulks"));
+    parser.addOption(QCommandLineOption("sparse", "Leave holes and all-zero frames of the input as holes in the bulks"));
+    parser.process(app);
+
+    // Set up CLI functionality
+    CliInterface cli;
+    if (parser.isSet("input") == parser.isSet("batch")) {
+        QTextStream err(stderr);
+        err << "Error: Either an input file or a batch is required in CLI mode. Use --input <file> or --batch <spec>\n";
+        return 1;
+    }
+    if (parser.isSet("batch")) {
+        cli.setBatch(parser.value("batch"));
+        if (parser.isSet("batch-jobs")) {
+            bool ok;
+            int jobs = parser.value("batch-jobs").toInt(&ok);
+            if (ok && jobs > 0) cli.setBatchJobs(jobs);
+        }
+        if (parser.isSet("device-jobs")) {
+            bool ok;
+            int jobs = parser.value("device-jobs").toInt(&ok);
+            if (ok && jobs > 0) cli.setDeviceJobs(jobs);
+        }
+        if (parser.isSet("report")) {
+            cli.setReportPath(parser.value("report"));
+        }
+    } else {
+        cli.setInputFile(parser.value("input"));
+    }
+
+    if (parser.isSet("bulk-size")) {
+        bool ok;
+        double size = parser.value("bulk-size").toDouble(&ok);
+        if (ok && size > 0) cli.setBulkSizeGb(size);
+    }
+
+    if (parser.isSet("frame-size")) {
+        bool ok;
+        int size = parser.value("frame-size").toInt(&ok);
+        if (ok && size > 0) cli.setFrameSize(size);
+    }
+
+    if (parser.isSet("jobs")) {
+        bool ok;
+        int jobs = parser.value("jobs").toInt(&ok);
+        if (ok && jobs > 0) cli.setJobs(jobs);
+    }
+
+    cli.setPipelined(parser.isSet("pipeline"));
+
+    if (parser.isSet("ring-depth")) {
+        bool ok;
+        int depth = parser.value("ring-depth").toInt(&ok);
+        if (ok) cli.setRingDepth(depth);
+    }
+
+    if (parser.isSet("buffer-size")) {
+        bool ok;
+        int sizeKb = parser.value("buffer-size").toInt(&ok);
+        if (ok) cli.setBufferSizeKb(sizeKb);
+    }
+
+    if (parser.isSet("io-backend")) {
+        cli.setIoBackend(parser.value("io-backend"));
+    }
+    if (parser.isSet("direct-io")) {
+        cli.setDirectIo(true);
+    }
+    if (parser.isSet("sparse")) {
+        cli.setSparse(true);
+    }
+
+    if (parser.isSet("frames") || parser.isSet("every") || parser.isSet("where")) {
+        QTextStream err(stderr);
+        qint64 firstFrame = 0;
+        qint64 endFrame = -1;
+        if (parser.isSet("frames")) {
+            const QStringList ends = parser.value("frames").split('-');
+            bool firstOk = true;
+            bool lastOk = true;
+            if (ends.size() != 2 || (ends[0].isEmpty() && ends[1].isEmpty())) firstOk = false;
+            if (firstOk && !ends[0].isEmpty()) firstFrame = ends[0].toLongLong(&firstOk);
+            if (firstOk && !ends[1].isEmpty()) endFrame = ends[1].toLongLong(&lastOk) + 1;
+            if (!firstOk || !lastOk || firstFrame < 0 || (endFrame >= 0 && endFrame <= firstFrame)) {
+                err << "Error: Invalid frame range: " << parser.value("frames") << " (expected <first>-<last>)\n";
+                return 1;
+            }
+        }
+        qint64 everyNth = 1;
+        if (parser.isSet("every")) {
+            bool ok;
+            everyNth = parser.value("every").toLongLong(&ok);
+            if (!ok || everyNth <= 0) {
+                err << "Error: Invalid frame step: " << parser.value("every") << "\n";
+                return 1;
+            }
+        }
+        const QStringList predicates = parser.values("where");
+        for (const QString &predicate : predicates) {
+            HeaderPredicate parsed;
+            std::string error;
+            if (!parseHeaderPredicate(predicate.toStdString(), &parsed, &error)) {
+                err << "Error: " << QString::fromStdString(error) << "\n";
+                return 1;
+            }
+        }
+        cli.setFrameFilter(firstFrame, endFrame, everyNth, predicates);
+    }
+
+    if (parser.isSet("demux")) {
+        cli.setChannelField(parser.value("demux"));
+    }
+    if (parser.isSet("demux-memory")) {
+        bool ok;
+        int memoryMb = parser.value("demux-memory").toInt(&ok);
+        if (ok) cli.setDemuxMemoryMb(memoryMb);
+    }
+
+    if (parser.isSet("cdc")) {
+        const QStringList sizes = parser.value("cdc").split(',');
+        bool ok = sizes.size() == 3;
+        qint64 bytes[3] = {0, 0, 0};
+        for (int i = 0; ok && i < 3; ++i) {
+            const double mb = sizes[i].toDouble(&ok);
+            bytes[i] = static_cast<qint64>(mb * 1024 * 1024);
+            ok = ok && bytes[i] > 0;
+        }
+        if (!ok || bytes[0] > bytes[1] || bytes[1] > bytes[2]) {
+            QTextStream err(stderr);
+            err << "Error: Invalid content-defined bulk sizes: " << parser.value("cdc")
+                << " (expected <min>,<avg>,<max> in MiB, in increasing order)\n";
+            return 1;
+        }
+        cli.setChunking(bytes[0], bytes[1], bytes[2]);
+    }
+
+    if (parser.isSet("compress")) {
+        cli.setCompression(parser.value("compress"));
+    }
+    if (parser.isSet("compress-threads")) {
+        bool ok;
+        int threads = parser.value("compress-threads").toInt(&ok);
+        if (ok) cli.setCompressThreads(threads);
+    }
+
+    if (parser.isSet("transform")) {
+        FrameTransform transform;
+        std::string error;
+        if (!parseFrameTransform(parser.value("transform").toStdString(), &transform, &error)) {
+            QTextStream err(stderr);
+            err << "Error: " << QString::fromStdString(error) << "\n";
+            return 1;
+        }
+        cli.setFrameTransform(parser.value("transform"));
+    }
+
+    if (parser.isSet("output-prefix")) {
+        cli.setOutputPrefix(parser.value("output-prefix"));
+    }
+
+    if (parser.isSet("sync-word")) {
+        cli.setSyncWord(parser.value("sync-word"));
+    }
+    cli.setAutoDetect(parser.isSet("auto-detect"));
+    cli.setResync(parser.isSet("resync"));
+    if (parser.isSet("index")) {
+        cli.setWriteIndex(true);
+    }
+    cli.setResume(parser.isSet("resume") || parser.isSet("resume-verify"));
+    cli.setVerifyResumed(parser.isSet("resume-verify"));
+    if (parser.isSet("manifest")) {
+        cli.setWriteManifest(true);
+    }
+    cli.setVerify(parser.isSet("verify"));
+    cli.setJoin(parser.isSet("join"));
+    if (parser.isSet("output")) {
+        cli.setOutputFile(parser.value("output"));
+    }
+    cli.setFollow(parser.isSet("follow"));
+    if (parser.isSet("follow-idle")) {
+        bool ok;
+        int seconds = parser.value("follow-idle").toInt(&ok);
+        if (ok && seconds >= 0) cli.setFollowIdleSeconds(seconds);
+    }
+
+    // Connect signals for console output
+    QTextStream out(stdout);
+    QObject::connect(&cli, &CliInterface::throughputUpdated,
+                     [&out](qint64 bytesDone, qint64 totalBytes, double bytesPerSecond) {
+        const double mibPerSecond = bytesPerSecond / (1024.0 * 1024.0);
+        if (totalBytes < 0) {
+            out << QString("Received: %1 MiB (%2 MiB/s)   ")
+                       .arg(bytesDone / (1024.0 * 1024.0), 0, 'f', 1).arg(mibPerSecond, 0, 'f', 1) << "\r";
+        } else if (totalBytes > 0) {
+            const qint64 eta = bytesPerSecond > 0 ? qint64((totalBytes - bytesDone) / bytesPerSecond) : 0;
+            out << QString("Progress: %1% at %2 MiB/s, ETA %3:%4   ")
+                       .arg(bytesDone * 100 / totalBytes, 3, 10, QChar(' ')).arg(mibPerSecond, 0, 'f', 1)
+                       .arg(eta / 60).arg(eta % 60, 2, 10, QChar('0')) << "\r";
+        }
+        out.flush();
+    });
+    if (parser.isSet("stats")) {
+        if (parser.value("stats") != "json") {
+            QTextStream err(stderr);
+            err << "Error: Unknown stats format: " << parser.value("stats") << " (supported: json)\n";
+            return 1;
+        }
+        QObject::connect(&cli, &CliInterface::statsReported, [&out](const QJsonObject &stats) {
+            out << "\n" << QJsonDocument(stats).toJson();
+            out.flush();
+        });
+    }
+    QObject::connect(&cli, &CliInterface::statusChanged, [&out](const QString &status) {
+        out << "\n" << status << "\n";
+        out.flush();
+    });
+    QObject::connect(&cli, &CliInterface::operationError, [&out](const QString &error) {
+        out << "\nError: " << error << "\n";
+        out.flush();
+    });
+
+    cli.startSplit();
+    return app.exec();
 }
@@ -6,6 +6,8 @@
 #include "binarysplittercore.h"
 
 class QThread;
+class QTimer;
+class QTextStream;
 
 class CliInterface : public QObject {
     Q_OBJECT
@@ -20,32 +22,106 @@ public:
     void setOutputPrefix(const QString &prefix);
     void setAutoDetect(bool detect);
     void setSyncWord(const QString &word);
+    void setJobs(int jobs);
+    void setPipelined(bool pipelined);
+    void setRingDepth(int depth);
+    void setBufferSizeKb(int sizeKb);
+    void setIoBackend(const QString &backend);
+    void setResync(bool resync);
+    void setWriteIndex(bool writeIndex);
+    void setResume(bool resume);
+    void setVerifyResumed(bool verify);  // Re-hash kept bulks instead of trusting their size and time
+    void setWriteManifest(bool writeManifest);
+    void setVerify(bool verify);  // Check the bulks against the manifest instead of splitting
+    void setJoin(bool join);  // Reassemble the input from its bulks instead of splitting
+    void setOutputFile(const QString &file);  // Joined file; empty restores the input path
+    void setFollow(bool follow);
+    void setFollowIdleSeconds(int seconds);  // 0 follows until the writers are gone
+    // Split every input named by spec (directory, pattern or @list) instead of the input file
+    void setBatch(const QString &spec);
+    void setBatchJobs(int jobs);
+    void setDeviceJobs(int jobs);
+    void setDirectIo(bool directIo);
+    void setSparse(bool sparse);
+    // Extract only the selected frames; see BinarySplitterCore::setFrameFilter()
+    void setFrameFilter(qint64 firstFrame, qint64 endFrame, qint64 everyNth, const QStringList &headerPredicates);
+    // Demultiplex by the header field "<offset>[/<mask>]"; see BinarySplitterCore::setChannelField()
+    void setChannelField(const QString &spec);
+    void setDemuxMemoryMb(int memoryMb);
+    // Content-defined bulks; see BinarySplitterCore::setChunking()
+    void setChunking(qint64 minBytes, qint64 avgBytes, qint64 maxBytes);
+    // Compressed bulks; see BinarySplitterCore::setCompression()
+    void setCompression(const QString &codec);
+    void setCompressThreads(int threads);
+    // Payload-only bulks; see BinarySplitterCore::setFrameTransform()
+    void setFrameTransform(const QString &spec);
+    void setReportPath(const QString &path);
     QString inputFile() const { return m_inputFile; } // For validation in main
 
     void startSplit();
     void stopSplit();
 
 signals:
-    void progressUpdated(int percentage);
+    void throughputUpdated(qint64 bytesDone, qint64 totalBytes, double bytesPerSecond);
+    void statsReported(const QJsonObject &stats);
     void statusChanged(const QString &status);
     void operationFinished(const QString &message);
     void operationError(const QString &error);
     void stopRequested();
 
 private slots:
-    void handleProgress(int percentage);
+    void sampleProgress();
     void handleFinished(const QString &message);
     void handleError(const QString &error);
 
 private:
     BinarySplitterCore *m_splitter;
     QThread *m_workerThread;
+    QTimer *m_progressTimer;
     QString m_inputFile;
     double m_bulkSizeGb;
     int m_frameSize;
     QString m_outputPrefix;
     bool m_autoDetect;
     QString m_syncWord;
+    int m_jobs;
+    bool m_pipelined;
+    int m_ringDepth;
+    int m_bufferSizeKb;
+    QString m_ioBackend;
+    bool m_resync;
+    bool m_writeIndex;
+    bool m_resume;
+    bool m_verifyResumed;
+    bool m_writeManifest;
+    bool m_verify;
+    bool m_join;
+    QString m_outputFile;
+    bool m_follow;
+    int m_followIdleSeconds;
+    QString m_batch;
+    int m_batchJobs;  // 0 keeps the core's default of one per CPU
+    int m_deviceJobs;
+    bool m_directIo;
+    bool m_sparse;
+    qint64 m_firstFrame;
+    qint64 m_endFrame;
+    qint64 m_everyNth;
+    QStringList m_headerPredicates;
+    QString m_channelField;
+    int m_demuxMemoryMb;
+    qint64 m_chunkMinBytes;
+    qint64 m_chunkAvgBytes;
+    qint64 m_chunkMaxBytes;
+    QString m_compression;
+    int m_compressThreads;
+    QString m_frameTransform;
+    QString m_reportPath;
 };
 
+// Shared by the GUI executable's --cli mode and the lean binarysplitter-cli.
+// runCli creates the QCoreApplication itself and returns the exit code.
+void printCliUsage(QTextStream &out, const QString &programName, bool withGui);
+int runCli(int argc, char *argv[]);
+
 #endif // CLIINTERFACE_H
@@ -0,0 +1,17 @@
+#include "cliinterface.h"
+#include <QFileInfo>
+#include <QTextStream>
+
+// Console-only entry point. It links QtCore alone, so a batch launch does not
+// map or relocate the Gui, Qml, Quick and Widgets libraries that the GUI
+// executable pulls in even for --cli runs.
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--help") == 0 || qstrcmp(argv[i], "-h") == 0) {
+            QTextStream out(stdout);
+            printCliUsage(out, QFileInfo(argv[0]).fileName(), false);
+            return 0;
+        }
+    }
+    return runCli(argc, argv);
+}
@@ -0,0 +1,158 @@
+#include "compressedbulk.h"
+#include "checksum.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char kBulkMagic[8] = {'B', 'S', 'C', 'B', 'U', 'L', 'K', '1'};
+const char kIndexMagic[4] = {'B', 'I', 'D', 'X'};
+}
+
+bool CompressedBulkWriter::begin(int fd, uint32_t codec, uint32_t blockBytes, uint32_t frameSize,
+                                 int64_t rawLength) {
+    m_fd = fd;
+    m_fileSize = 0;
+    m_crc = 0;
+    m_blocks.clear();
+    CompressedBulkHeader header{};
+    std::memcpy(header.magic, kBulkMagic, sizeof(kBulkMagic));
+    header.codec = codec;
+    header.blockBytes = blockBytes;
+    header.frameSize = frameSize;
+    header.rawLength = rawLength;
+    return write(&header, sizeof(header));
+}
+
+bool CompressedBulkWriter::addBlock(const char *data, uint32_t size, uint32_t rawSize, uint32_t rawCrc,
+                                    bool stored) {
+    m_blocks.push_back({static_cast<uint64_t>(m_fileSize), size, rawSize, rawCrc,
+                        stored ? uint32_t(CompressedBlock::Stored) : 0u});
+    return write(data, size);
+}
+
+bool CompressedBulkWriter::finish() {
+    CompressedBulkTrailer trailer{};
+    trailer.indexOffset = static_cast<uint64_t>(m_fileSize);
+    trailer.blockCount = static_cast<uint32_t>(m_blocks.size());
+    std::memcpy(trailer.magic, kIndexMagic, sizeof(kIndexMagic));
+    return write(m_blocks.data(), m_blocks.size() * sizeof(CompressedBlock)) && write(&trailer, sizeof(trailer));
+}
+
+bool CompressedBulkWriter::write(const void *data, size_t size) {
+    if (!writeFully(m_fd, data, static_cast<int64_t>(size))) return false;
+    m_crc = crc32c(m_crc, data, size);
+    m_fileSize += static_cast<int64_t>(size);
+    return true;
+}
+
+bool CompressedBulkReader::open(const std::string &path, std::string *error) {
+    m_path = path;
+    m_blocks.clear();
+    m_loaded = SIZE_MAX;
+    m_fd.reset(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat st;
+    if (!m_fd.isValid() || fstat(m_fd.get(), &st) != 0) {
+        *error = "Cannot open compressed bulk: " + path + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+    const int64_t fileSize = st.st_size;
+    CompressedBulkTrailer trailer;
+    const int64_t trailerOffset = fileSize - static_cast<int64_t>(sizeof(trailer));
+    bool ok = trailerOffset >= static_cast<int64_t>(sizeof(m_header))
+              && preadFully(m_fd.get(), &m_header, sizeof(m_header), 0) == sizeof(m_header)
+              && preadFully(m_fd.get(), &trailer, sizeof(trailer), trailerOffset) == sizeof(trailer)
+              && std::memcmp(m_header.magic, kBulkMagic, sizeof(kBulkMagic)) == 0
+              && std::memcmp(trailer.magic, kIndexMagic, sizeof(kIndexMagic)) == 0
+              && m_header.frameSize > 0 && m_header.blockBytes > 0
+              && trailer.indexOffset + uint64_t(trailer.blockCount) * sizeof(CompressedBlock)
+                     == static_cast<uint64_t>(trailerOffset);
+    if (ok) {
+        m_blocks.resize(trailer.blockCount);
+        const int64_t indexBytes = static_cast<int64_t>(m_blocks.size() * sizeof(CompressedBlock));
+        ok = preadFully(m_fd.get(), m_blocks.data(), indexBytes, static_cast<int64_t>(trailer.indexOffset))
+             == indexBytes;
+    }
+    // Blocks must tile the raw bulk and lie between the header and the index.
+    int64_t rawEnd = 0;
+    for (size_t i = 0; ok && i < m_blocks.size(); ++i) {
+        const CompressedBlock &block = m_blocks[i];
+        ok = block.rawSize > 0 && block.rawSize <= m_header.blockBytes
+             && (i + 1 == m_blocks.size() || block.rawSize == m_header.blockBytes)
+             && block.offset >= sizeof(m_header) && block.offset + block.size <= trailer.indexOffset
+             && ((block.flags & CompressedBlock::Stored) ? block.size == block.rawSize : block.size < block.rawSize);
+        rawEnd += block.rawSize;
+    }
+    if (!ok || rawEnd != m_header.rawLength) {
+        *error = "Not a compressed bulk or damaged: " + path;
+        return false;
+    }
+    m_codec = createBulkCodec(m_header.codec);
+    if (!m_codec) {
+        *error = "Compressed bulk uses a codec this build does not have (id " + std::to_string(m_header.codec)
+                 + "): " + path;
+        return false;
+    }
+    return true;
+}
+
+int64_t CompressedBulkReader::frameCount() const {
+    return (m_header.rawLength + m_header.frameSize - 1) / m_header.frameSize;
+}
+
+bool CompressedBulkReader::loadBlock(size_t index, std::string *error) {
+    if (index == m_loaded) return true;
+    m_loaded = SIZE_MAX;
+    const CompressedBlock &block = m_blocks[index];
+    const bool stored = (block.flags & CompressedBlock::Stored) != 0;
+    m_block.resize(block.rawSize);
+    char *target = stored ? m_block.data() : nullptr;
+    if (!stored) {
+        m_packed.resize(block.size);
+        target = m_packed.data();
+    }
+    if (preadFully(m_fd.get(), target, block.size, static_cast<int64_t>(block.offset)) != block.size) {
+        *error = "Failed to read compressed bulk: " + m_path + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+    if ((!stored && !m_codec->decompress(m_packed.data(), block.size, m_block.data(), block.rawSize))
+        || crc32c(0, m_block.data(), block.rawSize) != block.crc32c) {
+        *error = "Damaged block " + std::to_string(index) + " in compressed bulk: " + m_path;
+        return false;
+    }
+    m_loaded = index;
+    return true;
+}
+
+bool CompressedBulkReader::read(int64_t offset, int64_t length, std::string *out, std::string *error) {
+    out->clear();
+    if (offset < 0 || length < 0 || offset + length > m_header.rawLength) {
+        *error = "Read past the end of compressed bulk: " + m_path;
+        return false;
+    }
+    out->reserve(static_cast<size_t>(length));
+    // Every block but the last holds blockBytes, so the first one is found by division.
+    const int64_t blockBytes = m_header.blockBytes;
+    for (int64_t at = offset; at < offset + length;) {
+        const size_t index = static_cast<size_t>(at / blockBytes);
+        if (!loadBlock(index, error)) return false;
+        const int64_t within = at - static_cast<int64_t>(index) * blockBytes;
+        const int64_t take = std::min<int64_t>(m_blocks[index].rawSize - within, offset + length - at);
+        out->append(m_block.data() + within, static_cast<size_t>(take));
+        at += take;
+    }
+    return true;
+}
+
+bool CompressedBulkReader::readFrame(int64_t n, std::string *out, std::string *error) {
+    const int64_t offset = n * m_header.frameSize;
+    if (n < 0 || offset >= m_header.rawLength) {
+        *error = "No frame " + std::to_string(n) + " in compressed bulk: " + m_path;
+        return false;
+    }
+    return read(offset, std::min<int64_t>(m_header.frameSize, m_header.rawLength - offset), out, error);
+}
@@ -0,0 +1,97 @@
+#ifndef COMPRESSEDBULK_H
+#define COMPRESSEDBULK_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bulkcodec.h"
+#include "posixio.h"
+
+// On-disk layout of a compressed bulk (.cbin), in host byte order: the
+// header, the blocks one after another, the block index and the trailer.
+// Every block holds blockBytes of the raw bulk, except a shorter last one,
+// and is compressed on its own, so any byte range is restored by decoding
+// only the blocks it touches. The trailer is at the end of the file and
+// points at the index, which lets the writer stream the blocks out first.
+struct CompressedBulkHeader {
+    char magic[8];        // "BSCBULK1"
+    uint32_t codec;       // BulkCodec::id()
+    uint32_t blockBytes;  // Raw bytes per block, a whole number of frames
+    uint32_t frameSize;
+    uint32_t reserved;
+    int64_t rawLength;    // Size of the bulk before compression
+};
+
+struct CompressedBlock {
+    enum Flags : uint32_t {
+        Stored = 1  // The codec could not shrink the block; it is kept raw
+    };
+
+    uint64_t offset;  // File offset of the block
+    uint32_t size;    // Bytes in the file
+    uint32_t rawSize;
+    uint32_t crc32c;  // Of the raw block
+    uint32_t flags;
+};
+
+struct CompressedBulkTrailer {
+    uint64_t indexOffset;
+    uint32_t blockCount;
+    char magic[4];  // "BIDX"
+};
+
+// Streams a compressed bulk to a descriptor front to back: begin(), the
+// blocks in order, finish(). Also hashes everything it writes, so the file
+// checksum needs no second pass. Failures leave errno set.
+class CompressedBulkWriter {
+public:
+    bool begin(int fd, uint32_t codec, uint32_t blockBytes, uint32_t frameSize, int64_t rawLength);
+    bool addBlock(const char *data, uint32_t size, uint32_t rawSize, uint32_t rawCrc, bool stored);
+    bool finish();
+
+    int64_t fileSize() const { return m_fileSize; }
+    uint32_t fileCrc32c() const { return m_crc; }
+
+private:
+    bool write(const void *data, size_t size);
+
+    int m_fd = -1;
+    int64_t m_fileSize = 0;
+    uint32_t m_crc = 0;
+    std::vector<CompressedBlock> m_blocks;
+};
+
+// Random access to the raw content of a compressed bulk. A read decodes the
+// blocks it overlaps and checks them against their CRC32C; the block decoded
+// last is kept, so reading frame after frame decodes each block once.
+class CompressedBulkReader {
+public:
+    bool open(const std::string &path, std::string *error);
+
+    int64_t rawLength() const { return m_header.rawLength; }
+    int frameSize() const { return static_cast<int>(m_header.frameSize); }
+    int64_t frameCount() const;
+    const BulkCodec &codec() const { return *m_codec; }
+    const std::vector<CompressedBlock> &blocks() const { return m_blocks; }
+
+    // Fills out with length raw bytes from offset; false past the end or on
+    // a damaged block.
+    bool read(int64_t offset, int64_t length, std::string *out, std::string *error);
+    // Frame n of the bulk; the last one may be partial.
+    bool readFrame(int64_t n, std::string *out, std::string *error);
+
+private:
+    bool loadBlock(size_t index, std::string *error);
+
+    std::string m_path;
+    UniqueFd m_fd;
+    CompressedBulkHeader m_header{};
+    std::vector<CompressedBlock> m_blocks;
+    std::unique_ptr<BulkCodec> m_codec;
+    std::vector<char> m_packed;
+    std::vector<char> m_block;
+    size_t m_loaded = SIZE_MAX;  // Block now in m_block
+};
+
+#endif // COMPRESSEDBULK_H
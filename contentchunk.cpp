@@ -0,0 +1,180 @@
+#include "contentchunk.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// The Gear table decides where bulks are cut, so it is fixed for good: bulks
+// written by an earlier version only line up with this one's if it never
+// changes. SplitMix64 from a constant seed fills it.
+constexpr std::array<uint64_t, 256> makeGearTable() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x6a09e667f3bcc908ull;
+    for (uint64_t &entry : table) {
+        state += 0x9e3779b97f4a7c15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        entry = z ^ (z >> 31);
+    }
+    return table;
+}
+
+constexpr std::array<uint64_t, 256> kGear = makeGearTable();
+
+// Mask over the top bits of the hash, which depend on the most bytes.
+uint64_t topBits(int bits) {
+    return bits <= 0 ? 0 : ~uint64_t(0) << (64 - std::min(bits, 64));
+}
+
+const uint64_t kPrime1 = 0x9e3779b185ebca87ull;
+const uint64_t kPrime2 = 0xc2b2ae3d27d4eb4full;
+const uint64_t kPrime3 = 0x165667b19e3779f9ull;
+const uint64_t kPrime4 = 0x85ebca77c2b2ae63ull;
+const uint64_t kPrime5 = 0x27d4eb2f165667c5ull;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t load64(const unsigned char *p) {
+    uint64_t word;
+    std::memcpy(&word, p, 8);
+    return word;
+}
+
+inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+    return rotl(acc + input * kPrime2, 31) * kPrime1;
+}
+
+inline uint64_t xxhMerge(uint64_t acc, uint64_t value) {
+    return (acc ^ xxhRound(0, value)) * kPrime1 + kPrime4;
+}
+
+} // namespace
+
+FrameChunker::FrameChunker(const ContentChunking &chunking, int64_t frameSize)
+    : m_frameSize(frameSize), m_window(static_cast<int>(std::min<int64_t>(frameSize, 64))) {
+    m_minFrames = std::max<int64_t>(1, (chunking.minBytes + frameSize - 1) / frameSize);
+    m_maxFrames = std::max(m_minFrames, chunking.maxBytes / frameSize);
+    m_avgFrames = std::min(std::max(m_minFrames, (chunking.avgBytes + frameSize / 2) / frameSize), m_maxFrames);
+    // A cut chance of 2^-bits per boundary past the minimum puts the average
+    // cut about 2^bits frames after it.
+    const int64_t spread = m_avgFrames - m_minFrames;
+    const int bits = spread > 0 ? static_cast<int>(std::lround(std::log2(static_cast<double>(spread)))) : 0;
+    m_hardMask = topBits(bits > 0 ? bits + 1 : 0);
+    m_easyMask = topBits(bits - 1);
+}
+
+uint64_t FrameChunker::tailHash(const char *frame) const {
+    const unsigned char *tail = reinterpret_cast<const unsigned char *>(frame) + m_frameSize - m_window;
+    uint64_t hash = 0;
+    for (int i = 0; i < m_window; ++i) hash = (hash << 1) + kGear[tail[i]];
+    return hash;
+}
+
+// Frames before the minimum are never hashed. Past it, four tails are hashed
+// in one loop: the table lookups of one frame do not wait on another's, so
+// they overlap where a single chain of shifts and adds would stall.
+size_t FrameChunker::findCut(const char *frames, size_t count, int64_t bulkBytes) const {
+    const int64_t bulkFrames = bulkBytes / m_frameSize;
+    size_t i = static_cast<size_t>(std::max<int64_t>(0, m_minFrames - bulkFrames - 1));
+    if (i >= count) return 0;
+    const size_t untilMax = static_cast<size_t>(std::max<int64_t>(1, m_maxFrames - bulkFrames));
+    const size_t last = std::min(count, untilMax);
+
+    while (i < last) {
+        uint64_t hashes[4] = {0, 0, 0, 0};
+        const size_t group = std::min<size_t>(4, last - i);
+        if (group == 4) {
+            const unsigned char *tails[4];
+            for (int k = 0; k < 4; ++k) {
+                tails[k] = reinterpret_cast<const unsigned char *>(frames + (i + k) * m_frameSize) + m_frameSize
+                           - m_window;
+            }
+            for (int b = 0; b < m_window; ++b) {
+                hashes[0] = (hashes[0] << 1) + kGear[tails[0][b]];
+                hashes[1] = (hashes[1] << 1) + kGear[tails[1][b]];
+                hashes[2] = (hashes[2] << 1) + kGear[tails[2][b]];
+                hashes[3] = (hashes[3] << 1) + kGear[tails[3][b]];
+            }
+        } else {
+            for (size_t k = 0; k < group; ++k) hashes[k] = tailHash(frames + (i + k) * m_frameSize);
+        }
+        for (size_t k = 0; k < group; ++k) {
+            const int64_t framesAfter = bulkFrames + static_cast<int64_t>(i + k) + 1;
+            const uint64_t mask = framesAfter < m_avgFrames ? m_hardMask : m_easyMask;
+            if ((hashes[k] & mask) == 0) return i + k + 1;
+        }
+        i += group;
+    }
+    return untilMax <= count ? untilMax : 0;
+}
+
+Xxh64::Xxh64() {
+    m_acc[0] = kPrime1 + kPrime2;
+    m_acc[1] = kPrime2;
+    m_acc[2] = 0;
+    m_acc[3] = 0 - kPrime1;
+}
+
+void Xxh64::update(const void *data, size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    m_total += size;
+    if (m_buffered > 0) {
+        const size_t piece = std::min(size, sizeof(m_buffer) - m_buffered);
+        std::memcpy(m_buffer + m_buffered, p, piece);
+        m_buffered += piece;
+        p += piece;
+        size -= piece;
+        if (m_buffered < sizeof(m_buffer)) return;
+        for (int k = 0; k < 4; ++k) m_acc[k] = xxhRound(m_acc[k], load64(m_buffer + 8 * k));
+        m_buffered = 0;
+    }
+    uint64_t acc0 = m_acc[0], acc1 = m_acc[1], acc2 = m_acc[2], acc3 = m_acc[3];
+    for (; size >= 32; p += 32, size -= 32) {
+        acc0 = xxhRound(acc0, load64(p));
+        acc1 = xxhRound(acc1, load64(p + 8));
+        acc2 = xxhRound(acc2, load64(p + 16));
+        acc3 = xxhRound(acc3, load64(p + 24));
+    }
+    m_acc[0] = acc0;
+    m_acc[1] = acc1;
+    m_acc[2] = acc2;
+    m_acc[3] = acc3;
+    std::memcpy(m_buffer, p, size);
+    m_buffered = size;
+}
+
+uint64_t Xxh64::digest() const {
+    uint64_t hash;
+    if (m_total >= 32) {
+        hash = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+        for (int k = 0; k < 4; ++k) hash = xxhMerge(hash, m_acc[k]);
+    } else {
+        hash = kPrime5;
+    }
+    hash += m_total;
+
+    const unsigned char *p = m_buffer;
+    size_t left = m_buffered;
+    for (; left >= 8; p += 8, left -= 8) hash = rotl(hash ^ xxhRound(0, load64(p)), 27) * kPrime1 + kPrime4;
+    if (left >= 4) {
+        uint32_t word;
+        std::memcpy(&word, p, 4);
+        hash = rotl(hash ^ (uint64_t(word) * kPrime1), 23) * kPrime2 + kPrime3;
+        p += 4;
+        left -= 4;
+    }
+    for (; left > 0; ++p, --left) hash = rotl(hash ^ (*p * kPrime5), 11) * kPrime1;
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
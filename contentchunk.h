@@ -0,0 +1,66 @@
+#ifndef CONTENTCHUNK_H
+#define CONTENTCHUNK_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Bulk sizes of a content-defined split. Cuts fall only on frame boundaries;
+// a bulk holds at least minBytes (rounded up to whole frames) and at most
+// maxBytes, and averages about avgBytes on data without repeats.
+struct ContentChunking {
+    int64_t minBytes = 0;
+    int64_t avgBytes = 0;  // 0 turns content-defined splitting off
+    int64_t maxBytes = 0;
+
+    bool isActive() const { return avgBytes > 0; }
+};
+
+// FastCDC-style cut detection restricted to frame boundaries. The Gear hash
+// h = (h << 1) + gear[byte] only remembers the last 64 bytes it saw, so its
+// value at a boundary is a function of the frame's tail alone and is computed
+// there directly instead of rolling through every byte. Bulks that start in
+// step therefore end in step wherever two inputs share a stretch of frames.
+// Below avgBytes a harder mask is used and above it an easier one, which pulls
+// bulk sizes towards the average (FastCDC's normalized chunking).
+class FrameChunker {
+public:
+    FrameChunker(const ContentChunking &chunking, int64_t frameSize);
+
+    // Checks the ends of count whole frames stored frameSize apart, where
+    // bulkBytes is the size of the current bulk before the first of them.
+    // Returns the number of frames up to and including the one that ends the
+    // bulk, or 0 when none does.
+    size_t findCut(const char *frames, size_t count, int64_t bulkBytes) const;
+
+    int64_t minFrames() const { return m_minFrames; }
+    int64_t maxFrames() const { return m_maxFrames; }
+
+private:
+    uint64_t tailHash(const char *frame) const;
+
+    int64_t m_frameSize;
+    int m_window;  // Tail bytes hashed per frame, at most 64
+    int64_t m_minFrames;
+    int64_t m_avgFrames;
+    int64_t m_maxFrames;
+    uint64_t m_hardMask;  // Before the average size
+    uint64_t m_easyMask;  // After it
+};
+
+// Streaming XXH64 (seed 0), which names content-defined bulks. It runs far
+// faster than the data arrives, and together with the bulk length it makes
+// two different bulks sharing a name vanishingly unlikely.
+class Xxh64 {
+public:
+    Xxh64();
+    void update(const void *data, size_t size);
+    uint64_t digest() const;
+
+private:
+    uint64_t m_acc[4];
+    unsigned char m_buffer[32];
+    size_t m_buffered = 0;
+    uint64_t m_total = 0;
+};
+
+#endif // CONTENTCHUNK_H
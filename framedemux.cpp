@@ -0,0 +1,121 @@
+#include "framedemux.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sys/uio.h>
+
+uint32_t ChannelField::channelOf(const char *frame) const {
+    const unsigned char *bytesAt = reinterpret_cast<const unsigned char *>(frame + offset);
+    uint32_t word = 0;
+    for (int i = 0; i < bytes; ++i) word = (word << 8) | bytesAt[i];
+    word &= mask;
+    return mask ? word >> __builtin_ctz(mask) : 0;
+}
+
+bool parseChannelField(const std::string &text, ChannelField *field, std::string *error) {
+    const size_t slash = text.find('/');
+    char *end = nullptr;
+    const long offset = slash == 0 || text.empty() ? -1 : std::strtol(text.c_str(), &end, 0);
+    if (offset < 0 || offset > std::numeric_limits<int>::max() - 4
+        || end != text.c_str() + (slash == std::string::npos ? text.size() : slash)) {
+        *error = "Expected <offset>[/<mask>] for the channel field: " + text;
+        return false;
+    }
+    ChannelField parsed;
+    parsed.offset = static_cast<int>(offset);
+    parsed.bytes = 1;
+    parsed.mask = 0xff;
+    if (slash != std::string::npos) {
+        const std::string mask = text.substr(slash + 1);
+        const bool hex = std::all_of(mask.begin(), mask.end(), [](char c) {
+            return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+        });
+        if (!hex || mask.empty() || mask.size() % 2 != 0 || mask.size() > 8) {
+            *error = "Channel field mask must be 1 to 4 bytes of hex: " + text;
+            return false;
+        }
+        parsed.bytes = static_cast<int>(mask.size() / 2);
+        parsed.mask = static_cast<uint32_t>(std::strtoul(mask.c_str(), nullptr, 16));
+        if (parsed.mask == 0) {
+            *error = "Channel field mask selects no bits: " + text;
+            return false;
+        }
+    }
+    *field = parsed;
+    return true;
+}
+
+WriteCombiner::WriteCombiner(size_t budgetBytes, size_t blockBytes, size_t maxStreamBytes, const Flush &flush)
+    : m_blockBytes(std::max<size_t>(blockBytes, 1)), m_maxStreamBytes(std::max(maxStreamBytes, m_blockBytes)),
+      m_flush(flush) {
+    // Two blocks at least, so a stream being filled never has to flush itself
+    // to make room for its own next block.
+    const size_t blocks = std::max<size_t>(2, budgetBytes / m_blockBytes);
+    m_memory.reset(new char[blocks * m_blockBytes]);
+    m_freeBlocks.reserve(blocks);
+    for (size_t i = blocks; i > 0; --i) m_freeBlocks.push_back(static_cast<int>(i - 1));
+    m_iovecs.resize(blocks);
+}
+
+WriteCombiner::~WriteCombiner() = default;
+
+bool WriteCombiner::append(int stream, const char *data, size_t size) {
+    if (static_cast<size_t>(stream) >= m_streams.size()) m_streams.resize(static_cast<size_t>(stream) + 1);
+    while (size > 0) {
+        const size_t used = m_streams[stream].bytes % m_blockBytes;
+        if (used == 0) {
+            // The last block is full, or there is none yet.
+            if (m_streams[stream].bytes >= m_maxStreamBytes && !flush(stream)) return false;
+            if (m_freeBlocks.empty() && !flushLargest()) return false;
+            m_streams[stream].blocks.push_back(m_freeBlocks.back());
+            m_freeBlocks.pop_back();
+        }
+        Stream &target = m_streams[stream];
+        const size_t piece = std::min(size, m_blockBytes - used);
+        std::memcpy(m_memory.get() + static_cast<size_t>(target.blocks.back()) * m_blockBytes + used, data, piece);
+        target.bytes += piece;
+        data += piece;
+        size -= piece;
+    }
+    return true;
+}
+
+bool WriteCombiner::flush(int stream) {
+    if (static_cast<size_t>(stream) >= m_streams.size()) return true;
+    Stream &source = m_streams[stream];
+    if (source.bytes == 0) return true;
+    size_t left = source.bytes;
+    for (size_t i = 0; i < source.blocks.size(); ++i) {
+        m_iovecs[i].iov_base = m_memory.get() + static_cast<size_t>(source.blocks[i]) * m_blockBytes;
+        m_iovecs[i].iov_len = std::min(left, m_blockBytes);
+        left -= m_iovecs[i].iov_len;
+    }
+    const bool ok = m_flush(stream, m_iovecs.data(), static_cast<int>(source.blocks.size()),
+                            static_cast<int64_t>(source.bytes));
+    m_freeBlocks.insert(m_freeBlocks.end(), source.blocks.begin(), source.blocks.end());
+    source.blocks.clear();
+    source.bytes = 0;
+    return ok;
+}
+
+bool WriteCombiner::flushAll() {
+    for (size_t i = 0; i < m_streams.size(); ++i) {
+        if (!flush(static_cast<int>(i))) return false;
+    }
+    return true;
+}
+
+size_t WriteCombiner::bufferedBytes(int stream) const {
+    return static_cast<size_t>(stream) < m_streams.size() ? m_streams[stream].bytes : 0;
+}
+
+bool WriteCombiner::flushLargest() {
+    size_t largest = 0;
+    for (size_t i = 1; i < m_streams.size(); ++i) {
+        if (m_streams[i].bytes > m_streams[largest].bytes) largest = i;
+    }
+    return flush(static_cast<int>(largest));
+}
@@ -0,0 +1,69 @@
+#ifndef FRAMEDEMUX_H
+#define FRAMEDEMUX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct iovec;
+
+// Where a frame header holds its channel: bytes [offset, offset + bytes) read
+// big-endian, ANDed with mask and shifted down past the mask's trailing zeros.
+struct ChannelField {
+    int offset = 0;
+    int bytes = 0;  // 0 turns demultiplexing off
+    uint32_t mask = 0;
+
+    bool isActive() const { return bytes > 0; }
+    int headerBytes() const { return offset + bytes; }
+    uint32_t channelOf(const char *frame) const;
+};
+
+// Parses "<offset>" (one whole byte) or "<offset>/<maskhex>", where the mask
+// also gives the width, e.g. "3" or "4/0fc0" for bits 6-11 of a 16-bit field.
+bool parseChannelField(const std::string &text, ChannelField *field, std::string *error);
+
+// Write-combining buffers for many output streams that share one memory
+// budget. Appended bytes are copied into fixed blocks; a stream is flushed as
+// one gathered write when it reaches maxStreamBytes, and when the blocks run
+// out the stream holding the most is flushed to free them. Few streams thus
+// get large writes, hundreds still get writes of budget / streams on average,
+// and memory never exceeds the budget however many streams there are.
+class WriteCombiner {
+public:
+    // Receives a stream's buffered bytes in order; false aborts the append. The
+    // iovecs are scratch space the callback may modify, e.g. with writevFully().
+    using Flush = std::function<bool(int stream, iovec *iov, int count, int64_t bytes)>;
+
+    WriteCombiner(size_t budgetBytes, size_t blockBytes, size_t maxStreamBytes, const Flush &flush);
+    ~WriteCombiner();
+    WriteCombiner(const WriteCombiner &) = delete;
+    WriteCombiner &operator=(const WriteCombiner &) = delete;
+
+    // Streams are numbered densely from 0 and created on first use.
+    bool append(int stream, const char *data, size_t size);
+    bool flush(int stream);
+    bool flushAll();
+    size_t bufferedBytes(int stream) const;
+
+private:
+    struct Stream {
+        std::vector<int> blocks;
+        size_t bytes = 0;
+    };
+
+    bool flushLargest();
+
+    size_t m_blockBytes;
+    size_t m_maxStreamBytes;
+    Flush m_flush;
+    std::unique_ptr<char[]> m_memory;
+    std::vector<int> m_freeBlocks;
+    std::vector<Stream> m_streams;
+    std::vector<iovec> m_iovecs;
+};
+
+#endif // FRAMEDEMUX_H
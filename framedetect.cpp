@@ -0,0 +1,84 @@
+#include "framedetect.h"
+
+#include <algorithm>
+#include <limits>
+#include "framesync.h"
+
+namespace {
+// Pairs counted per sync word. The real successor is usually the first one;
+// the rest absorbs payload matches that fall in between.
+const size_t kMaxPairsPerHit = 16;
+// Enough sync words to settle the histogram; keeps short or degenerate sync
+// words in long runs of identical bytes from turning the sample into a scan.
+const size_t kMaxHitsPerWindow = 16384;
+}
+
+FramePeriodDetector::FramePeriodDetector(const std::string &syncWord, int maxFrameSize)
+    : m_sync(syncWord), m_maxFrameSize(std::max(maxFrameSize, 1)),
+      m_histogram(static_cast<size_t>(m_maxFrameSize) + 1, 0) {}
+
+void FramePeriodDetector::addWindow(const char *data, size_t size) {
+    size = std::min<size_t>(size, std::numeric_limits<uint32_t>::max());
+    Window window{{}, size};
+    if (m_sync.empty()) return;
+
+    for (size_t pos = 0; pos < size && window.hits.size() < kMaxHitsPerWindow;) {
+        const char *hit = findSyncWord(data + pos, size - pos, m_sync.data(), m_sync.size());
+        if (!hit) break;
+        window.hits.push_back(static_cast<uint32_t>(hit - data));
+        pos = static_cast<size_t>(hit - data) + 1;
+    }
+    if (window.hits.size() == kMaxHitsPerWindow) window.size = window.hits.back() + size_t(1);  // Scanned part
+
+    // Frames can't be shorter than their sync word, so closer pairs are overlaps.
+    const std::vector<uint32_t> &hits = window.hits;
+    for (size_t i = 0; i < hits.size(); ++i) {
+        const size_t last = std::min(hits.size(), i + 1 + kMaxPairsPerHit);
+        for (size_t j = i + 1; j < last; ++j) {
+            const uint32_t distance = hits[j] - hits[i];
+            if (distance > static_cast<uint32_t>(m_maxFrameSize)) break;
+            if (distance > m_sync.size()) ++m_histogram[distance];
+        }
+    }
+    m_windows.push_back(std::move(window));
+}
+
+FrameDetection FramePeriodDetector::result() const {
+    FrameDetection detection;
+    detection.windows = static_cast<int>(m_windows.size());
+    for (const Window &window : m_windows) detection.syncCount += static_cast<int64_t>(window.hits.size());
+
+    // Ties go to the shorter period; its multiples always score slightly lower.
+    size_t period = 0;
+    for (size_t distance = 1; distance < m_histogram.size(); ++distance) {
+        if (m_histogram[distance] > m_histogram[period]) period = distance;
+    }
+    if (period == 0 || m_histogram[period] == 0) return detection;
+    detection.frameSize = static_cast<int>(period);
+
+    // A sync word is confirmed when another one sits exactly one period later.
+    // Slots are the period steps between the first confirmed sync word of a
+    // sample and its end; in a clean capture every slot holds a confirmed one.
+    const size_t syncSize = m_sync.size();
+    int64_t checkable = 0;
+    int64_t confirmed = 0;
+    int64_t slots = 0;
+    for (const Window &window : m_windows) {
+        if (window.size < period + syncSize) continue;
+        const size_t lastStart = window.size - period - syncSize;
+        const std::vector<uint32_t> &hits = window.hits;
+        int64_t first = -1;
+        for (uint32_t hit : hits) {
+            if (hit > lastStart) break;
+            ++checkable;
+            if (std::binary_search(hits.begin(), hits.end(), static_cast<uint32_t>(hit + period))) {
+                ++confirmed;
+                if (first < 0) first = hit;
+            }
+        }
+        slots += static_cast<int64_t>((lastStart - (first < 0 ? 0 : static_cast<size_t>(first))) / period + 1);
+    }
+    if (checkable > 0) detection.confidence = static_cast<double>(confirmed) / checkable;
+    if (slots > 0) detection.lockRatio = std::min(1.0, static_cast<double>(confirmed) / slots);
+    return detection;
+}
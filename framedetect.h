@@ -0,0 +1,43 @@
+#ifndef FRAMEDETECT_H
+#define FRAMEDETECT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Outcome of a frame period search.
+struct FrameDetection {
+    int frameSize = -1;        // Dominant sync word period, -1 if none was found
+    double confidence = 0.0;   // Share of sync words followed by another one a period later
+    double lockRatio = 0.0;    // Share of sampled frame slots that held the sync word
+    int64_t syncCount = 0;     // Sync words found in the samples
+    int windows = 0;           // Samples analysed
+};
+
+// Estimates the frame size from samples of a capture. Every sync word in a
+// sample is paired with the ones following it within maxFrameSize bytes and the
+// distances are collected in a histogram, so stray sync patterns in the payload
+// add noise to many bins but cannot outvote the real period.
+class FramePeriodDetector {
+public:
+    FramePeriodDetector(const std::string &syncWord, int maxFrameSize);
+
+    // Analyses one contiguous sample. Samples are independent of each other.
+    void addWindow(const char *data, size_t size);
+
+    FrameDetection result() const;
+
+private:
+    struct Window {
+        std::vector<uint32_t> hits;  // Sync word offsets within the sample
+        size_t size;
+    };
+
+    std::string m_sync;
+    int m_maxFrameSize;
+    std::vector<uint32_t> m_histogram;  // Indexed by distance in bytes
+    std::vector<Window> m_windows;
+};
+
+#endif // FRAMEDETECT_H
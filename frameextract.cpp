@@ -0,0 +1,95 @@
+#include "frameextract.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+bool parseHexBytes(const std::string &text, uint64_t *bytes, int *length) {
+    if (text.empty() || text.size() % 2 != 0 || text.size() > 16) return false;
+    uint64_t word = 0;
+    for (size_t i = 0; i < text.size(); i += 2) {
+        if (!std::isxdigit(static_cast<unsigned char>(text[i]))
+            || !std::isxdigit(static_cast<unsigned char>(text[i + 1]))) {
+            return false;
+        }
+        const uint64_t byte = std::strtoul(text.substr(i, 2).c_str(), nullptr, 16);
+        // Byte i / 2 of the header goes to the same place a memcpy load puts it.
+        std::memcpy(reinterpret_cast<char *>(&word) + i / 2, &byte, 1);
+    }
+    *bytes = word;
+    *length = static_cast<int>(text.size() / 2);
+    return true;
+}
+
+// Loads the predicate's header bytes of one frame into the low bytes of a word.
+inline uint64_t loadHeader(const char *frame, const HeaderPredicate &predicate) {
+    uint64_t word = 0;
+    std::memcpy(&word, frame + predicate.offset, static_cast<size_t>(predicate.length));
+    return word;
+}
+
+} // namespace
+
+bool parseHeaderPredicate(const std::string &text, HeaderPredicate *predicate, std::string *error) {
+    const size_t equals = text.find('=');
+    const size_t slash = text.find('/', equals == std::string::npos ? 0 : equals);
+    char *end = nullptr;
+    const long offset = equals == std::string::npos || equals == 0 ? -1 : std::strtol(text.c_str(), &end, 0);
+    if (offset < 0 || offset > std::numeric_limits<int>::max() - 8 || end != text.c_str() + equals) {
+        *error = "Expected <offset>=<hex>[/<mask>] in header predicate: " + text;
+        return false;
+    }
+    HeaderPredicate parsed;
+    parsed.offset = static_cast<int>(offset);
+    const std::string value = text.substr(equals + 1, slash == std::string::npos ? std::string::npos : slash - equals - 1);
+    if (!parseHexBytes(value, &parsed.value, &parsed.length)) {
+        *error = "Header predicate value must be 1 to 8 bytes of hex: " + text;
+        return false;
+    }
+    if (slash == std::string::npos) {
+        parsed.mask = parsed.length == 8 ? ~uint64_t(0) : (uint64_t(1) << (8 * parsed.length)) - 1;
+    } else {
+        int maskLength = 0;
+        if (!parseHexBytes(text.substr(slash + 1), &parsed.mask, &maskLength) || maskLength != parsed.length) {
+            *error = "Header predicate mask must be as long as its value: " + text;
+            return false;
+        }
+    }
+    parsed.value &= parsed.mask;
+    *predicate = parsed;
+    return true;
+}
+
+int FrameFilter::headerBytes() const {
+    int bytes = 0;
+    for (const HeaderPredicate &predicate : predicates) bytes = std::max(bytes, predicate.offset + predicate.length);
+    return bytes;
+}
+
+// Each predicate costs one load, AND and compare per frame, and the match
+// index is stored unconditionally so the loop has no data-dependent branch.
+size_t FrameFilter::match(const char *frames, size_t count, int64_t frameSize, uint32_t *matches) const {
+    size_t found = 0;
+    if (predicates.size() == 1) {
+        const HeaderPredicate &predicate = predicates.front();
+        for (size_t i = 0; i < count; ++i) {
+            matches[found] = static_cast<uint32_t>(i);
+            found += (loadHeader(frames + i * frameSize, predicate) & predicate.mask) == predicate.value;
+        }
+        return found;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const char *frame = frames + i * frameSize;
+        bool keep = true;
+        for (const HeaderPredicate &predicate : predicates) {
+            keep &= (loadHeader(frame, predicate) & predicate.mask) == predicate.value;
+        }
+        matches[found] = static_cast<uint32_t>(i);
+        found += keep;
+    }
+    return found;
+}
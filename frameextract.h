@@ -0,0 +1,45 @@
+#ifndef FRAMEEXTRACT_H
+#define FRAMEEXTRACT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Header bytes [offset, offset + length) of a frame, ANDed with mask, must
+// equal value. Bytes are in file order; length is at most 8, so one predicate
+// is a single masked 64-bit compare.
+struct HeaderPredicate {
+    int offset = 0;
+    int length = 0;
+    uint64_t value = 0;
+    uint64_t mask = 0;
+};
+
+// Parses "<offset>=<hex>" or "<offset>=<hex>/<maskhex>", e.g. "4=0a" or
+// "6=1200/ff00". The mask defaults to all ones and must match the value's length.
+bool parseHeaderPredicate(const std::string &text, HeaderPredicate *predicate, std::string *error);
+
+// Which whole frames of the input an extraction keeps: every everyNth frame of
+// [firstFrame, endFrame), counted from firstFrame, whose header satisfies all
+// predicates. Frames are numbered from 0 at frameSizeBytes steps from the start
+// of the file, as in a plain split.
+class FrameFilter {
+public:
+    int64_t firstFrame = 0;
+    int64_t endFrame = -1;  // Exclusive; -1 runs to the last whole frame
+    int64_t everyNth = 1;
+    std::vector<HeaderPredicate> predicates;
+
+    // False for the default filter, which keeps every frame and is just a split.
+    bool isActive() const { return firstFrame > 0 || endFrame >= 0 || everyNth > 1 || !predicates.empty(); }
+
+    // One past the last header byte any predicate reads.
+    int headerBytes() const;
+
+    // Checks count frames stored frameSize apart at frames and writes the
+    // indices of the matches to matches. Returns the number of matches.
+    size_t match(const char *frames, size_t count, int64_t frameSize, uint32_t *matches) const;
+};
+
+#endif // FRAMEEXTRACT_H
@@ -0,0 +1,160 @@
+#include "frameindex.h"
+#include "posixio.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char kMagic[4] = {'F', 'I', 'D', 'X'};
+const uint32_t kVersion = 1;
+static_assert(sizeof(FrameIndexHeader) == 72, "FrameIndexHeader is part of the file format");
+static_assert(sizeof(FrameIndexRun) == 32, "FrameIndexRun is part of the file format");
+}
+
+std::string frameIndexPath(const std::string &inputPath) {
+    return inputPath + ".fidx";
+}
+
+void FrameIndexWriter::reset(int64_t inputSize, int64_t inputMtimeNs, int frameSize,
+                             const std::string &syncWord, uint32_t flags) {
+    m_header = FrameIndexHeader();
+    std::memcpy(m_header.magic, kMagic, sizeof(kMagic));
+    m_header.version = kVersion;
+    m_header.inputSize = inputSize;
+    m_header.inputMtimeNs = inputMtimeNs;
+    m_header.frameSize = static_cast<uint32_t>(frameSize);
+    m_header.flags = flags;
+    m_header.syncWordSize = static_cast<uint32_t>(std::min(syncWord.size(), sizeof(m_header.syncWord)));
+    std::memcpy(m_header.syncWord, syncWord.data(), m_header.syncWordSize);
+    m_runs.clear();
+}
+
+void FrameIndexWriter::addFrames(int64_t offset, int64_t count, int bulk, uint32_t flags) {
+    const uint32_t stride = m_header.frameSize;
+    while (count > 0) {
+        if (!m_runs.empty()) {
+            FrameIndexRun &last = m_runs.back();
+            const bool continues = last.count > 0 && last.bulk == static_cast<uint32_t>(bulk)
+                                   && last.flags == flags
+                                   && last.offset + int64_t(last.count) * stride == offset
+                                   && last.count < std::numeric_limits<uint32_t>::max();
+            if (continues) {
+                const int64_t added = std::min<int64_t>(count, std::numeric_limits<uint32_t>::max() - last.count);
+                last.count += static_cast<uint32_t>(added);
+                offset += added * stride;
+                count -= added;
+                continue;
+            }
+        }
+        const int64_t added = std::min<int64_t>(count, std::numeric_limits<uint32_t>::max());
+        m_runs.push_back({0, offset, static_cast<uint32_t>(added), stride, static_cast<uint32_t>(bulk), flags});
+        offset += added * stride;
+        count -= added;
+    }
+}
+
+void FrameIndexWriter::addGap(int64_t offset, int64_t length) {
+    while (length > 0) {
+        const int64_t part = std::min<int64_t>(length, std::numeric_limits<uint32_t>::max());
+        m_runs.push_back({0, offset, 0, static_cast<uint32_t>(part), FrameIndexRun::kNoBulk, 0});
+        offset += part;
+        length -= part;
+    }
+}
+
+bool FrameIndexWriter::write(const std::string &path, std::string *error) const {
+    // Gaps are reported after the frames around them; number frames in input order.
+    std::vector<FrameIndexRun> runs(m_runs);
+    std::stable_sort(runs.begin(), runs.end(), [](const FrameIndexRun &a, const FrameIndexRun &b) {
+        return a.offset < b.offset;
+    });
+    FrameIndexHeader header = m_header;
+    uint64_t frameNumber = 0;
+    for (FrameIndexRun &run : runs) {
+        run.firstFrame = frameNumber;
+        frameNumber += run.count;
+    }
+    header.frameCount = frameNumber;
+    header.runCount = runs.size();
+
+    const std::string tempPath = path + ".tmp";
+    UniqueFd fd(::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666));
+    if (!fd.isValid() || !writeFully(fd.get(), &header, sizeof(header))
+        || !writeFully(fd.get(), runs.data(), static_cast<int64_t>(runs.size() * sizeof(FrameIndexRun)))) {
+        *error = "Failed to write frame index: " + path + " (" + std::strerror(errno) + ")";
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    fd.reset();
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        *error = "Failed to write frame index: " + path + " (" + std::strerror(errno) + ")";
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+FrameIndex::~FrameIndex() {
+    close();
+}
+
+bool FrameIndex::open(const std::string &path) {
+    close();
+    UniqueFd fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat st;
+    if (!fd.isValid() || fstat(fd.get(), &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FrameIndexHeader))) {
+        return false;
+    }
+    void *mapping = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd.get(), 0);
+    if (mapping == MAP_FAILED) return false;
+
+    const FrameIndexHeader *header = static_cast<const FrameIndexHeader *>(mapping);
+    const uint64_t runBytes = static_cast<uint64_t>(st.st_size) - sizeof(FrameIndexHeader);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion
+        || header->frameSize == 0 || header->syncWordSize > sizeof(header->syncWord)
+        || header->runCount != runBytes / sizeof(FrameIndexRun)) {
+        ::munmap(mapping, static_cast<size_t>(st.st_size));
+        return false;
+    }
+    m_mapping = mapping;
+    m_mappingSize = static_cast<size_t>(st.st_size);
+    m_header = header;
+    m_runs = reinterpret_cast<const FrameIndexRun *>(header + 1);
+    return true;
+}
+
+void FrameIndex::close() {
+    if (m_mapping) ::munmap(m_mapping, m_mappingSize);
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_header = nullptr;
+    m_runs = nullptr;
+}
+
+bool FrameIndex::matches(int64_t inputSize, int64_t inputMtimeNs) const {
+    return isOpen() && m_header->inputSize == inputSize && m_header->inputMtimeNs == inputMtimeNs;
+}
+
+bool FrameIndex::frame(int64_t n, FrameInfo *info) const {
+    if (!isOpen() || n < 0 || n >= frameCount()) return false;
+    // The last run starting at or before n holds it; runs without frames share
+    // their firstFrame with the run after them and are skipped by this search.
+    const FrameIndexRun *end = m_runs + runCount();
+    const FrameIndexRun *run = std::upper_bound(m_runs, end, static_cast<uint64_t>(n),
+                                                [](uint64_t value, const FrameIndexRun &r) {
+                                                    return value < r.firstFrame;
+                                                }) - 1;
+    const int64_t offset = run->offset + (n - static_cast<int64_t>(run->firstFrame)) * run->stride;
+    info->offset = offset;
+    info->length = std::min<int64_t>(run->stride, m_header->inputSize - offset);
+    info->bulk = static_cast<int>(run->bulk);
+    info->flags = run->flags;
+    return true;
+}
@@ -0,0 +1,108 @@
+#ifndef FRAMEINDEX_H
+#define FRAMEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk layout of a .fidx frame index, in host byte order. The file is a
+// header followed by runCount fixed-size runs sorted by input offset. A run
+// stands for count frames spaced stride bytes apart, so a capture of fixed-size
+// frames needs one run per bulk however many frames it holds. Bytes skipped by
+// resync are stored as runs without frames.
+struct FrameIndexHeader {
+    char magic[4];          // "FIDX"
+    uint32_t version;
+    int64_t inputSize;      // Input size and modification time when the index was built
+    int64_t inputMtimeNs;
+    uint32_t frameSize;
+    uint32_t flags;         // FrameIndexRun flags that hold for the whole index
+    uint32_t syncWordSize;
+    char syncWord[16];
+    uint32_t reserved;
+    uint64_t frameCount;
+    uint64_t runCount;
+};
+
+struct FrameIndexRun {
+    enum Flags : uint32_t {
+        SyncChecked = 1,  // The sync word was compared at each frame start
+        SyncValid = 2     // ... and matched
+    };
+    static const uint32_t kNoBulk = 0xffffffffu;
+
+    uint64_t firstFrame;  // Number of the first frame of the run
+    int64_t offset;       // Input offset of the first frame
+    uint32_t count;       // Frames in the run, 0 for skipped input
+    uint32_t stride;      // Frame size, or the skipped length when count is 0
+    uint32_t bulk;        // Bulk file number, kNoBulk for skipped input
+    uint32_t flags;
+};
+
+// One frame as resolved through the index.
+struct FrameInfo {
+    int64_t offset;
+    int64_t length;  // Shorter than the frame size only for a trailing partial frame
+    int bulk;
+    uint32_t flags;
+};
+
+// Sidecar path used for an input file.
+std::string frameIndexPath(const std::string &inputPath);
+
+// Collects runs while a split is running and writes the index once it is done.
+class FrameIndexWriter {
+public:
+    void reset(int64_t inputSize, int64_t inputMtimeNs, int frameSize, const std::string &syncWord,
+               uint32_t flags);
+
+    // Adds count frames of the configured size starting at offset. Frames that
+    // continue the previous run in the same bulk are merged into it.
+    void addFrames(int64_t offset, int64_t count, int bulk, uint32_t flags);
+    void addGap(int64_t offset, int64_t length);
+
+    // Writes to a temporary file that is renamed over path, so a reader never
+    // sees a partial index.
+    bool write(const std::string &path, std::string *error) const;
+
+private:
+    FrameIndexHeader m_header{};
+    std::vector<FrameIndexRun> m_runs;
+};
+
+// Read-only view of a .fidx file. open() maps the file and checks the header;
+// the runs are paged in by the kernel only when a lookup touches them.
+class FrameIndex {
+public:
+    FrameIndex() = default;
+    ~FrameIndex();
+    FrameIndex(const FrameIndex &) = delete;
+    FrameIndex &operator=(const FrameIndex &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    // True when the index was built from a file of this size and modification time.
+    bool matches(int64_t inputSize, int64_t inputMtimeNs) const;
+
+    int frameSize() const { return static_cast<int>(m_header->frameSize); }
+    uint32_t flags() const { return m_header->flags; }
+    std::string syncWord() const { return std::string(m_header->syncWord, m_header->syncWordSize); }
+    int64_t inputSize() const { return m_header->inputSize; }
+    int64_t frameCount() const { return static_cast<int64_t>(m_header->frameCount); }
+    size_t runCount() const { return static_cast<size_t>(m_header->runCount); }
+    const FrameIndexRun &run(size_t index) const { return m_runs[index]; }
+
+    // Resolves frame number n with a binary search over the runs.
+    bool frame(int64_t n, FrameInfo *info) const;
+
+private:
+    void *m_mapping = nullptr;
+    size_t m_mappingSize = 0;
+    const FrameIndexHeader *m_header = nullptr;
+    const FrameIndexRun *m_runs = nullptr;
+};
+
+#endif // FRAMEINDEX_H
@@ -0,0 +1,285 @@
+#include "frameinspector.h"
+
+#include <algorithm>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
+
+FrameInspectorModel::FrameInspectorModel(QObject *parent) : QAbstractListModel(parent),
+    m_fileSize(0),
+    m_frameSize(1111),
+    m_firstFrameOffset(0),
+    m_topLine(0),
+    m_visibleLines(32),
+    m_useCounter(0) {
+}
+
+FrameInspectorModel::~FrameInspectorModel() {
+    unmapAll();
+}
+
+int FrameInspectorModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(m_lines.size());
+}
+
+QVariant FrameInspectorModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() < 0 || index.row() >= static_cast<int>(m_lines.size())) return QVariant();
+    const Line &line = m_lines[index.row()];
+    switch (role) {
+    case OffsetRole: return QString("%1").arg(line.offset, 12, 16, QChar('0'));
+    case FrameRole: return line.frame;
+    case FrameStartRole: return line.frameStart;
+    case SyncRole: return line.sync;
+    case Qt::DisplayRole:
+    case HexRole: return line.hex;
+    case AsciiRole: return line.ascii;
+    default: return QVariant();
+    }
+}
+
+QHash<int, QByteArray> FrameInspectorModel::roleNames() const {
+    return {
+        {OffsetRole, "offset"},
+        {FrameRole, "frame"},
+        {FrameStartRole, "frameStart"},
+        {SyncRole, "sync"},
+        {HexRole, "hex"},
+        {AsciiRole, "ascii"},
+    };
+}
+
+qint64 FrameInspectorModel::preambleLines() const {
+    return (std::min(m_firstFrameOffset, m_fileSize) + kBytesPerLine - 1) / kBytesPerLine;
+}
+
+qint64 FrameInspectorModel::linesPerFrame() const {
+    return (m_frameSize + kBytesPerLine - 1) / kBytesPerLine;
+}
+
+qint64 FrameInspectorModel::frameCount() const {
+    const qint64 framed = m_fileSize - m_firstFrameOffset;
+    return framed > 0 ? (framed + m_frameSize - 1) / m_frameSize : 0;
+}
+
+// A trailing partial frame only has the lines its bytes fill.
+qint64 FrameInspectorModel::lineCount() const {
+    return m_fileSize > 0 ? lineForOffset(m_fileSize - 1) + 1 : 0;
+}
+
+qint64 FrameInspectorModel::lineForOffset(qint64 offset) const {
+    offset = std::max<qint64>(0, std::min(offset, m_fileSize - 1));
+    if (offset < m_firstFrameOffset) return offset / kBytesPerLine;
+    const qint64 framed = offset - m_firstFrameOffset;
+    return preambleLines() + framed / m_frameSize * linesPerFrame() + framed % m_frameSize / kBytesPerLine;
+}
+
+qint64 FrameInspectorModel::lineForFrame(qint64 frame) const {
+    return preambleLines() + std::max<qint64>(0, std::min(frame, frameCount() - 1)) * linesPerFrame();
+}
+
+bool FrameInspectorModel::isFrameStart(qint64 offset) const {
+    return offset >= m_firstFrameOffset && (offset - m_firstFrameOffset) % m_frameSize == 0;
+}
+
+bool FrameInspectorModel::alignToSyncWord() {
+    if (m_syncWord.isEmpty() || m_fileSize == 0) return false;
+    const qint64 searchBytes = std::min<qint64>(m_fileSize, m_frameSize + m_syncWord.size() - 1);
+    QByteArray head(searchBytes, Qt::Uninitialized);
+    head.truncate(read(0, searchBytes, head.data()));
+    const qint64 found = head.indexOf(m_syncWord);
+    if (found < 0 || found >= m_frameSize) return false;
+    setFirstFrameOffset(found);
+    return true;
+}
+
+void FrameInspectorModel::setFilePath(const QString &path) {
+    if (path == m_filePath) return;
+    unmapAll();
+    m_file.close();
+    m_filePath = path;
+    m_file.setFileName(path);
+    // Only the size is needed up front; pages are mapped as lines are shown.
+    m_fileSize = (!path.isEmpty() && m_file.open(QIODevice::ReadOnly)) ? m_file.size() : 0;
+    m_firstFrameOffset = 0;
+    relayout(0);
+}
+
+void FrameInspectorModel::setFrameSize(int size) {
+    if (size <= 0 || size == m_frameSize) return;
+    const qint64 keep = m_lines.isEmpty() ? 0 : m_lines.first().offset;
+    m_frameSize = size;
+    m_firstFrameOffset %= size;
+    relayout(keep);
+}
+
+void FrameInspectorModel::setSyncWord(const QString &hex) {
+    const QByteArray word = QByteArray::fromHex(hex.toLatin1());
+    if (word == m_syncWord) return;
+    m_syncWord = word;
+    emit frameLayoutChanged();
+    refresh();
+}
+
+void FrameInspectorModel::setFirstFrameOffset(qint64 offset) {
+    offset = std::max<qint64>(0, offset) % m_frameSize;
+    if (offset == m_firstFrameOffset) return;
+    const qint64 keep = m_lines.isEmpty() ? 0 : m_lines.first().offset;
+    m_firstFrameOffset = offset;
+    relayout(keep);
+}
+
+void FrameInspectorModel::setTopLine(qint64 line) {
+    line = std::max<qint64>(0, std::min(line, lineCount() - m_visibleLines));
+    if (line == m_topLine) return;
+    m_topLine = line;
+    refresh();
+    emit topLineChanged();
+}
+
+void FrameInspectorModel::setVisibleLines(int lines) {
+    lines = std::max(1, std::min(lines, 512));
+    if (lines == m_visibleLines) return;
+    m_visibleLines = lines;
+    emit visibleLinesChanged();
+    const qint64 top = m_topLine;
+    m_topLine = -1;
+    setTopLine(top);
+}
+
+void FrameInspectorModel::relayout(qint64 keepOffset) {
+    emit frameLayoutChanged();
+    m_topLine = -1;
+    setTopLine(m_fileSize > 0 ? lineForOffset(keepOffset) : 0);
+}
+
+void FrameInspectorModel::refresh() {
+    const qint64 available = std::max<qint64>(0, lineCount() - m_topLine);
+    QVector<Line> lines;
+    lines.reserve(static_cast<int>(std::min<qint64>(m_visibleLines, available)));
+    for (qint64 i = 0; i < m_visibleLines && i < available; ++i) lines.append(buildLine(m_topLine + i));
+
+    // Scrolling keeps the rows and swaps their contents, so the view reuses its delegates.
+    if (!lines.isEmpty() && lines.size() == m_lines.size()) {
+        m_lines.swap(lines);
+        emit dataChanged(index(0), index(m_lines.size() - 1));
+    } else {
+        beginResetModel();
+        m_lines.swap(lines);
+        endResetModel();
+    }
+}
+
+FrameInspectorModel::Line FrameInspectorModel::buildLine(qint64 number) {
+    Line line;
+    qint64 length;
+    const qint64 preamble = preambleLines();
+    if (number < preamble) {
+        line.offset = number * kBytesPerLine;
+        line.frame = -1;
+        line.frameStart = false;
+        length = std::min<qint64>(kBytesPerLine, m_firstFrameOffset - line.offset);
+    } else {
+        const qint64 perFrame = linesPerFrame();
+        const qint64 within = (number - preamble) % perFrame * kBytesPerLine;
+        line.frame = (number - preamble) / perFrame;
+        line.offset = m_firstFrameOffset + line.frame * m_frameSize + within;
+        line.frameStart = within == 0;
+        length = std::min<qint64>(kBytesPerLine, m_frameSize - within);
+    }
+    length = std::min(length, m_fileSize - line.offset);
+
+    // Read enough around the line to see sync words that cross its edges.
+    const qint64 reach = std::max(0, int(m_syncWord.size()) - 1);
+    const qint64 start = std::max<qint64>(0, line.offset - reach);
+    const qint64 end = std::min(m_fileSize, line.offset + length + reach);
+    QByteArray bytes(end - start, Qt::Uninitialized);
+    const qint64 got = read(start, end - start, bytes.data());
+    const qint64 lead = line.offset - start;
+    length = std::max<qint64>(0, std::min(length, got - lead));
+
+    // 0 plain, 1 sync word at a frame start, 2 sync word inside a frame.
+    char marks[kBytesPerLine] = {};
+    if (!m_syncWord.isEmpty()) {
+        const char *word = m_syncWord.constData();
+        const qint64 size = m_syncWord.size();
+        for (qint64 at = 0; at + size <= got; ++at) {
+            if (std::memcmp(bytes.constData() + at, word, size) != 0) continue;
+            const char mark = isFrameStart(start + at) ? 1 : 2;
+            for (qint64 i = std::max(at, lead); i < std::min(at + size, lead + length); ++i) marks[i - lead] = mark;
+        }
+    }
+    if (!line.frameStart || m_syncWord.isEmpty()) {
+        line.sync = SyncUnknown;
+    } else {
+        line.sync = (length > 0 && marks[0] == 1) ? SyncFound : SyncMissing;
+    }
+
+    static const char *const kOpen[] = {"", "<font color=\"#2e7d32\"><b>", "<font color=\"#ef6c00\">"};
+    static const char *const kClose[] = {"", "</b></font>", "</font>"};
+    static const char kDigits[] = "0123456789abcdef";
+    line.hex.reserve(int(length) * 3 + 64);
+    line.ascii.reserve(int(length));
+    char mark = 0;
+    for (qint64 i = 0; i < length; ++i) {
+        const uchar byte = static_cast<uchar>(bytes[int(lead + i)]);
+        if (marks[i] != mark) {
+            line.hex += kClose[int(mark)];
+            mark = marks[i];
+            line.hex += kOpen[int(mark)];
+        }
+        if (i > 0) line.hex += (i % 8 == 0) ? "&nbsp;&nbsp;" : "&nbsp;";
+        line.hex += QChar(kDigits[byte >> 4]);
+        line.hex += QChar(kDigits[byte & 15]);
+        line.ascii += (byte >= 0x20 && byte < 0x7f) ? QChar(byte) : QChar('.');
+    }
+    line.hex += kClose[int(mark)];
+    return line;
+}
+
+qint64 FrameInspectorModel::read(qint64 offset, qint64 length, char *out) {
+    qint64 copied = 0;
+    while (copied < length) {
+        const Window *mapped = window(offset + copied);
+        if (!mapped) break;
+        const qint64 within = offset + copied - mapped->offset;
+        const qint64 take = std::min(mapped->size - within, length - copied);
+        std::memcpy(out + copied, mapped->data + within, static_cast<size_t>(take));
+        copied += take;
+    }
+    return copied;
+}
+
+// Windows are aligned to their size, so every offset belongs to exactly one.
+// The least recently used one is unmapped to make room, which returns its
+// pages to the system instead of leaving them counted against the process.
+const FrameInspectorModel::Window *FrameInspectorModel::window(qint64 offset) {
+    if (offset < 0 || offset >= m_fileSize) return nullptr;
+    const qint64 base = offset / kWindowBytes * kWindowBytes;
+    for (Window &mapped : m_windows) {
+        if (mapped.offset == base) {
+            mapped.lastUse = ++m_useCounter;
+            return &mapped;
+        }
+    }
+    if (m_windows.size() >= kMaxWindows) {
+        auto oldest = std::min_element(m_windows.begin(), m_windows.end(),
+                                       [](const Window &a, const Window &b) { return a.lastUse < b.lastUse; });
+        m_file.unmap(oldest->data);
+        m_windows.erase(oldest);
+    }
+    const qint64 size = std::min(kWindowBytes, m_fileSize - base);
+    uchar *data = m_file.map(base, size);
+    if (!data) return nullptr;
+#ifdef Q_OS_UNIX
+    // A jump reads a few lines; readahead would fault in the whole window.
+    ::madvise(data, static_cast<size_t>(size), MADV_RANDOM);
+#endif
+    m_windows.append({base, size, data, ++m_useCounter});
+    return &m_windows.last();
+}
+
+void FrameInspectorModel::unmapAll() {
+    for (const Window &mapped : m_windows) m_file.unmap(mapped.data);
+    m_windows.clear();
+}
@@ -0,0 +1,132 @@
+#ifndef FRAMEINSPECTOR_H
+#define FRAMEINSPECTOR_H
+
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Frame-aligned hex view of a capture of any size. The file is laid out as
+// lines of bytesPerLine bytes that restart at every frame boundary, with the
+// bytes before firstFrameOffset shown as a short preamble. The model only
+// holds the visibleLines lines starting at topLine, so a view scrolled
+// anywhere in a 1 TB file asks for the same few dozen rows, and every line
+// is located by arithmetic on its number.
+//
+// Data is paged in through a handful of memory-mapped windows that are
+// unmapped again when evicted, so the resident part of the file stays below
+// kMaxWindows * kWindowBytes wherever the view goes. Opening a file maps
+// nothing.
+class FrameInspectorModel : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(QString filePath READ filePath WRITE setFilePath NOTIFY frameLayoutChanged)
+    Q_PROPERTY(int frameSize READ frameSize WRITE setFrameSize NOTIFY frameLayoutChanged)
+    Q_PROPERTY(QString syncWord READ syncWord WRITE setSyncWord NOTIFY frameLayoutChanged)
+    Q_PROPERTY(qint64 firstFrameOffset READ firstFrameOffset WRITE setFirstFrameOffset NOTIFY frameLayoutChanged)
+    Q_PROPERTY(qint64 fileSize READ fileSize NOTIFY frameLayoutChanged)
+    Q_PROPERTY(qint64 lineCount READ lineCount NOTIFY frameLayoutChanged)
+    Q_PROPERTY(qint64 frameCount READ frameCount NOTIFY frameLayoutChanged)
+    Q_PROPERTY(qint64 topLine READ topLine WRITE setTopLine NOTIFY topLineChanged)
+    Q_PROPERTY(int visibleLines READ visibleLines WRITE setVisibleLines NOTIFY visibleLinesChanged)
+    Q_PROPERTY(int bytesPerLine READ bytesPerLine CONSTANT)
+
+public:
+    enum Roles {
+        OffsetRole = Qt::UserRole + 1,  // Input offset of the line, as hex text
+        FrameRole,       // Frame number, -1 in the preamble
+        FrameStartRole,  // The line starts a frame
+        SyncRole,        // On frame starts: SyncFound, SyncMissing, or SyncUnknown without a sync word
+        HexRole,         // Bytes as styled text, sync words highlighted
+        AsciiRole
+    };
+    enum SyncState { SyncUnknown = 0, SyncFound = 1, SyncMissing = 2 };
+    Q_ENUM(SyncState)
+
+    static constexpr int kBytesPerLine = 32;
+    static constexpr qint64 kWindowBytes = 4 * 1024 * 1024;
+    static constexpr int kMaxWindows = 4;
+
+    explicit FrameInspectorModel(QObject *parent = nullptr);
+    ~FrameInspectorModel() override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    QString filePath() const { return m_filePath; }
+    int frameSize() const { return m_frameSize; }
+    QString syncWord() const { return QString::fromLatin1(m_syncWord.toHex()); }
+    qint64 firstFrameOffset() const { return m_firstFrameOffset; }
+    qint64 fileSize() const { return m_fileSize; }
+    qint64 lineCount() const;
+    qint64 frameCount() const;
+    qint64 topLine() const { return m_topLine; }
+    int visibleLines() const { return m_visibleLines; }
+    int bytesPerLine() const { return kBytesPerLine; }
+
+    // Line holding a byte or starting a frame; both are O(1).
+    Q_INVOKABLE qint64 lineForOffset(qint64 offset) const;
+    Q_INVOKABLE qint64 lineForFrame(qint64 frame) const;
+
+    // Moves the first frame to the first sync word within one frame of the
+    // start of the file, so frame boundaries fall where the sync words are.
+    // Returns false, leaving the layout alone, if there is none.
+    bool alignToSyncWord();
+
+public slots:
+    void setFilePath(const QString &path);
+    void setFrameSize(int size);
+    void setSyncWord(const QString &hex);
+    void setFirstFrameOffset(qint64 offset);
+    void setTopLine(qint64 line);
+    void setVisibleLines(int lines);
+
+signals:
+    void frameLayoutChanged();
+    void topLineChanged();
+    void visibleLinesChanged();
+
+private:
+    struct Line {
+        qint64 offset;
+        qint64 frame;
+        bool frameStart;
+        int sync;
+        QString hex;
+        QString ascii;
+    };
+    struct Window {
+        qint64 offset;
+        qint64 size;
+        uchar *data;
+        quint64 lastUse;
+    };
+
+    qint64 preambleLines() const;
+    qint64 linesPerFrame() const;
+    bool isFrameStart(qint64 offset) const;
+    // Copies length bytes at offset through the mapped windows; returns the bytes copied.
+    qint64 read(qint64 offset, qint64 length, char *out);
+    const Window *window(qint64 offset);
+    void unmapAll();
+    Line buildLine(qint64 line);
+    // Rebuilds the visible lines, keeping the byte at the top in view when the layout moved.
+    void relayout(qint64 keepOffset);
+    void refresh();
+
+    QString m_filePath;
+    QFile m_file;
+    qint64 m_fileSize;
+    int m_frameSize;
+    QByteArray m_syncWord;
+    qint64 m_firstFrameOffset;  // Start of frame 0; the bytes before it form the preamble
+    qint64 m_topLine;
+    int m_visibleLines;
+    QVector<Line> m_lines;  // The visible lines only
+    QVector<Window> m_windows;
+    quint64 m_useCounter;
+};
+
+#endif // FRAMEINSPECTOR_H
@@ -0,0 +1,127 @@
+#include "framesync.h"
+
+#include <algorithm>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const char *findSyncWord(const char *data, size_t size, const char *pattern, size_t patternSize) {
+    if (patternSize == 0 || size < patternSize) return nullptr;
+    if (patternSize == 1) return static_cast<const char *>(std::memchr(data, pattern[0], size));
+
+    const size_t lastStart = size - patternSize;
+    size_t i = 0;
+#ifdef __SSE2__
+    // Compare the first and last pattern byte at 16 positions at once and only
+    // memcmp the middle of positions where both match.
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[patternSize - 1]);
+    for (; i + 15 <= lastStart; i += 16) {
+        const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + patternSize - 1));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+        while (mask) {
+            const unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (patternSize == 2 || std::memcmp(data + i + bit + 1, pattern + 1, patternSize - 2) == 0) {
+                return data + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    while (i <= lastStart) {
+        const char *hit = static_cast<const char *>(std::memchr(data + i, pattern[0], lastStart - i + 1));
+        if (!hit) return nullptr;
+        if (std::memcmp(hit, pattern, patternSize) == 0) return hit;
+        i = static_cast<size_t>(hit - data) + 1;
+    }
+    return nullptr;
+}
+
+FrameSynchronizer::FrameSynchronizer(const std::string &syncWord, int frameSizeBytes, const FrameSink &sink)
+    : m_sync(syncWord), m_frameSize(std::max(frameSizeBytes, 1)), m_sink(sink) {}
+
+bool FrameSynchronizer::hasSync(const char *at) const {
+    return std::memcmp(at, m_sync.data(), m_sync.size()) == 0;
+}
+
+void FrameSynchronizer::skip(int64_t inputOffset, int64_t length) {
+    if (length <= 0) return;
+    m_skippedBytes += length;
+    if (!m_gaps.empty() && m_gaps.back().offset + m_gaps.back().length == inputOffset) {
+        m_gaps.back().length += length;
+    } else {
+        m_gaps.push_back({inputOffset, length});
+    }
+}
+
+int64_t FrameSynchronizer::process(const char *data, size_t size, int64_t inputOffset, bool atEnd) {
+    const int64_t end = static_cast<int64_t>(size);
+    const int64_t syncSize = static_cast<int64_t>(m_sync.size());
+    int64_t pos = 0;
+    int64_t runStart = 0;
+    size_t runFrames = 0;
+
+    auto flushRun = [&]() {
+        if (runFrames == 0) return true;
+        m_framesAccepted += static_cast<int64_t>(runFrames);
+        const bool ok = m_sink(data + runStart, inputOffset + runStart, runFrames);
+        runFrames = 0;
+        return ok;
+    };
+
+    while (pos < end) {
+        if (m_locked) {
+            // Clean streams stay in this branch: one short compare per frame.
+            if (end - pos < m_frameSize) break;
+            if (hasSync(data + pos)) {
+                if (runFrames == 0) runStart = pos;
+                ++runFrames;
+                pos += m_frameSize;
+                continue;
+            }
+            m_locked = false;
+            if (!flushRun()) return -1;
+        }
+
+        const char *hit = findSyncWord(data + pos, static_cast<size_t>(end - pos), m_sync.data(), m_sync.size());
+        if (!hit) {
+            // The last few bytes may hold the start of a sync word split across calls.
+            const int64_t keep = atEnd ? 0 : std::min<int64_t>(end - pos, syncSize - 1);
+            skip(inputOffset + pos, end - pos - keep);
+            pos = end - keep;
+            break;
+        }
+
+        const int64_t candidate = hit - data;
+        if (candidate + m_frameSize + syncSize > end) {
+            // The confirming sync word is not here yet. At the end of the input
+            // there is none to wait for, so a complete last frame is accepted.
+            skip(inputOffset + pos, candidate - pos);
+            pos = candidate;
+            if (atEnd && candidate + m_frameSize <= end) {
+                m_locked = true;
+                continue;
+            }
+            break;
+        }
+        if (!hasSync(data + candidate + m_frameSize)) {
+            // A sync pattern inside the payload; keep searching past it.
+            skip(inputOffset + pos, candidate + 1 - pos);
+            pos = candidate + 1;
+            continue;
+        }
+        skip(inputOffset + pos, candidate - pos);
+        pos = candidate;
+        m_locked = true;
+    }
+
+    if (!flushRun()) return -1;
+    if (atEnd && pos < end) {
+        skip(inputOffset + pos, end - pos);  // Trailing partial frame
+        pos = end;
+    }
+    return pos;
+}
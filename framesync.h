@@ -0,0 +1,56 @@
+#ifndef FRAMESYNC_H
+#define FRAMESYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Returns the first occurrence of pattern in data, or nullptr. Uses SSE2 to test
+// 16 candidate positions per step on x86-64 and memchr elsewhere.
+const char *findSyncWord(const char *data, size_t size, const char *pattern, size_t patternSize);
+
+// Input bytes dropped while regaining frame lock.
+struct SyncGap {
+    int64_t offset;
+    int64_t length;
+};
+
+// Validates the sync word at every frame start of a byte stream. Runs of valid
+// frames are passed to the sink without copying; when a frame start does not
+// hold the sync word, the synchronizer searches forward for the next sync word
+// that is followed by another one a frame later and records the skipped bytes.
+class FrameSynchronizer {
+public:
+    // Receives frameCount whole frames starting at data, located at inputOffset.
+    // Returning false aborts processing.
+    using FrameSink = std::function<bool(const char *data, int64_t inputOffset, size_t frameCount)>;
+
+    FrameSynchronizer(const std::string &syncWord, int frameSizeBytes, const FrameSink &sink);
+
+    // Consumes data located at inputOffset and returns how many bytes were used.
+    // The rest, always fewer than lookaheadBytes(), has to be passed again at the
+    // start of the next call. With atEnd set everything is consumed and a trailing
+    // partial frame counts as skipped. Returns -1 when the sink aborted.
+    int64_t process(const char *data, size_t size, int64_t inputOffset, bool atEnd);
+
+    size_t lookaheadBytes() const { return static_cast<size_t>(m_frameSize) + m_sync.size(); }
+    int64_t framesAccepted() const { return m_framesAccepted; }
+    int64_t skippedBytes() const { return m_skippedBytes; }
+    const std::vector<SyncGap> &gaps() const { return m_gaps; }
+
+private:
+    bool hasSync(const char *at) const;
+    void skip(int64_t inputOffset, int64_t length);
+
+    std::string m_sync;
+    int64_t m_frameSize;
+    FrameSink m_sink;
+    bool m_locked = false;
+    int64_t m_framesAccepted = 0;
+    int64_t m_skippedBytes = 0;
+    std::vector<SyncGap> m_gaps;
+};
+
+#endif // FRAMESYNC_H
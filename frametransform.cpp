@@ -0,0 +1,192 @@
+#include "frametransform.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SPLITTER_HAVE_X86_BYTE_SWAP 1
+#endif
+
+namespace {
+
+// Copies words of Word bytes with their byte order reversed; Word 1 is a
+// plain copy. With Word fixed the inner loop unrolls into a byte swap.
+template <int Word>
+void swapScalar(const unsigned char *in, unsigned char *out, size_t words) {
+    if constexpr (Word == 1) {
+        std::memcpy(out, in, words);
+    } else {
+        for (size_t i = 0; i < words; ++i, in += Word, out += Word) {
+            for (int k = 0; k < Word; ++k) out[k] = in[Word - 1 - k];
+        }
+    }
+}
+
+#ifdef SPLITTER_HAVE_X86_BYTE_SWAP
+// pshufb pattern that reverses each Word-byte group of a 16-byte lane.
+template <int Word>
+struct ShuffleMask {
+    alignas(32) unsigned char bytes[32];
+    ShuffleMask() {
+        for (int i = 0; i < 32; ++i) bytes[i] = static_cast<unsigned char>((i % 16) / Word * Word + Word - 1 - i % Word);
+    }
+};
+
+template <int Word>
+__attribute__((target("ssse3")))
+void swapSsse3(const unsigned char *in, unsigned char *out, size_t words) {
+    static const ShuffleMask<Word> mask;
+    const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i *>(mask.bytes));
+    size_t bytes = words * Word;
+    for (; bytes >= 64; in += 64, out += 64, bytes -= 64) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 48));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(a, shuffle));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), _mm_shuffle_epi8(b, shuffle));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 32), _mm_shuffle_epi8(c, shuffle));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 48), _mm_shuffle_epi8(d, shuffle));
+    }
+    for (; bytes >= 16; in += 16, out += 16, bytes -= 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(a, shuffle));
+    }
+    swapScalar<Word>(in, out, bytes / Word);
+}
+
+// vpshufb shuffles within 16-byte lanes, which is all a word swap needs.
+template <int Word>
+__attribute__((target("avx2")))
+void swapAvx2(const unsigned char *in, unsigned char *out, size_t words) {
+    static const ShuffleMask<Word> mask;
+    const __m256i shuffle = _mm256_load_si256(reinterpret_cast<const __m256i *>(mask.bytes));
+    size_t bytes = words * Word;
+    for (; bytes >= 128; in += 128, out += 128, bytes -= 128) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 32));
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 64));
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 96));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_shuffle_epi8(a, shuffle));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 32), _mm256_shuffle_epi8(b, shuffle));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 64), _mm256_shuffle_epi8(c, shuffle));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 96), _mm256_shuffle_epi8(d, shuffle));
+    }
+    for (; bytes >= 32; in += 32, out += 32, bytes -= 32) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_shuffle_epi8(a, shuffle));
+    }
+    swapSsse3<Word>(in, out, bytes / Word);
+}
+#endif
+
+using SwapRun = void (*)(const unsigned char *in, unsigned char *out, size_t words);
+
+// One instance per word size and swap routine. Bytes of a payload past its
+// last whole word are copied as they are.
+template <int Word, SwapRun Swap>
+void transformKernel(const unsigned char *in, size_t count, unsigned char *out, size_t frameSize, size_t strip,
+                     size_t payload) {
+    if (strip == 0 && payload == frameSize && frameSize % Word == 0) {
+        Swap(in, out, count * frameSize / Word);
+        return;
+    }
+    const size_t words = payload / Word;
+    const size_t tail = payload % Word;
+    for (size_t i = 0; i < count; ++i, in += frameSize, out += payload) {
+        Swap(in + strip, out, words);
+        if (tail > 0) std::memcpy(out + words * Word, in + strip + words * Word, tail);
+    }
+}
+
+template <int Word>
+FrameTransformer::Kernel kernelFor() {
+#ifdef SPLITTER_HAVE_X86_BYTE_SWAP
+    if constexpr (Word > 1) {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        static const bool ssse3 = __builtin_cpu_supports("ssse3");
+        if (avx2) return &transformKernel<Word, swapAvx2<Word>>;
+        if (ssse3) return &transformKernel<Word, swapSsse3<Word>>;
+    }
+#endif
+    return &transformKernel<Word, swapScalar<Word>>;
+}
+
+bool parseBytes(const std::string &text, int *value) {
+    char *end = nullptr;
+    const long parsed = std::strtol(text.c_str(), &end, 0);
+    if (text.empty() || *end != '\0' || parsed < 0 || parsed > (1 << 30)) return false;
+    *value = static_cast<int>(parsed);
+    return true;
+}
+
+} // namespace
+
+bool parseFrameTransform(const std::string &text, FrameTransform *transform, std::string *error) {
+    FrameTransform parsed;
+    size_t start = 0;
+    while (start <= text.size()) {
+        const size_t comma = std::min(text.find(',', start), text.size());
+        const std::string step = text.substr(start, comma - start);
+        const size_t equals = step.find('=');
+        const std::string key = step.substr(0, equals);
+        const std::string value = equals == std::string::npos ? std::string() : step.substr(equals + 1);
+        bool ok = equals != std::string::npos;
+        if (ok && key == "strip") {
+            parsed.stripSyncWord = value == "sync";
+            ok = parsed.stripSyncWord || parseBytes(value, &parsed.stripBytes);
+        } else if (ok && key == "payload") {
+            ok = parseBytes(value, &parsed.payloadBytes) && parsed.payloadBytes > 0;
+        } else if (ok && key == "swap") {
+            parsed.swapBytes = value == "16" ? 2 : value == "32" ? 4 : value == "64" ? 8 : 0;
+            ok = parsed.swapBytes > 0;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            *error = "Expected strip=<bytes>|sync, payload=<bytes> or swap=16|32|64 in the frame transform: " + step;
+            return false;
+        }
+        start = comma + 1;
+    }
+    *transform = parsed;
+    return true;
+}
+
+std::string FrameTransformer::check(const FrameTransform &transform, int frameSize) {
+    const int64_t payload = transform.payloadBytes >= 0 ? transform.payloadBytes
+                                                        : int64_t(frameSize) - transform.stripBytes;
+    if (transform.stripBytes + payload > frameSize || payload <= 0) {
+        return "The frame transform keeps nothing of " + std::to_string(frameSize) + "-byte frames or reaches past "
+               "their end";
+    }
+    return std::string();
+}
+
+FrameTransformer::FrameTransformer(const FrameTransform &transform, int frameSize)
+    : m_frameSize(frameSize), m_strip(transform.stripBytes),
+      m_payload(transform.payloadBytes >= 0 ? transform.payloadBytes : frameSize - transform.stripBytes),
+      m_swap(std::max(1, transform.swapBytes)) {
+    m_kernel = m_swap == 2 ? kernelFor<2>() : m_swap == 4 ? kernelFor<4>() : m_swap == 8 ? kernelFor<8>()
+                                                                                       : kernelFor<1>();
+}
+
+int64_t FrameTransformer::outputBytes(int64_t inputBytes) const {
+    const int64_t partial = inputBytes % m_frameSize;
+    return inputBytes / m_frameSize * m_payload + std::min(std::max<int64_t>(0, partial - m_strip), m_payload);
+}
+
+void FrameTransformer::apply(const char *frames, size_t count, char *out) const {
+    m_kernel(reinterpret_cast<const unsigned char *>(frames), count, reinterpret_cast<unsigned char *>(out),
+             static_cast<size_t>(m_frameSize), static_cast<size_t>(m_strip), static_cast<size_t>(m_payload));
+}
+
+size_t FrameTransformer::applyPartial(const char *frame, size_t size, char *out) const {
+    const size_t kept = static_cast<size_t>(std::min(std::max<int64_t>(0, int64_t(size) - m_strip), m_payload));
+    if (kept == 0) return 0;
+    // Run the kernel over a frame that ends where the data does.
+    m_kernel(reinterpret_cast<const unsigned char *>(frame), 1, reinterpret_cast<unsigned char *>(out),
+             static_cast<size_t>(m_strip) + kept, static_cast<size_t>(m_strip), kept);
+    return kept;
+}
@@ -0,0 +1,59 @@
+#ifndef FRAMETRANSFORM_H
+#define FRAMETRANSFORM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// What is kept of every frame: stripBytes are dropped from its start, the
+// next payloadBytes are kept, and each whole word of swapBytes bytes in them
+// has its byte order reversed. The payloads are written back to back, so a
+// bulk of N frames holds N * payloadBytes.
+struct FrameTransform {
+    int stripBytes = 0;
+    bool stripSyncWord = false;  // stripBytes is the sync word's length, set once it is known
+    int payloadBytes = -1;  // -1 keeps the rest of the frame
+    int swapBytes = 0;  // 0, 2, 4 or 8
+
+    bool isActive() const { return stripBytes > 0 || stripSyncWord || payloadBytes >= 0 || swapBytes > 0; }
+};
+
+// Parses a comma-separated list of "strip=<bytes>", "strip=sync",
+// "payload=<bytes>" and "swap=16|32|64", e.g. "strip=sync,swap=16".
+bool parseFrameTransform(const std::string &text, FrameTransform *transform, std::string *error);
+
+// Applies a FrameTransform to whole frames. The loop is compiled once per
+// word size and instruction set (AVX2, SSSE3, or scalar byte swaps) and the
+// variant is picked when the transformer is built, so the per-frame work
+// has no branches on the settings. When the payload is the whole frame, the
+// frames are swapped as one run instead of frame by frame.
+class FrameTransformer {
+public:
+    // transform must be valid for frameSize; see check().
+    FrameTransformer(const FrameTransform &transform, int frameSize);
+
+    // Empty when transform fits frames of frameSize, else the reason it does not.
+    static std::string check(const FrameTransform &transform, int frameSize);
+
+    int64_t payloadBytes() const { return m_payload; }
+    // Output size of bytes of input starting at a frame boundary; a trailing
+    // partial frame keeps what it has of its payload.
+    int64_t outputBytes(int64_t inputBytes) const;
+
+    // Transforms count whole frames into out, which receives count * payloadBytes().
+    void apply(const char *frames, size_t count, char *out) const;
+    // Transforms a partial frame of size bytes; returns the bytes written.
+    size_t applyPartial(const char *frame, size_t size, char *out) const;
+
+    using Kernel = void (*)(const unsigned char *in, size_t count, unsigned char *out, size_t frameSize,
+                            size_t strip, size_t payload);
+
+private:
+    Kernel m_kernel;
+    int64_t m_frameSize;
+    int64_t m_strip;
+    int64_t m_payload;
+    int m_swap;
+};
+
+#endif // FRAMETRANSFORM_H
@@ -1,11 +1,12 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
 import QtQuick.Layouts 1.15
+import BinarySplitter 1.0
 
 ApplicationWindow {
     visible: true
-    width: 600
-    height: 400
+    width: 1000
+    height: 720
     title: "Binary File Splitter"
 
     ColumnLayout {
@@ -64,6 +65,11 @@ ApplicationWindow {
                     }
                 }
             }
+            Label {
+                text: mainWindow.detection
+                visible: text !== ""
+                Layout.fillWidth: true
+            }
         }
 
         RowLayout {
@@ -112,10 +118,143 @@ ApplicationWindow {
             value: mainWindow.progress / 100
         }
 
+        Label {
+            text: mainWindow.throughput
+            visible: mainWindow.isRunning && text !== ""
+        }
+
         Label {
             text: mainWindow.status
             Layout.fillWidth: true
         }
+
+        RowLayout {
+            Label { text: "Go to Frame:" }
+            TextField {
+                id: frameJumpField
+                placeholderText: "0"
+                onAccepted: {
+                    let frame = parseInt(text)
+                    if (!isNaN(frame)) {
+                        mainWindow.inspector.topLine = mainWindow.inspector.lineForFrame(frame)
+                    }
+                }
+            }
+            Label { text: "Offset:" }
+            TextField {
+                id: offsetJumpField
+                placeholderText: "0x0"
+                onAccepted: {
+                    let offset = parseInt(text)
+                    if (!isNaN(offset)) {
+                        mainWindow.inspector.topLine = mainWindow.inspector.lineForOffset(offset)
+                    }
+                }
+            }
+            Button {
+                text: "Detect"
+                enabled: !mainWindow.isRunning
+                onClicked: mainWindow.detectFrameSize()
+            }
+            Label {
+                text: mainWindow.inspector.fileSize > 0
+                      ? mainWindow.inspector.frameCount + " frames of " + mainWindow.inspector.frameSize
+                        + " bytes, first at " + mainWindow.inspector.firstFrameOffset
+                      : ""
+                Layout.fillWidth: true
+            }
+        }
+
+        // Frame-aligned hex view. The model only holds the lines on screen, so
+        // the list never scrolls itself; the scroll bar and wheel move the
+        // model's top line instead.
+        Rectangle {
+            Layout.fillWidth: true
+            Layout.fillHeight: true
+            border.color: "#bdbdbd"
+            clip: true
+
+            ListView {
+                id: inspectorView
+                readonly property int lineHeight: 18
+                anchors.fill: parent
+                anchors.margins: 4
+                anchors.rightMargin: inspectorScroll.width + 4
+                interactive: false
+                model: mainWindow.inspector
+                onHeightChanged: mainWindow.inspector.visibleLines = Math.max(1, Math.floor(height / lineHeight))
+                Component.onCompleted: mainWindow.inspector.visibleLines = Math.max(1, Math.floor(height / lineHeight))
+
+                delegate: Row {
+                    height: inspectorView.lineHeight
+                    spacing: 10
+                    Rectangle {
+                        width: 4
+                        height: parent.height
+                        color: model.sync === FrameInspectorModel.SyncFound ? "#2e7d32"
+                             : model.sync === FrameInspectorModel.SyncMissing ? "#c62828" : "transparent"
+                    }
+                    Text {
+                        text: model.offset
+                        font.family: "monospace"
+                        color: "#757575"
+                    }
+                    Text {
+                        width: 90
+                        text: model.frameStart ? "#" + model.frame : (model.frame < 0 ? "preamble" : "")
+                        font.family: "monospace"
+                        color: "#1565c0"
+                    }
+                    Text {
+                        text: model.hex
+                        textFormat: Text.StyledText
+                        font.family: "monospace"
+                    }
+                    Text {
+                        text: model.ascii
+                        textFormat: Text.PlainText
+                        font.family: "monospace"
+                    }
+                }
+            }
+
+            Label {
+                anchors.centerIn: parent
+                text: "Select an input file to inspect it."
+                visible: mainWindow.inspector.lineCount === 0
+            }
+
+            MouseArea {
+                anchors.fill: inspectorView
+                acceptedButtons: Qt.NoButton
+                onWheel: function(wheel) {
+                    mainWindow.inspector.topLine += wheel.angleDelta.y > 0 ? -3 : 3
+                }
+            }
+
+            ScrollBar {
+                id: inspectorScroll
+                anchors.top: parent.top
+                anchors.right: parent.right
+                anchors.bottom: parent.bottom
+                orientation: Qt.Vertical
+                policy: ScrollBar.AlwaysOn
+                minimumSize: 0.02
+                size: mainWindow.inspector.lineCount > 0
+                      ? Math.min(1, mainWindow.inspector.visibleLines / mainWindow.inspector.lineCount) : 1
+                onPositionChanged: {
+                    if (pressed) {
+                        mainWindow.inspector.topLine = Math.round(position * mainWindow.inspector.lineCount)
+                    }
+                }
+
+                Binding on position {
+                    when: !inspectorScroll.pressed
+                    value: mainWindow.inspector.lineCount > 0
+                           ? mainWindow.inspector.topLine / mainWindow.inspector.lineCount : 0
+                }
+            }
+        }
     }
 
     Connections {
@@ -1,6 +1,7 @@
 #include "mainwindow.h"
 #include <QFileDialog>
 #include <QThread>
+#include <QTimer>
 
 MainWindow::MainWindow(QObject *parent) : QObject(parent),
     m_splitter(new BinarySplitterCore),
@@ -13,18 +14,34 @@ MainWindow::MainWindow(QObject *parent) : QObject(parent),
     m_progress(0),
     m_status("Ready"),
     m_isRunning(false),
-    m_workerThread(new QThread) {
+    m_workerThread(new QThread),
+    m_progressTimer(new QTimer(this)),
+    m_inspector(new FrameInspectorModel(this)) {
 
     QJsonObject defaults = m_splitter->loadConfigDefaults();
     m_bulkSizeGb = defaults["default_bulk_size_gb"].toDouble();
     m_frameSize = defaults["default_frame_size_bytes"].toInt();
     m_syncWord = defaults["default_sync_word_hex"].toString();
+    m_splitter->setRingDepth(defaults["default_ring_depth"].toInt());
+    m_splitter->setBufferSizeKb(defaults["default_buffer_size_kb"].toInt());
+    m_splitter->setIoBackend(defaults["default_io_backend"].toString());
+    m_splitter->setWriteIndex(defaults["default_write_index"].toBool());
+    m_splitter->setWriteManifest(defaults["default_write_manifest"].toBool());
+    m_splitter->setDirectIo(defaults["default_direct_io"].toBool());
+    m_splitter->setSparse(defaults["default_sparse"].toBool());
+    m_splitter->setCompression(defaults["default_compression"].toString());
+    m_splitter->setFrameTransform(defaults["default_frame_transform"].toString());
+    m_inspector->setFrameSize(m_frameSize);
+    m_inspector->setSyncWord(m_syncWord);
 
     m_splitter->moveToThread(m_workerThread);
-    connect(m_splitter, &BinarySplitterCore::progressUpdated, this, &MainWindow::updateProgress);
     connect(m_splitter, &BinarySplitterCore::splitFinished, this, &MainWindow::operationFinished);
     connect(m_splitter, &BinarySplitterCore::splitError, this, &MainWindow::operationError);
     m_workerThread->start();
+
+    // Fast enough for a smooth bar; the worker never waits on the UI.
+    m_progressTimer->setInterval(100);
+    connect(m_progressTimer, &QTimer::timeout, this, &MainWindow::sampleProgress);
 }
 
 MainWindow::~MainWindow() {
@@ -36,6 +53,7 @@ MainWindow::~MainWindow() {
 
 void MainWindow::setInputFile(const QString &file) {
     m_inputFile = file;
+    m_inspector->setFilePath(file);
     emit inputFileChanged();
 }
 
@@ -52,6 +70,7 @@ void MainWindow::setBulkSizeGb(double size) {
 void MainWindow::setFrameSize(int size) {
     if (size > 0 && size <= 65536) {
         m_frameSize = size;
+        m_inspector->setFrameSize(size);
         emit frameSizeChanged();
     } else {
         m_status = "Frame size must be between 1 and 65536 bytes.";
@@ -78,6 +97,7 @@ void MainWindow::setSyncWord(const QString &word) {
     QByteArray test = QByteArray::fromHex(word.toUtf8());
     if (!test.isEmpty()) {
         m_syncWord = word;
+        m_inspector->setSyncWord(word);
         emit syncWordChanged();
     } else {
         m_status = "Sync word must be valid hexadecimal.";
@@ -93,31 +113,24 @@ void MainWindow::startSplit() {
     }
 
     // Reset the stop flag before starting a new operation
-    QMetaObject::invokeMethod(m_splitter, "resetStopFlag", Qt::QueuedConnection);
+    m_splitter->resetStopFlag();
 
     int frameSizeToUse;
     if (m_autoDetect) {
-        bool ok = QMetaObject::invokeMethod(m_splitter, "detectFrameSize",
-                                            Qt::BlockingQueuedConnection,
-                                            Q_RETURN_ARG(int, frameSizeToUse),
-                                            Q_ARG(QString, m_inputFile),
-                                            Q_ARG(QString, m_syncWord));
-        if (!ok || frameSizeToUse <= 0) {
-            m_status = "Frame size detection failed.";
-            emit statusChanged();
-            return;
-        }
-        setFrameSize(frameSizeToUse);
-        m_status = QString("Detected frame size: %1 bytes").arg(frameSizeToUse);
+        frameSizeToUse = runDetection();
+        if (frameSizeToUse <= 0) return;
     } else {
         frameSizeToUse = m_frameSize;
     }
 
     setIsRunning(true);
     m_progress = 0;
+    m_throughput.clear();
+    emit throughputChanged();
     m_status = "Splitting in progress...";
     emit progressChanged();
     emit statusChanged();
+    m_progressTimer->start();
     QMetaObject::invokeMethod(m_splitter, "splitBinaryFile", Qt::QueuedConnection,
                               Q_ARG(QString, m_inputFile),
                               Q_ARG(double, m_bulkSizeGb),
@@ -127,7 +140,7 @@ void MainWindow::startSplit() {
 
 void MainWindow::stopSplit() {
     if (m_isRunning) {
-        QMetaObject::invokeMethod(m_splitter, "stopOperation", Qt::QueuedConnection);
+        m_splitter->stopOperation();  // Thread-safe; a queued call would wait for the split to end
     }
 }
 
@@ -136,18 +149,84 @@ void MainWindow::browseFile() {
     if (!file.isEmpty()) setInputFile(file);
 }
 
+void MainWindow::detectFrameSize() {
+    if (m_inputFile.isEmpty() || m_isRunning) {
+        m_status = m_isRunning ? "Wait for the split to finish before detecting." : "Please select an input file.";
+        emit statusChanged();
+        return;
+    }
+    if (runDetection() > 0) {
+        m_status = "Frame size detected.";
+        emit statusChanged();
+    }
+}
+
+// Runs on the worker, which is idle whenever this is called. The result is
+// also laid over the inspector: frames take the detected size and start at
+// the first sync word, so frames that lost lock stand out.
+int MainWindow::runDetection() {
+    QJsonObject detection;
+    bool ok = QMetaObject::invokeMethod(m_splitter, "analyzeFrameSize",
+                                        Qt::BlockingQueuedConnection,
+                                        Q_RETURN_ARG(QJsonObject, detection),
+                                        Q_ARG(QString, m_inputFile),
+                                        Q_ARG(QString, m_syncWord));
+    const int frameSize = detection["frame_size"].toInt(-1);
+    if (!ok || frameSize <= 0) {
+        m_status = "Frame size detection failed.";
+        m_detection.clear();
+        emit statusChanged();
+        emit detectionChanged();
+        return -1;
+    }
+    setFrameSize(frameSize);
+    m_inspector->alignToSyncWord();
+    const double confidence = detection["confidence"].toDouble();
+    m_detection = QString("Detected %1 bytes, confidence %2%, lock ratio %3%")
+                      .arg(frameSize)
+                      .arg(confidence * 100, 0, 'f', 1)
+                      .arg(detection["lock_ratio"].toDouble() * 100, 0, 'f', 1);
+    if (confidence < 0.5) m_detection += " (low confidence, check the sync word)";
+    emit detectionChanged();
+    return frameSize;
+}
+
+void MainWindow::sampleProgress() {
+    const SplitProgress::Sample sample = m_splitter->progress().sample();
+    if (sample.totalBytes > 0 && sample.percentage() != m_progress) updateProgress(sample.percentage());
+    if (sample.totalBytes != 0) updateThroughput(sample.bytesDone, sample.totalBytes, sample.bytesPerSecond);
+}
+
 void MainWindow::updateProgress(int percentage) {
     m_progress = percentage;
     emit progressChanged();
 }
 
+// A FIFO picked in the file dialog is split as a stream of unknown length, so
+// it shows the amount received instead of an ETA.
+void MainWindow::updateThroughput(qint64 bytesDone, qint64 totalBytes, double bytesPerSecond) {
+    const double mibPerSecond = bytesPerSecond / (1024.0 * 1024.0);
+    if (totalBytes < 0) {
+        m_throughput = QString("%1 MiB/s, %2 MiB received")
+                           .arg(mibPerSecond, 0, 'f', 1).arg(bytesDone / (1024.0 * 1024.0), 0, 'f', 1);
+    } else {
+        const qint64 eta = bytesPerSecond > 0 ? qint64((totalBytes - bytesDone) / bytesPerSecond) : 0;
+        m_throughput = QString("%1 MiB/s, ETA %2:%3")
+                           .arg(mibPerSecond, 0, 'f', 1).arg(eta / 60).arg(eta % 60, 2, 10, QChar('0'));
+    }
+    emit throughputChanged();
+}
+
 void MainWindow::operationFinished(const QString &message) {
+    m_progressTimer->stop();
+    sampleProgress();
     m_status = message;
     setIsRunning(false);
     emit statusChanged();
 }
 
 void MainWindow::operationError(const QString &error) {
+    m_progressTimer->stop();
     m_status = "Error: " + error;
     setIsRunning(false);
     emit statusChanged();
@@ -4,8 +4,10 @@
 #include <QObject>
 #include <QString>
 #include "binarysplittercore.h"
+#include "frameinspector.h"
 
 class QThread;
+class QTimer;
 
 class MainWindow : public QObject {
     Q_OBJECT
@@ -17,7 +19,10 @@ class MainWindow : public QObject {
     Q_PROPERTY(QString syncWord READ syncWord WRITE setSyncWord NOTIFY syncWordChanged)
     Q_PROPERTY(int progress READ progress NOTIFY progressChanged)
     Q_PROPERTY(QString status READ status NOTIFY statusChanged)
+    Q_PROPERTY(QString detection READ detection NOTIFY detectionChanged)
+    Q_PROPERTY(QString throughput READ throughput NOTIFY throughputChanged)
     Q_PROPERTY(bool isRunning READ isRunning NOTIFY isRunningChanged)
+    Q_PROPERTY(FrameInspectorModel *inspector READ inspector CONSTANT)
 
 public:
     explicit MainWindow(QObject *parent = nullptr);
@@ -31,7 +36,10 @@ public:
     QString syncWord() const { return m_syncWord; }
     int progress() const { return m_progress; }
     QString status() const { return m_status; }
+    QString detection() const { return m_detection; }
+    QString throughput() const { return m_throughput; }
     bool isRunning() const { return m_isRunning; }
+    FrameInspectorModel *inspector() const { return m_inspector; }
 
 public slots:
     void setInputFile(const QString &file);
@@ -43,6 +51,7 @@ public slots:
     void startSplit();
     void stopSplit();
     void browseFile();
+    void detectFrameSize();
 
 signals:
     void inputFileChanged();
@@ -53,15 +62,20 @@ signals:
     void syncWordChanged();
     void progressChanged();
     void statusChanged();
+    void detectionChanged();
+    void throughputChanged();
     void isRunningChanged();
 
 private slots:
-    void updateProgress(int percentage);
+    void sampleProgress();
     void operationFinished(const QString &message);
     void operationError(const QString &error);
 
 private:
     void setIsRunning(bool running);
+    int runDetection();
+    void updateProgress(int percentage);
+    void updateThroughput(qint64 bytesDone, qint64 totalBytes, double bytesPerSecond);
 
     BinarySplitterCore *m_splitter;
     QString m_inputFile;
@@ -72,8 +86,12 @@ private:
     QString m_syncWord;
     int m_progress;
     QString m_status;
+    QString m_detection;  // Result of the last frame size detection
+    QString m_throughput;  // Live rate and ETA of the running split
     bool m_isRunning;
     QThread *m_workerThread;
+    QTimer *m_progressTimer;  // Samples the core's progress while an operation runs
+    FrameInspectorModel *m_inspector;  // Hex view of the input, laid out with the current frame settings
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,463 @@
+#include "posixio.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <linux/fs.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/sysmacros.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+namespace {
+
+// Bytes moved per kernel call; bounds how long a cancel request can go unnoticed,
+// to a few milliseconds on local disks, while keeping the call count negligible.
+const int64_t kCopyChunkBytes = 8 * 1024 * 1024;
+const size_t kReadWriteBufferBytes = 1024 * 1024;
+
+// Errors meaning "this method does not work for these files", not "the copy failed".
+bool isUnsupported(int error) {
+    return error == ENOSYS || error == EOPNOTSUPP || error == ENOTSUP || error == EXDEV
+           || error == EINVAL || error == ENOTTY;
+}
+
+CopyMethod nextMethod(CopyMethod method) {
+    switch (method) {
+    case CopyMethod::Reflink: return CopyMethod::CopyFileRange;
+    case CopyMethod::CopyFileRange: return CopyMethod::SendFile;
+    default: return CopyMethod::ReadWrite;
+    }
+}
+
+#ifdef __linux__
+// FICLONERANGE needs block-aligned offsets and a block-aligned length unless the
+// range ends at the source EOF.
+bool canReflink(int inFd, int64_t inOffset, int64_t outOffset, int64_t length) {
+    struct stat st;
+    if (fstat(inFd, &st) != 0 || st.st_blksize <= 0) return false;
+    const int64_t block = st.st_blksize;
+    if (kCopyChunkBytes % block != 0) return false;
+    return inOffset % block == 0 && outOffset % block == 0
+           && (length % block == 0 || inOffset + length == st.st_size);
+}
+
+int64_t reflinkPiece(int inFd, int64_t inOffset, int outFd, int64_t outOffset, int64_t length) {
+    struct file_clone_range range;
+    range.src_fd = inFd;
+    range.src_offset = static_cast<__u64>(inOffset);
+    range.src_length = static_cast<__u64>(length);
+    range.dest_offset = static_cast<__u64>(outOffset);
+    if (ioctl(outFd, FICLONERANGE, &range) != 0) return -1;
+    return length;
+}
+
+int64_t copyFileRangePiece(int inFd, int64_t inOffset, int outFd, int64_t outOffset, int64_t length) {
+    loff_t in = inOffset;
+    loff_t out = outOffset;
+    return ::copy_file_range(inFd, &in, outFd, &out, static_cast<size_t>(length), 0);
+}
+
+int64_t sendFilePiece(int inFd, int64_t inOffset, int outFd, int64_t outOffset, int64_t length) {
+    // sendfile() writes at the output file position, so place it first.
+    if (lseek(outFd, outOffset, SEEK_SET) < 0) return -1;
+    off_t in = inOffset;
+    return ::sendfile(outFd, inFd, &in, static_cast<size_t>(length));
+}
+#endif
+
+int64_t readWritePiece(int inFd, int64_t inOffset, int outFd, int64_t outOffset, int64_t length,
+                       std::vector<char> &buffer) {
+    if (buffer.empty()) buffer.resize(kReadWriteBufferBytes);
+    const size_t wanted = static_cast<size_t>(std::min<int64_t>(length, buffer.size()));
+    const ssize_t got = pread(inFd, buffer.data(), wanted, inOffset);
+    if (got <= 0) return got;
+    ssize_t written = 0;
+    while (written < got) {
+        const ssize_t n = pwrite(outFd, buffer.data() + written, got - written, outOffset + written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        written += n;
+    }
+    return got;
+}
+
+} // namespace
+
+UniqueFd &UniqueFd::operator=(UniqueFd &&other) noexcept {
+    if (this != &other) reset(other.release());
+    return *this;
+}
+
+int UniqueFd::release() {
+    const int fd = m_fd;
+    m_fd = -1;
+    return fd;
+}
+
+void UniqueFd::reset(int fd) {
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = fd;
+}
+
+int64_t preadFully(int fd, void *buffer, int64_t length, int64_t offset) {
+    char *out = static_cast<char *>(buffer);
+    int64_t done = 0;
+    while (done < length) {
+        const ssize_t n = pread(fd, out + done, static_cast<size_t>(length - done), offset + done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        done += n;
+    }
+    return done;
+}
+
+bool writeFully(int fd, const void *buffer, int64_t length) {
+    const char *in = static_cast<const char *>(buffer);
+    while (length > 0) {
+        const ssize_t n = ::write(fd, in, static_cast<size_t>(length));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        in += n;
+        length -= n;
+    }
+    return true;
+}
+
+bool pwriteFully(int fd, const void *buffer, int64_t length, int64_t offset) {
+    const char *in = static_cast<const char *>(buffer);
+    while (length > 0) {
+        const ssize_t n = ::pwrite(fd, in, static_cast<size_t>(length), offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        in += n;
+        offset += n;
+        length -= n;
+    }
+    return true;
+}
+
+bool nextDataRange(int fd, int64_t offset, int64_t end, int64_t *dataStart, int64_t *dataEnd) {
+    *dataStart = offset;
+    *dataEnd = end;
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    const off_t data = lseek(fd, offset, SEEK_DATA);
+    if (data < 0) {
+        // ENXIO: nothing but hole up to the end of the file.
+        return errno != ENXIO;
+    }
+    if (data >= end) return false;
+    const off_t hole = lseek(fd, data, SEEK_HOLE);
+    *dataStart = data;
+    if (hole > data) *dataEnd = std::min<int64_t>(hole, end);
+#endif
+    return true;
+}
+
+namespace {
+
+// Drops the first n transferred bytes from the front of an iovec array.
+void advanceIovecs(struct iovec *&iov, int &count, size_t n) {
+    while (count > 0 && n >= iov->iov_len) {
+        n -= iov->iov_len;
+        ++iov;
+        --count;
+    }
+    if (count > 0) {
+        iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+        iov->iov_len -= n;
+    }
+}
+
+} // namespace
+
+int64_t preadvFully(int fd, struct iovec *iov, int count, int64_t offset) {
+    int64_t done = 0;
+    while (count > 0) {
+        const ssize_t n = ::preadv(fd, iov, count, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        done += n;
+        advanceIovecs(iov, count, static_cast<size_t>(n));
+    }
+    return done;
+}
+
+bool writevFully(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        const ssize_t n = ::writev(fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        advanceIovecs(iov, count, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+bool setDirectIo(int fd, bool enable) {
+#ifdef O_DIRECT
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0) return false;
+    return ::fcntl(fd, F_SETFL, enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT)) == 0;
+#else
+    (void)fd;
+    return !enable;
+#endif
+}
+
+bool preallocate(int fd, int64_t length) {
+#ifdef __linux__
+    return length <= 0 || ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, length) == 0;
+#else
+    (void)fd;
+    (void)length;
+    return false;
+#endif
+}
+
+void WritebackWindow::reset(int fd) {
+    m_fd = fd;
+    m_pendingOffset = 0;
+    m_pendingLength = 0;
+}
+
+void WritebackWindow::written(int64_t offset, int64_t length) {
+    if (m_fd < 0 || length <= 0) return;
+#ifdef __linux__
+    ::sync_file_range(m_fd, offset, length, SYNC_FILE_RANGE_WRITE);
+#endif
+    finish();
+    m_pendingOffset = offset;
+    m_pendingLength = length;
+}
+
+void WritebackWindow::finish() {
+    if (m_fd < 0 || m_pendingLength <= 0) return;
+#ifdef __linux__
+    ::sync_file_range(m_fd, m_pendingOffset, m_pendingLength,
+                      SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+    posix_fadvise(m_fd, m_pendingOffset, m_pendingLength, POSIX_FADV_DONTNEED);
+    m_pendingLength = 0;
+}
+
+int64_t modificationTimeNs(const struct stat &st) {
+#ifdef __APPLE__
+    return int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    return int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+
+BlockDevice blockDeviceOf(const std::string &path) {
+    BlockDevice device;
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        device.name = path;
+        return device;
+    }
+    device.name = "dev:" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+#ifdef __linux__
+    const std::string link = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":"
+                             + std::to_string(minor(st.st_dev));
+    char *resolved = ::realpath(link.c_str(), nullptr);
+    if (!resolved) return device;
+    std::string sysPath(resolved);
+    std::free(resolved);
+    // A partition's queue attributes, and its identity for scheduling, are its disk's.
+    if (::access((sysPath + "/partition").c_str(), F_OK) == 0) sysPath.erase(sysPath.rfind('/'));
+    device.name = sysPath.substr(sysPath.rfind('/') + 1);
+
+    char flag = '0';
+    UniqueFd fd(::open((sysPath + "/queue/rotational").c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd.isValid() && ::read(fd.get(), &flag, 1) == 1) device.rotational = (flag == '1');
+#endif
+    return device;
+}
+
+bool GrowthWatcher::watch(const std::string &path) {
+#ifdef __linux__
+    m_fd.reset(inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+    return m_fd.isValid()
+           && inotify_add_watch(m_fd.get(), path.c_str(),
+                                IN_MODIFY | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF) >= 0;
+#else
+    (void)path;
+    return true;
+#endif
+}
+
+GrowthWatcher::Event GrowthWatcher::wait(int timeoutMs) {
+#ifdef __linux__
+    pollfd pfd{m_fd.get(), POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) <= 0) return Timeout;
+
+    // Drain everything queued; a close anywhere in the batch wins.
+    alignas(inotify_event) char events[4096];
+    Event result = Timeout;
+    ssize_t n;
+    while ((n = ::read(m_fd.get(), events, sizeof(events))) > 0) {
+        for (ssize_t pos = 0; pos < n;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(events + pos);
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF)) {
+                result = WriterClosed;
+            } else if (result == Timeout) {
+                result = Modified;
+            }
+            pos += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+    return result;
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    return Timeout;
+#endif
+}
+
+#ifdef __linux__
+namespace {
+
+bool isNumber(const char *name) {
+    if (*name == '\0') return false;
+    for (; *name; ++name) {
+        if (*name < '0' || *name > '9') return false;
+    }
+    return true;
+}
+
+// The "flags:" line of /proc/<pid>/fdinfo/<fd>, in octal.
+bool openedForWriting(const std::string &fdinfoPath) {
+    UniqueFd fd(::open(fdinfoPath.c_str(), O_RDONLY | O_CLOEXEC));
+    char text[256];
+    const ssize_t n = fd.isValid() ? ::read(fd.get(), text, sizeof(text) - 1) : -1;
+    if (n <= 0) return false;
+    text[n] = '\0';
+    const char *flags = std::strstr(text, "flags:");
+    if (!flags) return false;
+    const long mode = std::strtol(flags + 6, nullptr, 8) & O_ACCMODE;
+    return mode == O_WRONLY || mode == O_RDWR;
+}
+
+} // namespace
+#endif
+
+WriterState writerStateOf(int fd) {
+#ifdef __linux__
+    struct stat target;
+    if (fstat(fd, &target) != 0) return WriterState::Unknown;
+    DIR *proc = ::opendir("/proc");
+    if (!proc) return WriterState::Unknown;
+    WriterState state = WriterState::None;
+    while (state == WriterState::None) {
+        const dirent *process = ::readdir(proc);
+        if (!process) break;
+        if (!isNumber(process->d_name)) continue;
+        const std::string base = std::string("/proc/") + process->d_name;
+        DIR *fds = ::opendir((base + "/fd").c_str());
+        if (!fds) continue;  // Exited, or another user's
+        while (const dirent *entry = ::readdir(fds)) {
+            if (!isNumber(entry->d_name)) continue;
+            struct stat st;
+            if (::stat((base + "/fd/" + entry->d_name).c_str(), &st) != 0 || st.st_dev != target.st_dev
+                || st.st_ino != target.st_ino) {
+                continue;
+            }
+            if (openedForWriting(base + "/fdinfo/" + entry->d_name)) {
+                state = WriterState::Open;
+                break;
+            }
+        }
+        ::closedir(fds);
+    }
+    ::closedir(proc);
+    return state;
+#else
+    (void)fd;
+    return WriterState::Unknown;
+#endif
+}
+
+const char *copyMethodName(CopyMethod method) {
+    switch (method) {
+    case CopyMethod::Reflink: return "reflink";
+    case CopyMethod::CopyFileRange: return "copy_file_range";
+    case CopyMethod::SendFile: return "sendfile";
+    case CopyMethod::ReadWrite: return "read/write";
+    default: return "none";
+    }
+}
+
+bool copyFileRange(int inFd, int64_t inOffset, int outFd, int64_t outOffset, int64_t length,
+                   CopyMethod *methodUsed, const CopyProgress &progress) {
+#ifdef __linux__
+    CopyMethod method = canReflink(inFd, inOffset, outOffset, length) ? CopyMethod::Reflink
+                                                                      : CopyMethod::CopyFileRange;
+#else
+    CopyMethod method = CopyMethod::ReadWrite;
+#endif
+    std::vector<char> buffer;
+    int64_t done = 0;
+
+    while (done < length) {
+        const int64_t piece = std::min(length - done, kCopyChunkBytes);
+        const int64_t from = inOffset + done;
+        const int64_t to = outOffset + done;
+        int64_t moved = -1;
+        switch (method) {
+#ifdef __linux__
+        case CopyMethod::Reflink: moved = reflinkPiece(inFd, from, outFd, to, piece); break;
+        case CopyMethod::CopyFileRange: moved = copyFileRangePiece(inFd, from, outFd, to, piece); break;
+        case CopyMethod::SendFile: moved = sendFilePiece(inFd, from, outFd, to, piece); break;
+#endif
+        default: moved = readWritePiece(inFd, from, outFd, to, piece, buffer); break;
+        }
+
+        if (moved < 0) {
+            if (errno == EINTR) continue;
+            if (method != CopyMethod::ReadWrite && isUnsupported(errno)) {
+                method = nextMethod(method);
+                continue;
+            }
+            return false;
+        }
+        if (moved == 0) {
+            // The input ended before the planned range did.
+            errno = EIO;
+            return false;
+        }
+
+        done += moved;
+        if (methodUsed) *methodUsed = method;
+        if (progress && !progress(done)) {
+            errno = ECANCELED;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,148 @@
+#ifndef POSIXIO_H
+#define POSIXIO_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct iovec;
+struct stat;
+
+// Owns a POSIX file descriptor and closes it on destruction.
+class UniqueFd {
+public:
+    UniqueFd() = default;
+    explicit UniqueFd(int fd) : m_fd(fd) {}
+    UniqueFd(UniqueFd &&other) noexcept : m_fd(other.release()) {}
+    UniqueFd &operator=(UniqueFd &&other) noexcept;
+    UniqueFd(const UniqueFd &) = delete;
+    UniqueFd &operator=(const UniqueFd &) = delete;
+    ~UniqueFd() { reset(); }
+
+    int get() const { return m_fd; }
+    bool isValid() const { return m_fd >= 0; }
+    int release();
+    void reset(int fd = -1);
+
+private:
+    int m_fd = -1;
+};
+
+// Reads until length bytes arrived or the file ended. Returns the byte count, or
+// -1 with errno set.
+int64_t preadFully(int fd, void *buffer, int64_t length, int64_t offset);
+
+// Writes all of buffer at the current file position, retrying short writes.
+bool writeFully(int fd, const void *buffer, int64_t length);
+
+// Like writeFully(), at offset and without moving the file position.
+bool pwriteFully(int fd, const void *buffer, int64_t length, int64_t offset);
+
+// Vectored forms of the two above for at most IOV_MAX buffers. A short
+// transfer is resumed where it stopped, so the iovecs are modified.
+int64_t preadvFully(int fd, struct iovec *iov, int count, int64_t offset);
+bool writevFully(int fd, struct iovec *iov, int count);
+
+// Offset, length and address alignment that satisfies O_DIRECT on the usual
+// 512-byte and 4K-sector devices.
+const int64_t kDirectIoAlignment = 4096;
+
+// Turns O_DIRECT on or off for an open descriptor. Returns false where the
+// filesystem does not support it (tmpfs, some network filesystems) or off Linux.
+bool setDirectIo(int fd, bool enable);
+
+// Reserves length bytes of disk for fd without changing its size, so a file
+// written front to back gets contiguous extents instead of growing piece by
+// piece. Best effort: returns false where fallocate(2) is unavailable.
+bool preallocate(int fd, int64_t length);
+
+// Keeps a long sequential write from filling the page cache. Each written range
+// is queued for writeback at once; the range before it is waited for and
+// dropped, so at most two ranges per file are dirty and none stay cached.
+// Uses sync_file_range(2) on Linux; elsewhere only the drop is advised.
+class WritebackWindow {
+public:
+    void reset(int fd);
+    void written(int64_t offset, int64_t length);
+    void finish();  // Waits for and drops whatever is still pending
+
+private:
+    int m_fd = -1;
+    int64_t m_pendingOffset = 0;
+    int64_t m_pendingLength = 0;
+};
+
+// Finds the first range of [offset, end) that holds data with SEEK_DATA and
+// SEEK_HOLE. Returns false when the whole of it is a hole. Where the system or
+// filesystem cannot tell, all of it counts as data. Moves the file position.
+bool nextDataRange(int fd, int64_t offset, int64_t end, int64_t *dataStart, int64_t *dataEnd);
+
+// Modification time of st in nanoseconds since the epoch.
+int64_t modificationTimeNs(const struct stat &st);
+
+// The disk holding a path, so jobs on one spindle can be kept from competing.
+struct BlockDevice {
+    // Whole disk for partitions ("sda", "nvme0n1"); "dev:<major>:<minor>" for
+    // filesystems without a block device, such as tmpfs or NFS.
+    std::string name;
+    bool rotational = false;
+};
+
+// Falls back to the device number, non-rotational, where sysfs is unavailable.
+BlockDevice blockDeviceOf(const std::string &path);
+
+// Blocks until a file another process is writing changes, so a reader that hit
+// the current end of file does not have to poll. Uses inotify on Linux; other
+// systems simply sleep for the timeout.
+class GrowthWatcher {
+public:
+    enum Event {
+        Timeout,
+        Modified,
+        // A writer closed the file, or it was moved or deleted. Other writers
+        // may still have it open; see writerStateOf().
+        WriterClosed
+    };
+
+    bool watch(const std::string &path);
+    Event wait(int timeoutMs);
+
+private:
+    UniqueFd m_fd;
+};
+
+enum class WriterState {
+    None,     // No process has the file open for writing
+    Open,     // At least one does
+    Unknown   // Cannot tell on this system
+};
+
+// Whether any process has the file behind fd open for writing. Linux walks
+// /proc/<pid>/fdinfo; processes of other users are only seen when running as
+// root, which is enough for the usual capture tool writing as the same user.
+// The file is matched by device and inode, so renaming it does not matter.
+WriterState writerStateOf(int fd);
+
+// Kernel paths tried by copyFileRange(), fastest first.
+enum class CopyMethod {
+    None,
+    Reflink,        // FICLONERANGE: shares extents, no data is moved (btrfs, XFS)
+    CopyFileRange,  // copy_file_range(2): in-kernel copy, may be offloaded by the filesystem
+    SendFile,       // sendfile(2): in-kernel copy through the page cache
+    ReadWrite       // pread/pwrite through a userspace buffer
+};
+
+const char *copyMethodName(CopyMethod method);
+
+// Receives the number of bytes of the current range copied so far; returning false cancels.
+using CopyProgress = std::function<bool(int64_t bytesCopied)>;
+
+// Copies length bytes from inFd at inOffset to outFd at outOffset without touching
+// either file position. Falls back along the CopyMethod chain when the kernel or
+// filesystem refuses a faster method. Returns false with errno set on failure, or
+// with errno == ECANCELED when progress asked to stop. The last method used is
+// stored in methodUsed if given.
+bool copyFileRange(int inFd, int64_t inOffset, int outFd, int64_t outOffset, int64_t length,
+                   CopyMethod *methodUsed = nullptr, const CopyProgress &progress = CopyProgress());
+
+#endif // POSIXIO_H
@@ -0,0 +1,121 @@
+#include "splitbatch.h"
+#include "bufferring.h"
+#include "posixio.h"
+#include "splitprogress.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <sys/stat.h>
+
+BatchScheduler::BatchScheduler(int threads, int jobsPerDevice)
+    : m_threads(std::max(1, threads)), m_jobsPerDevice(std::max(1, jobsPerDevice)) {}
+
+// Workers claim the first pending job whose disks all have a free slot, so a
+// busy HDD never blocks jobs queued behind it for other devices. The calling
+// thread samples progress and forwards a cancel, as in SplitEngine::runParallel().
+bool BatchScheduler::run(std::vector<BatchJob> &jobs, SplitProgress *progress) {
+    std::map<std::string, int> slots;
+    std::vector<std::vector<std::string>> disks(jobs.size());
+    int64_t totalBytes = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        BatchJob &job = jobs[i];
+        const BlockDevice input = blockDeviceOf(job.options.inputPath);
+        const BlockDevice output = blockDeviceOf(job.options.outputDir);
+        disks[i].push_back(input.name);
+        slots[input.name] = input.rotational ? 1 : m_jobsPerDevice;
+        job.device = input.name;
+        if (output.name != input.name) {
+            disks[i].push_back(output.name);
+            slots[output.name] = output.rotational ? 1 : m_jobsPerDevice;
+            job.device += " -> " + output.name;
+        }
+        struct stat st;
+        if (::stat(job.options.inputPath.c_str(), &st) == 0) job.inputBytes = st.st_size;
+        totalBytes += job.inputBytes;
+    }
+
+    BufferPool pool;
+    std::vector<SplitProgress> jobProgress(jobs.size());
+    std::vector<char> claimed(jobs.size(), 0);
+    std::vector<char> finished(jobs.size(), 0);
+    std::map<std::string, int> busy;
+    size_t pending = jobs.size();
+    int64_t finishedBytes = 0;
+    bool cancelled = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    const auto runnable = [&]() {
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            if (claimed[i]) continue;
+            const bool free = std::all_of(disks[i].begin(), disks[i].end(),
+                                          [&](const std::string &disk) { return busy[disk] < slots[disk]; });
+            if (free) return i;
+        }
+        return jobs.size();
+    };
+
+    const auto runJob = [&](BatchJob &job, SplitProgress &jobProgress) {
+        job.started = true;
+        job.options.bufferPool = &pool;
+        SplitEngine engine(job.options);
+        engine.setProgress(&jobProgress);
+        job.startNs = SplitStats::nowNs();
+        job.ok = engine.run();
+        job.endNs = SplitStats::nowNs();
+        if (!job.ok) job.error = engine.wasCancelled() ? "cancelled" : engine.errorString();
+        job.bulks = engine.stats().bulkCount();
+        if (m_jobFinished) m_jobFinished(job, engine);
+    };
+
+    size_t running = std::min(jobs.size(), static_cast<size_t>(m_threads));
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            size_t next = jobs.size();
+            changed.wait(lock, [&]() { return cancelled || pending == 0 || (next = runnable()) < jobs.size(); });
+            if (cancelled || pending == 0) break;
+            claimed[next] = 1;
+            --pending;
+            for (const std::string &disk : disks[next]) ++busy[disk];
+            lock.unlock();
+
+            runJob(jobs[next], jobProgress[next]);
+
+            lock.lock();
+            for (const std::string &disk : disks[next]) --busy[disk];
+            finished[next] = 1;
+            finishedBytes += jobs[next].inputBytes;
+            changed.notify_all();
+        }
+        --running;
+        changed.notify_all();
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(running);
+    for (size_t i = 0; i < running; ++i) workers.emplace_back(worker);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running > 0) {
+            changed.wait_for(lock, std::chrono::milliseconds(100));
+            if (progress && progress->cancelRequested() && !cancelled) {
+                cancelled = true;
+                for (SplitProgress &each : jobProgress) each.requestCancel();
+                changed.notify_all();
+            }
+            int64_t bytesDone = finishedBytes;
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                if (claimed[i] && !finished[i]) bytesDone += jobProgress[i].sample().bytesDone;
+            }
+            if (progress) progress->publish(bytesDone, totalBytes);
+        }
+    }
+    for (std::thread &thread : workers) thread.join();
+    return !cancelled;
+}
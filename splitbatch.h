@@ -0,0 +1,52 @@
+#ifndef SPLITBATCH_H
+#define SPLITBATCH_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "splitengine.h"
+
+class SplitProgress;
+
+// One input of a batch; the fields after options are filled in by run().
+struct BatchJob {
+    SplitOptions options;
+    std::string device;  // Disk of the input, plus the output's when it differs
+    bool ok = false;
+    bool started = false;
+    std::string error;
+    int64_t inputBytes = 0;
+    int64_t bulks = 0;
+    int64_t startNs = 0;
+    int64_t endNs = 0;
+};
+
+// Splits many inputs on one pool of threads. A job only starts while every
+// disk it touches has a free slot: rotational disks take one job at a time so
+// their heads never seek between two captures, other devices take
+// jobsPerDevice. Throughput therefore scales with the number of devices rather
+// than the number of files. All jobs draw their ring and io_uring buffers from
+// one BufferPool, so memory stays bounded by the jobs actually running.
+class BatchScheduler {
+public:
+    // Called on the worker thread that ran the job, after run() of its engine,
+    // to write per-job sidecars such as manifests while the engine is alive.
+    using JobFinished = std::function<void(BatchJob &job, const SplitEngine &engine)>;
+
+    BatchScheduler(int threads, int jobsPerDevice);
+
+    void setJobFinished(const JobFinished &callback) { m_jobFinished = callback; }
+
+    // Publishes the combined position of all jobs to progress, whose cancel
+    // request stops the running jobs and skips the rest. Returns false when
+    // cancelled; failed jobs are reported in their BatchJob only.
+    bool run(std::vector<BatchJob> &jobs, SplitProgress *progress);
+
+private:
+    int m_threads;
+    int m_jobsPerDevice;
+    JobFinished m_jobFinished;
+};
+
+#endif // SPLITBATCH_H
@@ -0,0 +1,2144 @@
+#include "splitengine.h"
+#include "bufferring.h"
+#include "checksum.h"
+#include "compressedbulk.h"
+#include "zerocheck.h"
+#ifdef __linux__
+#include "uringio.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+// Input not covered by plan, counted as done so progress ends at totalSize
+// even when earlier bulks were kept from a resumed run.
+int64_t bytesBefore(const std::vector<BulkRange> &plan, int64_t totalSize) {
+    int64_t planned = 0;
+    for (const BulkRange &bulk : plan) planned += bulk.length;
+    return totalSize - planned;
+}
+
+using PooledBlock = std::unique_ptr<char, std::function<void(char *)>>;
+
+// Page-aligned block from the pool when there is one, freed or returned by
+// its deleter. Null when the allocation fails.
+PooledBlock allocateBlock(BufferPool *pool, size_t bytes) {
+    void *memory = nullptr;
+    if (pool) {
+        memory = pool->acquire(bytes);
+    } else if (posix_memalign(&memory, 4096, bytes) != 0) {
+        return PooledBlock(nullptr, [](char *) {});
+    }
+    return PooledBlock(static_cast<char *>(memory), [pool, bytes](char *block) {
+        if (pool) {
+            pool->release(block, bytes);
+        } else {
+            std::free(block);
+        }
+    });
+}
+
+} // namespace
+
+SplitEngine::SplitEngine(const SplitOptions &options) : m_options(options) {}
+
+std::string SplitEngine::bulkFilePath(int index, int64_t channel) const {
+    char suffix[64];
+    if (m_options.chunking.isActive() && index >= 1 && static_cast<size_t>(index) <= m_chunkHashes.size()) {
+        std::snprintf(suffix, sizeof(suffix), "chunk_%016llx.bin",
+                      static_cast<unsigned long long>(m_chunkHashes[index - 1]));
+        return m_options.outputDir + "/" + suffix;
+    }
+    if (channel >= 0) {
+        std::snprintf(suffix, sizeof(suffix), "_ch%02lld_%03d.bin", static_cast<long long>(channel), index);
+    } else {
+        std::snprintf(suffix, sizeof(suffix), m_options.codec.empty() ? "_%03d.bin" : "_%03d.cbin", index);
+    }
+    return m_options.outputDir + "/" + m_options.prefix + suffix;
+}
+
+int64_t SplitEngine::outputFrameBytes() const {
+    return m_transformer ? m_transformer->payloadBytes() : m_options.frameSizeBytes;
+}
+
+std::string SplitEngine::journalPath() const {
+    return m_options.outputDir + "/" + m_options.prefix + ".journal";
+}
+
+// Bulks are created under a temporary name, so an interrupted split never leaves
+// a file that looks finished.
+int SplitEngine::openBulk(int index) {
+    const std::string partPath = bulkFilePath(index) + ".part";
+    StageTimer timer(m_stats, SplitStage::Open);
+    // Planned runs size the table up front, so concurrent workers never grow it.
+    if (static_cast<size_t>(index) >= m_bulkOpenedNs.size()) m_bulkOpenedNs.resize(index + 1);
+    m_bulkOpenedNs[index] = SplitStats::nowNs();
+    return ::open(partPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+}
+
+bool SplitEngine::wantsChecksums() const {
+    return m_options.checksums || m_journal.isOpen();
+}
+
+// Publishes a completely written bulk. crc is its CRC32C when the caller hashed
+// the data on the way through; otherwise the bulk is read back if a checksum is
+// needed. With a journal the bulk is synced first, so a journal entry always
+// refers to data that is on disk.
+bool SplitEngine::finishBulk(UniqueFd &fd, int index, int64_t offset, int64_t length, const uint32_t *crc,
+                             std::string *error) {
+    const std::string outPath = bulkFilePath(index);
+    FinishedBulk entry{index, offset, length, crc ? *crc : 0};
+    bool ok = true;
+    if (!crc && wantsChecksums()) {
+        StageTimer timer(m_stats, SplitStage::Hash, length);
+        ok = crc32cFile(fd.get(), length, &entry.crc32c);
+    }
+    if (ok && m_journal.isOpen()) {
+        StageTimer timer(m_stats, SplitStage::Sync);
+        ok = ::fdatasync(fd.get()) == 0;
+    }
+    if (!ok) {
+        *error = "Failed to finish output file: " + outPath + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+    {
+        StageTimer timer(m_stats, SplitStage::Close);
+        fd.reset();
+        ok = std::rename((outPath + ".part").c_str(), outPath.c_str()) == 0;
+    }
+    if (!ok) {
+        *error = "Failed to rename output file: " + outPath + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+    struct stat st;
+    if (m_journal.isOpen() && ::stat(outPath.c_str(), &st) == 0) entry.mtimeNs = modificationTimeNs(st);
+    m_stats.addBulkLatency(SplitStats::nowNs() - m_bulkOpenedNs[index]);
+    if (m_options.checksums) {
+        std::lock_guard<std::mutex> lock(m_finishedMutex);
+        m_finished.push_back(entry);
+    }
+    return !m_journal.isOpen() || m_journal.append(entry, error);
+}
+
+// Plan bulks still to be written. A bulk the journal lists is kept when its
+// file has the recorded size and modification time, or, with verifyResumed or
+// for entries without a time, when it still hashes to the recorded checksum.
+// Bulks finished out of order by parallel jobs are kept wherever they are.
+std::vector<BulkRange> SplitEngine::pendingBulks(const std::vector<BulkRange> &plan, int64_t totalSize) {
+    std::vector<const FinishedBulk *> byIndex(plan.size() + 1, nullptr);
+    for (const FinishedBulk &entry : m_journal.entries()) {
+        if (entry.index >= 1 && static_cast<size_t>(entry.index) <= plan.size()) byIndex[entry.index] = &entry;
+    }
+
+    std::vector<BulkRange> pending;
+    for (const BulkRange &bulk : plan) {
+        const FinishedBulk *entry = byIndex[bulk.index];
+        bool kept = entry && entry->offset == bulk.offset && entry->length == bulk.length;
+        UniqueFd fd(kept ? ::open(bulkFilePath(bulk.index).c_str(), O_RDONLY | O_CLOEXEC) : -1);
+        struct stat st;
+        kept = kept && fd.isValid() && fstat(fd.get(), &st) == 0 && st.st_size == bulk.length;
+        if (kept && (m_options.verifyResumed || entry->mtimeNs < 0 || entry->mtimeNs != modificationTimeNs(st))) {
+            StageTimer timer(m_stats, SplitStage::Hash, bulk.length);
+            uint32_t crc = 0;
+            kept = crc32cFile(fd.get(), bulk.length, &crc) && crc == entry->crc32c;
+        }
+        if (!kept) {
+            pending.push_back(bulk);
+            continue;
+        }
+        if (m_options.checksums) m_finished.push_back(*entry);
+        if (!report(bulk.offset + bulk.length, totalSize)) {
+            m_cancelled = true;
+            break;
+        }
+    }
+    return pending;
+}
+
+bool SplitEngine::report(int64_t bytesDone, int64_t totalBytes) {
+    if (!m_progress) return true;
+    m_progress->publish(bytesDone, totalBytes);
+    return !m_progress->cancelRequested();
+}
+
+bool SplitEngine::cancelRequested() const {
+    return m_progress && m_progress->cancelRequested();
+}
+
+bool SplitEngine::fail(const std::string &message) {
+    m_error = message;
+    return false;
+}
+
+// Returns false with an empty error when progress cancelled the copy.
+bool SplitEngine::copyBulk(int inFd, const BulkRange &bulk, const CopyProgress &progress,
+                           std::string *error) {
+    const std::string outPath = bulkFilePath(bulk.index);
+    UniqueFd outFd(openBulk(bulk.index));
+    if (!outFd.isValid()) {
+        *error = "Cannot create output file: " + outPath;
+        return false;
+    }
+    if (m_options.sparse) return copySparseBulk(inFd, bulk, outFd, progress, error);
+    if (m_transformer) return transformBulk(inFd, bulk, outFd, progress, error);
+    {
+        // copyFileRange() reports progress once per kernel call.
+        StageTimer timer(m_stats, SplitStage::Copy);
+        int64_t calls = 0;
+        int64_t copied = 0;
+        const CopyProgress counted = [&](int64_t bytesCopied) {
+            ++calls;
+            copied = bytesCopied;
+            return !progress || progress(bytesCopied);
+        };
+        const bool ok = copyFileRange(inFd, bulk.offset, outFd.get(), 0, bulk.length, nullptr, counted);
+        timer.setBytes(copied);
+        timer.setCalls(calls);
+        if (!ok) {
+            if (errno != ECANCELED) {
+                *error = "Failed to write output file: " + outPath + " (" + std::strerror(errno) + ")";
+            }
+            return false;
+        }
+    }
+    return finishBulk(outFd, bulk.index, bulk.offset, bulk.length, nullptr, error);
+}
+
+namespace {
+// Input read per step of a sparse or transformed copy.
+const int64_t kSparseStepBytes = 1024 * 1024;
+}
+
+// Holes of the input are skipped unread, whole frames at a time, and hashed as
+// zeros without touching them. Ranges with data are read and each frame is
+// checked; runs of frames holding data are written at their offsets and
+// all-zero frames are left out. Truncating the bulk to its length leaves every
+// gap as a hole wherever the output filesystem supports sparse files.
+bool SplitEngine::copySparseBulk(int inFd, const BulkRange &bulk, UniqueFd &outFd, const CopyProgress &progress,
+                                 std::string *error) {
+    const std::string outPath = bulkFilePath(bulk.index);
+    const int64_t frameSize = m_options.frameSizeBytes;
+    const int64_t stepBytes = std::max<int64_t>(1, kSparseStepBytes / frameSize) * frameSize;
+    std::vector<char> step(static_cast<size_t>(std::min(stepBytes, bulk.length)));
+    const bool hashing = wantsChecksums();
+    const int64_t end = bulk.offset + bulk.length;
+    uint32_t crc = 0;
+    int64_t skipped = 0;
+
+    for (int64_t pos = bulk.offset; pos < end;) {
+        if (progress && !progress(pos - bulk.offset)) return false;
+        int64_t dataStart;
+        int64_t dataEnd;
+        if (!nextDataRange(inFd, pos, end, &dataStart, &dataEnd)) dataStart = end;
+        const int64_t holeFrames = (dataStart - pos) / frameSize;
+        if (holeFrames > 0) {
+            const int64_t hole = dataStart == end ? end - pos : holeFrames * frameSize;
+            if (hashing) crc = crc32cZeros(crc, hole);
+            skipped += hole;
+            pos += hole;
+            continue;
+        }
+        // Whole frames up to the end of the data, which is where the next hole starts.
+        const int64_t want = std::min({stepBytes, end - pos, (dataEnd - pos + frameSize - 1) / frameSize * frameSize});
+        {
+            StageTimer timer(m_stats, SplitStage::Read, want);
+            const int64_t got = preadFully(inFd, step.data(), want, pos);
+            if (got != want) {
+                *error = got < 0 ? "Failed to read input file: " + m_options.inputPath + " (" + std::strerror(errno) + ")"
+                                 : "Input file shrank while splitting: " + m_options.inputPath;
+                return false;
+            }
+        }
+        if (hashing) {
+            StageTimer timer(m_stats, SplitStage::Hash, want);
+            crc = crc32c(crc, step.data(), static_cast<size_t>(want));
+        }
+        StageTimer timer(m_stats, SplitStage::Write);
+        int64_t runStart = -1;
+        int64_t written = 0;
+        const auto writeRun = [&](int64_t runEnd) {
+            if (!pwriteFully(outFd.get(), step.data() + runStart, runEnd - runStart, pos - bulk.offset + runStart)) {
+                *error = "Failed to write output file: " + outPath + " (" + std::strerror(errno) + ")";
+                return false;
+            }
+            written += runEnd - runStart;
+            runStart = -1;
+            return true;
+        };
+        for (int64_t frame = 0; frame < want; frame += frameSize) {
+            const bool zero = isAllZero(step.data() + frame, static_cast<size_t>(std::min(frameSize, want - frame)));
+            if (!zero && runStart < 0) runStart = frame;
+            if (zero && runStart >= 0 && !writeRun(frame)) return false;
+        }
+        if (runStart >= 0 && !writeRun(want)) return false;
+        timer.setBytes(written);
+        skipped += want - written;
+        pos += want;
+    }
+    if (::ftruncate(outFd.get(), bulk.length) != 0) {
+        *error = "Failed to write output file: " + outPath + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+    m_sparseBytes += skipped;
+    return finishBulk(outFd, bulk.index, bulk.offset, bulk.length, hashing ? &crc : nullptr, error);
+}
+
+// Whole frames are read in steps, transformed into a second buffer and appended
+// to the bulk. The input side is hashed too, so the input checksum can still
+// be chained from the bulks in plan order.
+bool SplitEngine::transformBulk(int inFd, const BulkRange &bulk, UniqueFd &outFd, const CopyProgress &progress,
+                                std::string *error) {
+    const std::string outPath = bulkFilePath(bulk.index);
+    const int64_t frameSize = m_options.frameSizeBytes;
+    const int64_t stepBytes = std::max<int64_t>(1, kSparseStepBytes / frameSize) * frameSize;
+    std::vector<char> step(static_cast<size_t>(std::min(stepBytes, bulk.length)));
+    std::vector<char> out(static_cast<size_t>(m_transformer->outputBytes(static_cast<int64_t>(step.size()))));
+    const bool hashing = wantsChecksums();
+    uint32_t crc = 0;
+    uint32_t sourceCrc = 0;
+    int64_t written = 0;
+
+    for (int64_t done = 0; done < bulk.length;) {
+        if (progress && !progress(done)) return false;
+        const int64_t want = std::min(stepBytes, bulk.length - done);
+        {
+            StageTimer timer(m_stats, SplitStage::Read, want);
+            const int64_t got = preadFully(inFd, step.data(), want, bulk.offset + done);
+            if (got != want) {
+                *error = got < 0 ? "Failed to read input file: " + m_options.inputPath + " (" + std::strerror(errno) + ")"
+                                 : "Input file shrank while splitting: " + m_options.inputPath;
+                return false;
+            }
+        }
+        const size_t frames = static_cast<size_t>(want / frameSize);
+        size_t outBytes;
+        {
+            StageTimer timer(m_stats, SplitStage::Transform, want);
+            m_transformer->apply(step.data(), frames, out.data());
+            outBytes = frames * static_cast<size_t>(m_transformer->payloadBytes());
+            // Only the end of the input can hold a partial frame.
+            outBytes += m_transformer->applyPartial(step.data() + frames * frameSize,
+                                                    static_cast<size_t>(want % frameSize), out.data() + outBytes);
+        }
+        if (hashing) {
+            StageTimer timer(m_stats, SplitStage::Hash, want + static_cast<int64_t>(outBytes));
+            crc = crc32c(crc, out.data(), outBytes);
+            if (m_options.checksums) sourceCrc = crc32c(sourceCrc, step.data(), static_cast<size_t>(want));
+        }
+        bool ok;
+        {
+            StageTimer timer(m_stats, SplitStage::Write, static_cast<int64_t>(outBytes));
+            ok = writeFully(outFd.get(), out.data(), static_cast<int64_t>(outBytes));
+        }
+        if (!ok) {
+            *error = "Failed to write output file: " + outPath + " (" + std::strerror(errno) + ")";
+            return false;
+        }
+        written += static_cast<int64_t>(outBytes);
+        done += want;
+    }
+    if (m_options.checksums) m_sourceCrcs[bulk.index] = sourceCrc;
+    return finishBulk(outFd, bulk.index, bulk.offset, written, hashing ? &crc : nullptr, error);
+}
+
+namespace {
+
+enum SplitMode : unsigned {
+    ModeResync = 1u << 0,
+    ModeResume = 1u << 1,
+    ModeStreamed = 1u << 2,
+    ModeIndex = 1u << 3,
+    ModeExtract = 1u << 4,
+    ModeDemux = 1u << 5,
+    ModeDirectIo = 1u << 6,
+    ModeChunked = 1u << 7,
+    ModeSparse = 1u << 8,
+    ModeCompressed = 1u << 9,
+    ModeTransform = 1u << 10
+};
+
+struct SplitModeRule {
+    SplitMode mode;
+    const char *name;     // Subject of the error when another mode excludes this one
+    const char *context;  // Ends the error when this mode excludes another
+    unsigned excludes;
+};
+
+// Every mode and the modes it rules out, and why:
+// - resync bulk boundaries depend on the data, so only planned splits resume;
+// - streamed input has no known size to plan, resync ahead, or journal by;
+// - extracted and demultiplexed bulks hold a selection, so they neither tile
+//   the input for a journal nor describe its frames for an index;
+// - content-defined cuts are only known once the data is read, and a rerun
+//   already skips the bulks that exist;
+// - compressed bulks are written block by block from a plan, which the
+//   excluded modes either lack or write some other way;
+// - transformed bulks are written frame by frame and no longer match the
+//   input's layout.
+const SplitModeRule kSplitModeRules[] = {
+    {ModeResync, "Resynchronizing", "when resynchronizing", ModeResume},
+    {ModeResume, "Resuming", "when resuming", 0},
+    {ModeStreamed, "Streamed input", "for streamed input", ModeResync | ModeResume},
+    {ModeIndex, "A frame index", "when writing a frame index", 0},
+    {ModeExtract, "Extracting frames", "when extracting frames", ModeResync | ModeResume | ModeIndex | ModeStreamed},
+    {ModeDemux, "Demultiplexing", "when demultiplexing",
+     ModeResync | ModeResume | ModeIndex | ModeStreamed | ModeExtract},
+    {ModeDirectIo, "Direct I/O", "with direct I/O", 0},
+    {ModeChunked, "Content-defined splitting", "for content-defined splits",
+     ModeResync | ModeResume | ModeDirectIo | ModeStreamed | ModeExtract | ModeDemux},
+    {ModeSparse, "Sparse output", "with sparse output", 0},
+    {ModeCompressed, "Compression", "with compression",
+     ModeResync | ModeResume | ModeDirectIo | ModeSparse | ModeExtract | ModeDemux | ModeChunked | ModeStreamed},
+    {ModeTransform, "A frame transform", "with a frame transform",
+     ModeResume | ModeSparse | ModeCompressed | ModeExtract | ModeDemux | ModeChunked | ModeStreamed},
+};
+
+// Error for the first pair of active modes that cannot run together, or empty.
+std::string modeConflict(unsigned modes) {
+    for (const SplitModeRule &rule : kSplitModeRules) {
+        if (!(modes & rule.mode)) continue;
+        for (const SplitModeRule &other : kSplitModeRules) {
+            if ((modes & other.mode) && (rule.excludes & other.mode)) {
+                return std::string(other.name) + " is not supported " + rule.context;
+            }
+        }
+    }
+    return std::string();
+}
+
+} // namespace
+
+bool SplitEngine::run() {
+    m_cancelled = false;
+    m_error.clear();
+    m_syncGaps.clear();
+    m_skippedBytes = 0;
+    m_usedIndex = false;
+    m_resumedBulks = 0;
+    m_finished.clear();
+    m_hasInputCrc = false;
+    m_inputCrc = 0;
+    m_streamed = false;
+    m_extractedFrames = 0;
+    m_demuxChannels = 0;
+    m_demuxBulks = 0;
+    m_sparseBytes = 0;
+    m_compressedBytes = 0;
+    m_transformer.reset();
+    m_sourceCrcs.clear();
+    m_reusedBulks = 0;
+    m_reusedBytes = 0;
+    m_chunkHashes.clear();
+    m_inputBytes = 0;
+    m_stats.reset();
+    m_bulkOpenedNs.clear();
+
+    if (m_options.frameSizeBytes <= 0) {
+        return fail("Invalid frame size: " + std::to_string(m_options.frameSizeBytes));
+    }
+    if (m_options.resync && m_options.syncWord.empty()) {
+        return fail("A sync word is required to resynchronize frames");
+    }
+    const bool fromStdin = m_options.inputPath == "-";
+    UniqueFd inFd(fromStdin ? ::dup(STDIN_FILENO) : ::open(m_options.inputPath.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat st;
+    if (!inFd.isValid() || fstat(inFd.get(), &st) != 0) {
+        return fail("Input file not found: " + m_options.inputPath);
+    }
+    const bool streamed = fromStdin || m_options.follow || !S_ISREG(st.st_mode);
+    const unsigned modes = (m_options.resync ? ModeResync : 0u) | (m_options.resume ? ModeResume : 0u)
+                           | (streamed ? ModeStreamed : 0u) | (m_options.writeIndex ? ModeIndex : 0u)
+                           | (m_options.extract.isActive() ? ModeExtract : 0u)
+                           | (m_options.demux.isActive() ? ModeDemux : 0u) | (m_options.directIo ? ModeDirectIo : 0u)
+                           | (m_options.chunking.isActive() ? ModeChunked : 0u) | (m_options.sparse ? ModeSparse : 0u)
+                           | (!m_options.codec.empty() ? ModeCompressed : 0u)
+                           | (m_options.transform.isActive() ? ModeTransform : 0u);
+    const std::string conflict = modeConflict(modes);
+    if (!conflict.empty()) return fail(conflict);
+
+    if (!m_options.codec.empty() && !createBulkCodec(m_options.codec)) {
+        return fail("Unknown compression codec: " + m_options.codec);
+    }
+    if (m_options.transform.isActive()) {
+        FrameTransform &transform = m_options.transform;
+        if (transform.stripSyncWord) {
+            if (m_options.syncWord.empty()) return fail("A sync word is required to strip it from the frames");
+            transform.stripBytes = static_cast<int>(m_options.syncWord.size());
+        }
+        const std::string invalid = FrameTransformer::check(transform, m_options.frameSizeBytes);
+        if (!invalid.empty()) return fail(invalid);
+        m_transformer.reset(new FrameTransformer(transform, m_options.frameSizeBytes));
+    }
+
+    if (streamed) {
+        if (m_options.writeIndex && !S_ISREG(st.st_mode)) {
+            return fail("A frame index can only be written for a regular input file");
+        }
+        m_streamed = true;
+        return runStream(inFd.get());
+    }
+
+    const int64_t totalSize = st.st_size;
+    m_inputBytes = totalSize;
+    if (m_options.extract.isActive() || m_options.demux.isActive()) {
+        return m_options.demux.isActive() ? runDemux(inFd.get(), totalSize) : runExtract(inFd.get(), totalSize);
+    }
+    // Content-defined bulks are reassembled from their checksums alone.
+    if (m_options.chunking.isActive()) m_options.checksums = true;
+    const int64_t mtimeNs = modificationTimeNs(st);
+    m_backendUsed = IoBackend::Posix;
+    m_index.reset(totalSize, mtimeNs, m_options.frameSizeBytes, m_options.syncWord,
+                  m_options.resync ? uint32_t(FrameIndexRun::SyncChecked) : 0u);
+
+    bool ok;
+    if (m_options.resync) {
+        // Bulk boundaries depend on the data, so there is no plan to run ahead on.
+        FrameIndex index;
+        // The index path copies runs in the kernel, so a transform has to resync.
+        m_usedIndex = !m_transformer && index.open(frameIndexPath(m_options.inputPath))
+                      && index.matches(totalSize, mtimeNs)
+                      && (index.flags() & FrameIndexRun::SyncChecked)
+                      && index.frameSize() == m_options.frameSizeBytes && index.syncWord() == m_options.syncWord;
+        ok = m_usedIndex ? runIndexed(inFd.get(), index, totalSize) : runResync(inFd.get(), totalSize);
+        if (ok && m_options.checksums && !m_hasInputCrc) {
+            // The index path never reads the input, so hash it separately.
+            if (!crc32cFile(inFd.get(), totalSize, &m_inputCrc)) {
+                return fail("Failed to read input file: " + m_options.inputPath + " (" + std::strerror(errno) + ")");
+            }
+            m_hasInputCrc = true;
+        }
+    } else if (m_options.chunking.isActive()) {
+        ok = runChunked(inFd.get(), totalSize);
+    } else {
+        const std::vector<BulkRange> plan = planBulks(totalSize, m_options.bulkSizeBytes,
+                                                      m_options.frameSizeBytes);
+        if (m_options.resume) {
+            char identity[160];
+            std::snprintf(identity, sizeof(identity), "input %lld %lld frame %d bulk %lld",
+                          static_cast<long long>(totalSize), static_cast<long long>(mtimeNs),
+                          m_options.frameSizeBytes, static_cast<long long>(m_options.bulkSizeBytes));
+            std::string error;
+            if (!m_journal.open(journalPath(), identity, true, &error)) return fail(error);
+        }
+        const std::vector<BulkRange> todo = m_options.resume ? pendingBulks(plan, totalSize) : plan;
+        if (m_cancelled) return false;
+        m_resumedBulks = static_cast<int>(plan.size() - todo.size());
+        m_bulkOpenedNs.resize(plan.size() + 1);
+        if (m_transformer) m_sourceCrcs.resize(plan.size() + 1);
+        // The streaming modes read the input from the first bulk to the end,
+        // so bulks left between finished ones are copied one by one.
+        const bool tail = todo.empty() || todo.size() == plan.size() - static_cast<size_t>(todo.front().index - 1);
+        ok = todo.empty()
+             || (!tail ? runBulkByBulk(inFd.get(), todo, totalSize)
+                 : m_options.codec.empty() ? runPlanned(inFd.get(), todo, totalSize)
+                                           : runCompressed(inFd.get(), todo, totalSize));
+        if (ok && m_journal.isOpen()) m_journal.remove();
+        if (ok && m_options.checksums && !m_hasInputCrc) {
+            // The bulks tile the input, so their checksums chain into the input's.
+            std::sort(m_finished.begin(), m_finished.end(),
+                      [](const FinishedBulk &a, const FinishedBulk &b) { return a.index < b.index; });
+            for (const FinishedBulk &bulk : m_finished) {
+                // Transformed bulks hold less than their input range; its own checksum was kept.
+                const uint32_t crc = m_transformer ? m_sourceCrcs[bulk.index] : bulk.crc32c;
+                m_inputCrc = crc32cCombine(m_inputCrc, crc, plan[bulk.index - 1].length);
+            }
+            m_hasInputCrc = true;
+        }
+        const int64_t frameSize = m_options.frameSizeBytes;
+        for (const BulkRange &bulk : plan) {
+            m_index.addFrames(bulk.offset, (bulk.length + frameSize - 1) / frameSize, bulk.index, 0);
+        }
+    }
+
+    if (!ok || !m_options.writeIndex) return ok;
+    std::string error;
+    return m_index.write(frameIndexPath(m_options.inputPath), &error) || fail(error);
+}
+
+bool SplitEngine::runPlanned(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize) {
+    // Sparse and transformed bulks are built in userspace by copyBulk(), bulk by bulk.
+    const bool perBulk = m_options.sparse || m_transformer != nullptr;
+#ifdef __linux__
+    if (m_options.ioBackend == IoBackend::Uring && !m_options.directIo && !perBulk && IoUring::isAvailable()) {
+        // isAvailable() probes a small ring; the configured depth may still be
+        // refused, e.g. by RLIMIT_MEMLOCK, and then the POSIX path takes over.
+        bool started = false;
+        const bool ok = runUring(inFd, plan, totalSize, &started);
+        if (started) {
+            m_backendUsed = IoBackend::Uring;
+            return ok;
+        }
+    }
+#endif
+    if (m_options.directIo && !perBulk) {
+        return runDirect(inFd, plan, totalSize);
+    }
+    if (m_options.pipelined && !perBulk) {
+        return runPipelined(inFd, plan, totalSize);
+    }
+    return runBulkByBulk(inFd, plan, totalSize);
+}
+
+// Copies each bulk on its own, so plan may have gaps.
+bool SplitEngine::runBulkByBulk(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize) {
+    if (m_options.jobs > 1 && plan.size() > 1) {
+        return runParallel(inFd, plan, totalSize);
+    }
+
+    int64_t bytesDone = bytesBefore(plan, totalSize);
+    for (const BulkRange &bulk : plan) {
+        const CopyProgress progress = [&](int64_t copied) {
+            return report(bytesDone + copied, totalSize);
+        };
+        std::string error;
+        if (!copyBulk(inFd, bulk, progress, &error)) {
+            m_cancelled = error.empty();
+            return m_cancelled ? false : fail(error);
+        }
+        bytesDone += bulk.length;
+    }
+    return true;
+}
+
+// Workers pull the next unclaimed bulk until the plan is exhausted. The calling
+// thread only samples progress, so the callback keeps running on one thread.
+bool SplitEngine::runParallel(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize) {
+    const size_t workerCount = std::min(plan.size(), static_cast<size_t>(m_options.jobs));
+    std::atomic<size_t> nextBulk(0);
+    std::atomic<int64_t> bytesDone(bytesBefore(plan, totalSize));
+    std::atomic<bool> stop(false);
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t running = workerCount;
+    std::string firstError;
+
+    auto worker = [&]() {
+        for (size_t i = nextBulk++; i < plan.size() && !stop; i = nextBulk++) {
+            int64_t reported = 0;
+            const CopyProgress progress = [&](int64_t copied) {
+                bytesDone += copied - reported;
+                reported = copied;
+                return !stop.load() && !cancelRequested();
+            };
+            std::string error;
+            if (!copyBulk(inFd, plan[i], progress, &error)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error.empty() && firstError.empty()) firstError = error;
+                stop = true;
+                break;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        --running;
+        finished.notify_one();
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) workers.emplace_back(worker);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running > 0) {
+            finished.wait_for(lock, std::chrono::milliseconds(100));
+            lock.unlock();
+            if (!report(bytesDone.load(), totalSize)) {
+                m_cancelled = true;
+                stop = true;
+            }
+            lock.lock();
+        }
+    }
+    for (std::thread &thread : workers) thread.join();
+
+    if (!firstError.empty()) {
+        m_cancelled = false;
+        return fail(firstError);
+    }
+    return !m_cancelled;
+}
+
+// Producer stage shared by the ring-based modes: fills the ring with the input
+// from startOffset on, in order, then marks it finished.
+void SplitEngine::readInto(BufferRing &ring, int inFd, int64_t startOffset, int64_t totalSize, int64_t alignment,
+                           std::string *error) {
+    posix_fadvise(inFd, startOffset, 0, POSIX_FADV_SEQUENTIAL);
+    for (int64_t offset = startOffset; offset < totalSize;) {
+        BufferRing::Slot *slot = ring.beginWrite();
+        if (!slot) return;
+        const int64_t wanted = std::min<int64_t>(ring.bufferBytes(), totalSize - offset);
+        // O_DIRECT needs whole blocks even for the last one; the read simply stops at the end of file.
+        const int64_t request = (wanted + alignment - 1) / alignment * alignment;
+        int64_t got;
+        {
+            StageTimer timer(m_stats, SplitStage::Read, wanted);
+            got = preadFully(inFd, slot->data, request, offset);
+        }
+        if (alignment > 1 && got > 0) posix_fadvise(inFd, offset, got, POSIX_FADV_DONTNEED);
+        got = std::min(got, wanted);  // A file that grew since the plan may return more
+        if (got != wanted) {
+            *error = "Failed to read input file: " + m_options.inputPath + " ("
+                     + (got < 0 ? std::strerror(errno) : "unexpected end of file") + ")";
+            ring.cancel();
+            return;
+        }
+        slot->size = static_cast<size_t>(got);
+        slot->offset = offset;
+        ring.endWrite();
+        offset += got;
+    }
+    ring.finish();
+}
+
+bool SplitEngine::runPipelined(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize) {
+    BufferRing ring(m_options.ringDepth, static_cast<size_t>(std::max<int64_t>(m_options.bufferBytes, 4096)), 0,
+                    m_options.bufferPool);
+    std::string readError;
+
+    std::thread reader(&SplitEngine::readInto, this, std::ref(ring), inFd, plan.front().offset, totalSize,
+                       int64_t(1), &readError);
+
+    size_t bulkIndex = 0;
+    int64_t bulkWritten = 0;
+    uint32_t bulkCrc = 0;
+    const bool hashing = wantsChecksums();
+    int64_t bytesDone = plan.front().offset;
+    UniqueFd outFd;
+    std::string writeError;
+
+    // A buffer may straddle a bulk boundary, so it is written in up to as many
+    // pieces as it touches bulks.
+    auto writeSlot = [&](const char *data, int64_t size) {
+        while (size > 0) {
+            const BulkRange &bulk = plan[bulkIndex];
+            if (!outFd.isValid()) {
+                const std::string outPath = bulkFilePath(bulk.index);
+                outFd.reset(openBulk(bulk.index));
+                if (!outFd.isValid()) {
+                    writeError = "Cannot create output file: " + outPath;
+                    return false;
+                }
+            }
+            const int64_t piece = std::min(size, bulk.length - bulkWritten);
+            if (hashing) {
+                StageTimer timer(m_stats, SplitStage::Hash, piece);
+                bulkCrc = crc32c(bulkCrc, data, static_cast<size_t>(piece));
+            }
+            bool written;
+            {
+                StageTimer timer(m_stats, SplitStage::Write, piece);
+                written = writeFully(outFd.get(), data, piece);
+            }
+            if (!written) {
+                writeError = "Failed to write output file: " + bulkFilePath(bulk.index) + " ("
+                             + std::strerror(errno) + ")";
+                return false;
+            }
+            data += piece;
+            size -= piece;
+            bulkWritten += piece;
+            if (bulkWritten == bulk.length) {
+                if (!finishBulk(outFd, bulk.index, bulk.offset, bulk.length, hashing ? &bulkCrc : nullptr,
+                                &writeError)) {
+                    return false;
+                }
+                ++bulkIndex;
+                bulkWritten = 0;
+                bulkCrc = 0;
+            }
+        }
+        return true;
+    };
+
+    while (BufferRing::Slot *slot = ring.beginRead()) {
+        const int64_t size = static_cast<int64_t>(slot->size);
+        const bool written = writeSlot(slot->data, size);
+        ring.endRead();
+        if (!written) {
+            ring.cancel();
+            break;
+        }
+        bytesDone += size;
+        if (!report(bytesDone, totalSize)) {
+            m_cancelled = true;
+            ring.cancel();
+            break;
+        }
+    }
+    reader.join();
+
+    if (!writeError.empty()) return fail(writeError);
+    if (!readError.empty()) return fail(readError);
+    return !m_cancelled;
+}
+
+// Like runPipelined(), but neither side goes through the page cache. The input
+// is read in aligned blocks from an O_DIRECT descriptor. Bulk boundaries fall on
+// frames rather than blocks, so each bulk is assembled in an aligned staging
+// buffer and written in whole blocks into a file preallocated to its planned
+// size; the last, partial block is padded and the file truncated back to the
+// bulk length. Where a filesystem refuses O_DIRECT the same code runs buffered,
+// with every written range pushed out and dropped by a WritebackWindow.
+bool SplitEngine::runDirect(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize) {
+    const int64_t align = kDirectIoAlignment;
+    const size_t bufferBytes = static_cast<size_t>((std::max(m_options.bufferBytes, align) + align - 1) / align * align);
+    UniqueFd directIn(::open(m_options.inputPath.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT));
+    const int readFd = directIn.isValid() ? directIn.get() : inFd;
+
+    BufferRing ring(m_options.ringDepth, bufferBytes, 0, m_options.bufferPool);
+    const PooledBlock staging = allocateBlock(m_options.bufferPool, bufferBytes);
+    if (!staging) return fail("Cannot allocate I/O buffers");
+    std::string readError;
+    const int64_t readStart = plan.front().offset / align * align;
+    std::thread reader(&SplitEngine::readInto, this, std::ref(ring), readFd, readStart, totalSize, align,
+                       &readError);
+
+    size_t bulkIndex = 0;
+    int64_t bulkWritten = 0;  // Bytes of the current bulk staged or written
+    int64_t fileOffset = 0;   // Where the staging buffer goes in the current bulk file
+    size_t staged = 0;
+    uint32_t bulkCrc = 0;
+    const bool hashing = wantsChecksums();
+    bool direct = false;
+    UniqueFd outFd;
+    WritebackWindow writeback;
+    std::string writeError;
+
+    const auto writeFailed = [&](const BulkRange &bulk) {
+        writeError = "Failed to write output file: " + bulkFilePath(bulk.index) + " (" + std::strerror(errno) + ")";
+        return false;
+    };
+
+    // Writes the staging buffer; the bulk's last piece is padded to a whole block.
+    const auto flush = [&](const BulkRange &bulk, bool last) {
+        size_t length = staged;
+        if (direct && last) {
+            length = static_cast<size_t>((staged + align - 1) / align * align);
+            std::memset(staging.get() + staged, 0, length - staged);
+        }
+        bool written;
+        {
+            StageTimer timer(m_stats, SplitStage::Write, static_cast<int64_t>(staged));
+            written = writeFully(outFd.get(), staging.get(), static_cast<int64_t>(length));
+        }
+        if (!written) return writeFailed(bulk);
+        if (!direct) {
+            StageTimer timer(m_stats, SplitStage::Sync);
+            writeback.written(fileOffset, static_cast<int64_t>(length));
+        }
+        fileOffset += static_cast<int64_t>(length);
+        staged = 0;
+        return true;
+    };
+
+    const auto consume = [&](const char *data, int64_t size) {
+        while (size > 0) {
+            const BulkRange &bulk = plan[bulkIndex];
+            if (!outFd.isValid()) {
+                outFd.reset(openBulk(bulk.index));
+                if (!outFd.isValid()) {
+                    writeError = "Cannot create output file: " + bulkFilePath(bulk.index);
+                    return false;
+                }
+                direct = setDirectIo(outFd.get(), true);
+                preallocate(outFd.get(), bulk.length);
+                writeback.reset(direct ? -1 : outFd.get());
+                fileOffset = 0;
+            }
+            const int64_t piece = std::min({size, bulk.length - bulkWritten,
+                                            static_cast<int64_t>(bufferBytes - staged)});
+            std::memcpy(staging.get() + staged, data, static_cast<size_t>(piece));
+            if (hashing) {
+                StageTimer timer(m_stats, SplitStage::Hash, piece);
+                bulkCrc = crc32c(bulkCrc, data, static_cast<size_t>(piece));
+            }
+            staged += static_cast<size_t>(piece);
+            bulkWritten += piece;
+            data += piece;
+            size -= piece;
+
+            const bool last = bulkWritten == bulk.length;
+            if ((staged == bufferBytes || last) && !flush(bulk, last)) return false;
+            if (!last) continue;
+            if (fileOffset != bulk.length && ::ftruncate(outFd.get(), bulk.length) != 0) return writeFailed(bulk);
+            {
+                StageTimer timer(m_stats, SplitStage::Sync);
+                writeback.finish();
+            }
+            if (!finishBulk(outFd, bulk.index, bulk.offset, bulk.length, hashing ? &bulkCrc : nullptr,
+                            &writeError)) {
+                return false;
+            }
+            ++bulkIndex;
+            bulkWritten = 0;
+            bulkCrc = 0;
+        }
+        return true;
+    };
+
+    int64_t bytesDone = plan.front().offset;
+    while (BufferRing::Slot *slot = ring.beginRead()) {
+        // The first block may start before the first bulk when resuming.
+        const int64_t skip = std::max<int64_t>(0, plan.front().offset - slot->offset);
+        const int64_t size = static_cast<int64_t>(slot->size) - skip;
+        const bool written = size <= 0 || consume(slot->data + skip, size);
+        ring.endRead();
+        if (!written) {
+            ring.cancel();
+            break;
+        }
+        bytesDone += std::max<int64_t>(size, 0);
+        if (!report(bytesDone, totalSize)) {
+            m_cancelled = true;
+            ring.cancel();
+            break;
+        }
+    }
+    reader.join();
+
+    if (!writeError.empty()) return fail(writeError);
+    if (!readError.empty()) return fail(readError);
+    return !m_cancelled;
+}
+
+// Frames are validated against the sync word as they stream through the ring and
+// written in runs; bytes between a lost and a regained lock never reach a bulk,
+// so every bulk starts on a real frame. The tail the synchronizer cannot decide
+// on yet is copied into the next slot's headroom to keep frames contiguous.
+bool SplitEngine::runResync(int inFd, int64_t totalSize) {
+    const int64_t frameSize = m_options.frameSizeBytes;
+    const int64_t framesPerBulk = std::max<int64_t>(1, m_options.bulkSizeBytes / frameSize);
+    const int64_t outFrameBytes = outputFrameBytes();
+    int bulkIndex = 0;
+    int64_t framesInBulk = 0;
+    int64_t bulkStart = 0;
+    uint32_t bulkCrc = 0;
+    const bool hashing = wantsChecksums();
+    UniqueFd outFd;
+    std::string writeError;
+    std::vector<char> transformed;
+
+    const FrameSynchronizer::FrameSink sink = [&](const char *data, int64_t inputOffset, size_t frameCount) {
+        int64_t remaining = static_cast<int64_t>(frameCount);
+        while (remaining > 0) {
+            if (!outFd.isValid()) {
+                const std::string outPath = bulkFilePath(++bulkIndex);
+                outFd.reset(openBulk(bulkIndex));
+                if (!outFd.isValid()) {
+                    writeError = "Cannot create output file: " + outPath;
+                    return false;
+                }
+                bulkStart = inputOffset;
+            }
+            const int64_t frames = std::min(remaining, framesPerBulk - framesInBulk);
+            const char *out = data;
+            if (m_transformer) {
+                StageTimer timer(m_stats, SplitStage::Transform, frames * frameSize);
+                transformed.resize(static_cast<size_t>(frames * outFrameBytes));
+                m_transformer->apply(data, static_cast<size_t>(frames), transformed.data());
+                out = transformed.data();
+            }
+            if (hashing) {
+                StageTimer timer(m_stats, SplitStage::Hash, frames * outFrameBytes);
+                bulkCrc = crc32c(bulkCrc, out, static_cast<size_t>(frames * outFrameBytes));
+            }
+            bool written;
+            {
+                StageTimer timer(m_stats, SplitStage::Write, frames * outFrameBytes);
+                written = writeFully(outFd.get(), out, frames * outFrameBytes);
+            }
+            if (!written) {
+                writeError = "Failed to write output file: " + bulkFilePath(bulkIndex) + " ("
+                             + std::strerror(errno) + ")";
+                return false;
+            }
+            m_index.addFrames(inputOffset, frames, bulkIndex, FrameIndexRun::SyncChecked | FrameIndexRun::SyncValid);
+            data += frames * frameSize;
+            inputOffset += frames * frameSize;
+            remaining -= frames;
+            framesInBulk += frames;
+            if (framesInBulk == framesPerBulk) {
+                if (!finishBulk(outFd, bulkIndex, bulkStart, framesInBulk * outFrameBytes, hashing ? &bulkCrc : nullptr,
+                                &writeError)) {
+                    return false;
+                }
+                framesInBulk = 0;
+                bulkCrc = 0;
+            }
+        }
+        return true;
+    };
+
+    FrameSynchronizer synchronizer(m_options.syncWord, m_options.frameSizeBytes, sink);
+    BufferRing ring(m_options.ringDepth, static_cast<size_t>(std::max<int64_t>(m_options.bufferBytes, 4096)),
+                    synchronizer.lookaheadBytes(), m_options.bufferPool);
+    std::string readError;
+    std::thread reader(&SplitEngine::readInto, this, std::ref(ring), inFd, int64_t(0), totalSize, int64_t(1),
+                       &readError);
+
+    std::vector<char> carry;
+    carry.reserve(synchronizer.lookaheadBytes());
+    int64_t bytesDone = 0;
+    uint32_t inputCrc = 0;
+
+    while (BufferRing::Slot *slot = ring.beginRead()) {
+        // Bulks hold only the valid frames, so the input checksum cannot be
+        // combined from theirs; hash the slot before the carry is prepended.
+        if (m_options.checksums) {
+            StageTimer timer(m_stats, SplitStage::Hash, static_cast<int64_t>(slot->size));
+            inputCrc = crc32c(inputCrc, slot->data, slot->size);
+        }
+        char *start = slot->data - carry.size();
+        std::memcpy(start, carry.data(), carry.size());
+        const size_t size = carry.size() + slot->size;
+        const bool atEnd = slot->offset + static_cast<int64_t>(slot->size) == totalSize;
+        const int64_t used = synchronizer.process(start, size, slot->offset - static_cast<int64_t>(carry.size()), atEnd);
+        const int64_t slotSize = static_cast<int64_t>(slot->size);
+        if (used >= 0) carry.assign(start + used, start + size);
+        ring.endRead();
+        if (used < 0) {
+            ring.cancel();
+            break;
+        }
+        bytesDone += slotSize;
+        if (!report(bytesDone, totalSize)) {
+            m_cancelled = true;
+            ring.cancel();
+            break;
+        }
+    }
+    reader.join();
+
+    m_syncGaps = synchronizer.gaps();
+    m_skippedBytes = synchronizer.skippedBytes();
+    for (const SyncGap &gap : m_syncGaps) m_index.addGap(gap.offset, gap.length);
+    if (!writeError.empty()) return fail(writeError);
+    if (!readError.empty()) return fail(readError);
+    if (m_cancelled) return false;
+    if (outFd.isValid()
+        && !finishBulk(outFd, bulkIndex, bulkStart, framesInBulk * outFrameBytes, hashing ? &bulkCrc : nullptr,
+                       &writeError)) {
+        return fail(writeError);
+    }
+    if (m_options.checksums) {
+        m_inputCrc = inputCrc;
+        m_hasInputCrc = true;
+    }
+    return true;
+}
+
+namespace {
+// A followed file ends once no writer has been seen this long after its last
+// growth, so a writer that reopens the file for every chunk is not cut off.
+const int64_t kFollowSettleNs = 2000000000;
+// Writers are looked up at least this often while waiting, and on every close.
+const int64_t kFollowRecheckNs = 1000000000;
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+// Reads the input front to back and publishes each bulk as soon as it is full,
+// so bulks of a running capture become available within seconds. At the end of
+// a followed file it waits for inotify instead of polling. A close only makes
+// it look for writers again: it stops once a lookup made kFollowSettleNs after
+// the last growth found none and a read made after that lookup found nothing
+// new, or when the file has been idle for followIdleSeconds.
+bool SplitEngine::runStream(int inFd) {
+    const int64_t frameSize = m_options.frameSizeBytes;
+    const int64_t bulkBytes = std::max<int64_t>(1, m_options.bulkSizeBytes / frameSize) * frameSize;
+    const bool hashing = wantsChecksums();
+    GrowthWatcher watcher;
+    const bool follow = m_options.follow && m_options.inputPath != "-";
+    if (follow && !watcher.watch(m_options.inputPath)) {
+        return fail("Cannot watch input file: " + m_options.inputPath + " (" + std::strerror(errno) + ")");
+    }
+    posix_fadvise(inFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<char> buffer(static_cast<size_t>(std::max<int64_t>(m_options.bufferBytes, 4096)));
+    std::vector<BulkRange> bulks;
+    UniqueFd outFd;
+    int64_t bulkWritten = 0;
+    uint32_t bulkCrc = 0;
+    int64_t bytesDone = 0;
+    std::string error;
+    const int64_t idleLimitNs = int64_t(m_options.followIdleSeconds) * 1000000000;
+    int64_t grewNs = steadyNowNs();
+    int64_t checkedNs = 0;
+    bool writersGone = false;
+    bool recheck = true;
+
+    auto publish = [&]() {
+        BulkRange &bulk = bulks.back();
+        bulk.length = bulkWritten;
+        return finishBulk(outFd, bulk.index, bulk.offset, bulk.length, hashing ? &bulkCrc : nullptr, &error);
+    };
+
+    for (;;) {
+        ssize_t got;
+        {
+            StageTimer timer(m_stats, SplitStage::Read);
+            got = ::read(inFd, buffer.data(), buffer.size());
+            timer.setBytes(std::max<ssize_t>(got, 0));
+        }
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return fail("Failed to read input file: " + m_options.inputPath + " (" + std::strerror(errno) + ")");
+        }
+        if (got == 0) {
+            if (!follow) break;
+            const int64_t now = steadyNowNs();
+            if (writersGone && checkedNs - grewNs >= kFollowSettleNs) break;
+            if (idleLimitNs > 0 && now - grewNs >= idleLimitNs) break;
+            if (recheck || now - checkedNs >= kFollowRecheckNs) {
+                writersGone = writerStateOf(inFd) == WriterState::None;
+                checkedNs = now;
+            }
+            recheck = watcher.wait(50) == GrowthWatcher::WriterClosed;
+            if (!report(bytesDone, -1)) {
+                m_cancelled = true;
+                return false;
+            }
+            continue;
+        }
+
+        const char *data = buffer.data();
+        for (int64_t size = got; size > 0;) {
+            if (!outFd.isValid()) {
+                const int index = static_cast<int>(bulks.size()) + 1;
+                outFd.reset(openBulk(index));
+                if (!outFd.isValid()) return fail("Cannot create output file: " + bulkFilePath(index));
+                bulks.push_back({index, bytesDone + (data - buffer.data()), 0});
+                bulkWritten = 0;
+                bulkCrc = 0;
+            }
+            const int64_t piece = std::min(size, bulkBytes - bulkWritten);
+            if (hashing) {
+                StageTimer timer(m_stats, SplitStage::Hash, piece);
+                bulkCrc = crc32c(bulkCrc, data, static_cast<size_t>(piece));
+            }
+            bool written;
+            {
+                StageTimer timer(m_stats, SplitStage::Write, piece);
+                written = writeFully(outFd.get(), data, piece);
+            }
+            if (!written) {
+                return fail("Failed to write output file: " + bulkFilePath(bulks.back().index) + " ("
+                            + std::strerror(errno) + ")");
+            }
+            data += piece;
+            size -= piece;
+            bulkWritten += piece;
+            if (bulkWritten == bulkBytes && !publish()) return fail(error);
+        }
+        bytesDone += got;
+        grewNs = steadyNowNs();
+        writersGone = false;
+        if (!report(bytesDone, -1)) {
+            m_cancelled = true;
+            return false;
+        }
+    }
+    if (outFd.isValid() && !publish()) return fail(error);
+    m_inputBytes = bytesDone;
+
+    if (m_options.checksums) {
+        for (const FinishedBulk &bulk : m_finished) m_inputCrc = crc32cCombine(m_inputCrc, bulk.crc32c, bulk.length);
+        m_hasInputCrc = true;
+    }
+    if (!m_options.writeIndex) return true;
+
+    // The index describes the file as it is now that the writer is done.
+    struct stat st;
+    if (fstat(inFd, &st) != 0) return fail("Input file not found: " + m_options.inputPath);
+    m_index.reset(st.st_size, modificationTimeNs(st), m_options.frameSizeBytes, m_options.syncWord, 0);
+    for (const BulkRange &bulk : bulks) {
+        m_index.addFrames(bulk.offset, (bulk.length + frameSize - 1) / frameSize, bulk.index, 0);
+    }
+    return m_index.write(frameIndexPath(m_options.inputPath), &error) || fail(error);
+}
+
+void SplitEngine::addSkipped(int64_t offset, int64_t length) {
+    m_skippedBytes += length;
+    if (!m_syncGaps.empty() && m_syncGaps.back().offset + m_syncGaps.back().length == offset) {
+        m_syncGaps.back().length += length;
+    } else {
+        m_syncGaps.push_back({offset, length});
+    }
+    m_index.addGap(offset, length);
+}
+
+// Re-split from the index of an earlier resync: the valid frames are already
+// known, so they are moved with copyFileRange() and the input is not scanned.
+bool SplitEngine::runIndexed(int inFd, const FrameIndex &index, int64_t totalSize) {
+    const int64_t frameSize = m_options.frameSizeBytes;
+    const int64_t framesPerBulk = std::max<int64_t>(1, m_options.bulkSizeBytes / frameSize);
+    const uint32_t validFlags = FrameIndexRun::SyncChecked | FrameIndexRun::SyncValid;
+    int bulkIndex = 0;
+    int64_t framesInBulk = 0;
+    int64_t outOffset = 0;
+    int64_t bytesDone = 0;
+    int64_t bulkStart = 0;
+    UniqueFd outFd;
+    std::string error;
+
+    for (size_t i = 0; i < index.runCount(); ++i) {
+        const FrameIndexRun &run = index.run(i);
+        if (run.count == 0 || (run.flags & validFlags) != validFlags) {
+            const int64_t length = run.count == 0 ? run.stride : int64_t(run.count) * run.stride;
+            addSkipped(run.offset, length);
+            bytesDone += length;
+            continue;
+        }
+
+        int64_t offset = run.offset;
+        int64_t remaining = run.count;
+        while (remaining > 0) {
+            if (!outFd.isValid()) {
+                const std::string outPath = bulkFilePath(++bulkIndex);
+                outFd.reset(openBulk(bulkIndex));
+                if (!outFd.isValid()) return fail("Cannot create output file: " + outPath);
+                outOffset = 0;
+                bulkStart = offset;
+            }
+            const int64_t frames = std::min(remaining, framesPerBulk - framesInBulk);
+            const int64_t length = frames * frameSize;
+            const CopyProgress progress = [&](int64_t copied) {
+                return report(bytesDone + copied, totalSize);
+            };
+            bool copied;
+            {
+                StageTimer timer(m_stats, SplitStage::Copy, length);
+                copied = copyFileRange(inFd, offset, outFd.get(), outOffset, length, nullptr, progress);
+            }
+            if (!copied) {
+                if (errno == ECANCELED) {
+                    m_cancelled = true;
+                    return false;
+                }
+                return fail("Failed to write output file: " + bulkFilePath(bulkIndex) + " ("
+                            + std::strerror(errno) + ")");
+            }
+            m_index.addFrames(offset, frames, bulkIndex, validFlags);
+            offset += length;
+            outOffset += length;
+            bytesDone += length;
+            remaining -= frames;
+            framesInBulk += frames;
+            if (framesInBulk == framesPerBulk) {
+                if (!finishBulk(outFd, bulkIndex, bulkStart, outOffset, nullptr, &error)) return fail(error);
+                framesInBulk = 0;
+            }
+        }
+    }
+    if (outFd.isValid() && !finishBulk(outFd, bulkIndex, bulkStart, outOffset, nullptr, &error)) return fail(error);
+    return true;
+}
+
+namespace {
+// Gaps up to this size between wanted frames are read through: one request per
+// frame would cost more than the bytes it avoids.
+const int64_t kExtractBridgeBytes = 64 * 1024;
+// With header predicates, frames at least this large are chosen from their
+// headers alone and only the matches are read in full.
+const int64_t kExtractProbeFrameBytes = 64 * 1024;
+// A bridged read takes an iovec per frame and per gap, which keeps a batch
+// within IOV_MAX.
+const int64_t kExtractBatchFrames = 512;
+}
+
+// Extraction reads only what the filter can keep. Frames close together are
+// read with one preadv() that scatters them into a dense buffer and the gaps
+// between them into a throwaway sink; farther apart, each frame is its own
+// read and readahead is switched off, so a sparse subset costs about its own
+// size in I/O. The kept frames are gathered into the bulks with writev().
+bool SplitEngine::runExtract(int inFd, int64_t totalSize) {
+    const FrameFilter &filter = m_options.extract;
+    const int64_t frameSize = m_options.frameSizeBytes;
+    const int headerBytes = filter.headerBytes();
+    if (headerBytes > frameSize) {
+        return fail("A header predicate reaches past the end of the " + std::to_string(frameSize) + "-byte frame");
+    }
+
+    const int64_t totalFrames = totalSize / frameSize;
+    const int64_t first = std::min(std::max<int64_t>(filter.firstFrame, 0), totalFrames);
+    const int64_t end = std::max(first, filter.endFrame < 0 ? totalFrames : std::min(filter.endFrame, totalFrames));
+    const int64_t every = std::max<int64_t>(1, filter.everyNth);
+    const int64_t candidates = (end - first + every - 1) / every;
+    const int64_t rangeBytes = (end - first) * frameSize;
+    const int64_t gapBytes = (every - 1) * frameSize;
+    const bool probe = headerBytes > 0 && frameSize >= kExtractProbeFrameBytes;
+    const bool bridge = !probe && gapBytes <= kExtractBridgeBytes;
+    // Readahead would pull in exactly the gaps this path is skipping.
+    posix_fadvise(inFd, 0, 0, bridge ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_RANDOM);
+
+    const int64_t framesPerBulk = std::max<int64_t>(1, m_options.bulkSizeBytes / frameSize);
+    const int64_t batchFrames = std::max<int64_t>(1, std::min(kExtractBatchFrames, m_options.bufferBytes / frameSize));
+    std::vector<char> frames(static_cast<size_t>(batchFrames * frameSize));
+    std::vector<char> headers(probe ? static_cast<size_t>(batchFrames * headerBytes) : 0);
+    std::vector<char> gapSink(bridge ? static_cast<size_t>(gapBytes) : 0);
+    std::vector<iovec> iovecs(static_cast<size_t>(2 * batchFrames));
+    std::vector<uint32_t> selected(static_cast<size_t>(batchFrames));  // Slots of frames to write
+    std::vector<int64_t> slotFrame(static_cast<size_t>(batchFrames));  // Input frame number in each slot
+    const bool hashing = wantsChecksums();
+    const auto frameOffset = [&](int64_t candidate) { return (first + candidate * every) * frameSize; };
+    const auto readFailed = [&](int64_t got) {
+        return fail(got < 0 ? "Failed to read input file: " + m_options.inputPath + " (" + std::strerror(errno) + ")"
+                            : "Input file shrank while extracting: " + m_options.inputPath);
+    };
+
+    UniqueFd outFd;
+    int bulkIndex = 0;
+    int64_t framesInBulk = 0;
+    int64_t bulkOffset = 0;
+    uint32_t bulkCrc = 0;
+    std::string error;
+
+    for (int64_t batch = 0; batch < candidates; batch += batchFrames) {
+        if (!report(frameOffset(batch) - first * frameSize, rangeBytes)) {
+            m_cancelled = true;
+            return false;
+        }
+        const int64_t count = std::min(batchFrames, candidates - batch);
+        size_t keep;
+        if (probe) {
+            {
+                StageTimer timer(m_stats, SplitStage::Read, count * headerBytes);
+                timer.setCalls(count);
+                for (int64_t i = 0; i < count; ++i) {
+                    const int64_t got = preadFully(inFd, headers.data() + i * headerBytes, headerBytes, frameOffset(batch + i));
+                    if (got != headerBytes) return readFailed(got);
+                }
+            }
+            keep = filter.match(headers.data(), static_cast<size_t>(count), headerBytes, selected.data());
+            StageTimer timer(m_stats, SplitStage::Read, static_cast<int64_t>(keep) * frameSize);
+            timer.setCalls(static_cast<int64_t>(keep));
+            for (size_t i = 0; i < keep; ++i) {
+                slotFrame[i] = first + (batch + selected[i]) * every;
+                const int64_t got = preadFully(inFd, frames.data() + i * frameSize, frameSize, slotFrame[i] * frameSize);
+                if (got != frameSize) return readFailed(got);
+                selected[i] = static_cast<uint32_t>(i);
+            }
+        } else {
+            if (bridge) {
+                int n = 0;
+                for (int64_t i = 0; i < count; ++i) {
+                    if (i > 0 && gapBytes > 0) iovecs[n++] = {gapSink.data(), static_cast<size_t>(gapBytes)};
+                    iovecs[n++] = {frames.data() + i * frameSize, static_cast<size_t>(frameSize)};
+                }
+                const int64_t span = count * frameSize + (count - 1) * gapBytes;
+                StageTimer timer(m_stats, SplitStage::Read, span);
+                const int64_t got = preadvFully(inFd, iovecs.data(), n, frameOffset(batch));
+                if (got != span) return readFailed(got);
+            } else {
+                StageTimer timer(m_stats, SplitStage::Read, count * frameSize);
+                timer.setCalls(count);
+                for (int64_t i = 0; i < count; ++i) {
+                    const int64_t got = preadFully(inFd, frames.data() + i * frameSize, frameSize, frameOffset(batch + i));
+                    if (got != frameSize) return readFailed(got);
+                }
+            }
+            for (int64_t i = 0; i < count; ++i) slotFrame[i] = first + (batch + i) * every;
+            if (headerBytes > 0) {
+                keep = filter.match(frames.data(), static_cast<size_t>(count), frameSize, selected.data());
+            } else {
+                for (int64_t i = 0; i < count; ++i) selected[i] = static_cast<uint32_t>(i);
+                keep = static_cast<size_t>(count);
+            }
+        }
+
+        for (size_t s = 0; s < keep;) {
+            if (!outFd.isValid()) {
+                outFd.reset(openBulk(++bulkIndex));
+                if (!outFd.isValid()) return fail("Cannot create output file: " + bulkFilePath(bulkIndex));
+                framesInBulk = 0;
+                bulkOffset = slotFrame[selected[s]] * frameSize;
+                bulkCrc = 0;
+            }
+            const size_t take = static_cast<size_t>(std::min<int64_t>(keep - s, framesPerBulk - framesInBulk));
+            // Frames in neighbouring slots go out as one iovec.
+            int n = 0;
+            for (size_t i = s; i < s + take; ++i) {
+                char *data = frames.data() + selected[i] * frameSize;
+                if (n > 0 && static_cast<char *>(iovecs[n - 1].iov_base) + iovecs[n - 1].iov_len == data) {
+                    iovecs[n - 1].iov_len += static_cast<size_t>(frameSize);
+                } else {
+                    iovecs[n++] = {data, static_cast<size_t>(frameSize)};
+                }
+            }
+            if (hashing) {
+                StageTimer timer(m_stats, SplitStage::Hash, static_cast<int64_t>(take) * frameSize);
+                for (int i = 0; i < n; ++i) bulkCrc = crc32c(bulkCrc, iovecs[i].iov_base, iovecs[i].iov_len);
+            }
+            {
+                StageTimer timer(m_stats, SplitStage::Write, static_cast<int64_t>(take) * frameSize);
+                if (!writevFully(outFd.get(), iovecs.data(), n)) {
+                    return fail("Failed to write output file: " + bulkFilePath(bulkIndex) + " (" + std::strerror(errno) + ")");
+                }
+            }
+            s += take;
+            framesInBulk += static_cast<int64_t>(take);
+            m_extractedFrames += static_cast<int64_t>(take);
+            if (framesInBulk == framesPerBulk
+                && !finishBulk(outFd, bulkIndex, bulkOffset, framesInBulk * frameSize, hashing ? &bulkCrc : nullptr, &error)) {
+                return fail(error);
+            }
+        }
+    }
+    if (outFd.isValid()
+        && !finishBulk(outFd, bulkIndex, bulkOffset, framesInBulk * frameSize, hashing ? &bulkCrc : nullptr, &error)) {
+        return fail(error);
+    }
+    report(rangeBytes, rangeBytes);
+    return true;
+}
+
+namespace {
+// A channel's buffered frames go out in one writev of up to kDemuxStreamBytes,
+// gathered from blocks of kDemuxBlockBytes. Small blocks let a budget spread
+// over many more channels than it holds whole streams.
+const size_t kDemuxBlockBytes = 16 * 1024;
+const size_t kDemuxStreamBytes = 1024 * 1024;
+
+// Channel bulks kept open at once: half the descriptor limit, leaving the rest
+// to the process. Past this the channel written least recently is closed and
+// later reopened for appending.
+size_t demuxOpenFiles() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) return 512;
+    return std::max<size_t>(16, static_cast<size_t>(limit.rlim_cur / 2));
+}
+}
+
+// Streams the input through the buffer ring like runResync(), with a partial
+// frame at the end of a slot carried into the headroom of the next. Runs of
+// consecutive frames on one channel are appended with a single copy into that
+// channel's write-combining buffer; the buffers decide when data is written.
+bool SplitEngine::runDemux(int inFd, int64_t totalSize) {
+    const ChannelField &field = m_options.demux;
+    const int64_t frameSize = m_options.frameSizeBytes;
+    if (field.headerBytes() > frameSize) {
+        return fail("The channel field reaches past the end of the " + std::to_string(frameSize) + "-byte frame");
+    }
+    const int64_t framesPerBulk = std::max<int64_t>(1, m_options.bulkSizeBytes / frameSize);
+    const bool hashing = wantsChecksums();
+
+    struct Channel {
+        int64_t id = 0;
+        UniqueFd fd;
+        bool created = false;  // The .part file of the current bulk exists
+        int bulkIndex = 0;
+        int64_t bulkOffset = 0;
+        int64_t framesInBulk = 0;  // Including frames still buffered
+        int64_t bulkBytes = 0;
+        uint32_t crc = 0;
+        int64_t openedNs = 0;
+        uint64_t lastWrite = 0;
+    };
+    std::vector<Channel> channels;
+    std::unordered_map<int64_t, int> streamOf;
+    const size_t maxOpenFiles = demuxOpenFiles();
+    size_t openFiles = 0;
+    uint64_t writes = 0;
+    std::string writeError;
+
+    const WriteCombiner::Flush flush = [&](int stream, iovec *iov, int count, int64_t bytes) {
+        Channel &channel = channels[stream];
+        if (!channel.fd.isValid()) {
+            if (openFiles >= maxOpenFiles) {
+                Channel *oldest = nullptr;
+                for (Channel &other : channels) {
+                    if (other.fd.isValid() && (!oldest || other.lastWrite < oldest->lastWrite)) oldest = &other;
+                }
+                oldest->fd.reset();
+                --openFiles;
+            }
+            const std::string partPath = bulkFilePath(channel.bulkIndex, channel.id) + ".part";
+            StageTimer timer(m_stats, SplitStage::Open);
+            channel.fd.reset(::open(partPath.c_str(),
+                                    channel.created ? O_WRONLY | O_APPEND | O_CLOEXEC
+                                                    : O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                    0666));
+            if (!channel.fd.isValid()) {
+                writeError = "Cannot create output file: " + partPath + " (" + std::strerror(errno) + ")";
+                return false;
+            }
+            channel.created = true;
+            ++openFiles;
+        }
+        if (hashing) {
+            StageTimer timer(m_stats, SplitStage::Hash, bytes);
+            for (int i = 0; i < count; ++i) channel.crc = crc32c(channel.crc, iov[i].iov_base, iov[i].iov_len);
+        }
+        StageTimer timer(m_stats, SplitStage::Write, bytes);
+        if (!writevFully(channel.fd.get(), iov, count)) {
+            writeError = "Failed to write output file: " + bulkFilePath(channel.bulkIndex, channel.id) + " ("
+                         + std::strerror(errno) + ")";
+            return false;
+        }
+        channel.lastWrite = ++writes;
+        return true;
+    };
+    WriteCombiner combiner(static_cast<size_t>(std::max<int64_t>(m_options.demuxMemoryBytes, 0)), kDemuxBlockBytes,
+                           kDemuxStreamBytes, flush);
+
+    const auto finishChannelBulk = [&](int stream) {
+        if (!combiner.flush(stream)) return false;
+        Channel &channel = channels[stream];
+        const std::string outPath = bulkFilePath(channel.bulkIndex, channel.id);
+        bool ok;
+        {
+            StageTimer timer(m_stats, SplitStage::Close);
+            if (channel.fd.isValid()) {
+                channel.fd.reset();
+                --openFiles;
+            }
+            ok = std::rename((outPath + ".part").c_str(), outPath.c_str()) == 0;
+        }
+        if (!ok) {
+            writeError = "Failed to rename output file: " + outPath + " (" + std::strerror(errno) + ")";
+            return false;
+        }
+        m_stats.addBulkLatency(SplitStats::nowNs() - channel.openedNs);
+        if (m_options.checksums) {
+            m_finished.push_back({channel.bulkIndex, channel.bulkOffset, channel.bulkBytes, channel.crc, channel.id});
+        }
+        ++m_demuxBulks;
+        channel.created = false;
+        channel.framesInBulk = 0;
+        channel.bulkBytes = 0;
+        channel.crc = 0;
+        return true;
+    };
+
+    // bytes may end in a partial frame, which is then the last one of the input.
+    const auto appendRun = [&](int stream, const char *data, int64_t frames, int64_t bytes, int64_t inputOffset) {
+        Channel &channel = channels[stream];
+        if (channel.framesInBulk == 0) {
+            ++channel.bulkIndex;
+            channel.bulkOffset = inputOffset;
+            channel.openedNs = SplitStats::nowNs();
+        }
+        if (!combiner.append(stream, data, static_cast<size_t>(bytes))) return false;
+        channel.framesInBulk += frames;
+        channel.bulkBytes += bytes;
+        return channel.framesInBulk < framesPerBulk || finishChannelBulk(stream);
+    };
+
+    int64_t lastId = -1;
+    int lastStream = -1;
+    const auto streamFor = [&](const char *frame) {
+        const int64_t id = field.channelOf(frame);
+        if (id == lastId) return lastStream;
+        auto found = streamOf.find(id);
+        if (found == streamOf.end()) {
+            found = streamOf.emplace(id, static_cast<int>(channels.size())).first;
+            channels.emplace_back();
+            channels.back().id = id;
+        }
+        lastId = id;
+        lastStream = found->second;
+        return lastStream;
+    };
+
+    // Consumes the whole frames of data and returns how many bytes that was, or -1.
+    const auto routeFrames = [&](const char *data, int64_t size, int64_t inputOffset) -> int64_t {
+        const int64_t frames = size / frameSize;
+        for (int64_t i = 0; i < frames;) {
+            const int stream = streamFor(data + i * frameSize);
+            const int64_t room = framesPerBulk - channels[stream].framesInBulk;
+            int64_t run = 1;
+            while (run < room && i + run < frames && streamFor(data + (i + run) * frameSize) == stream) ++run;
+            if (!appendRun(stream, data + i * frameSize, run, run * frameSize, inputOffset + i * frameSize)) return -1;
+            i += run;
+        }
+        return frames * frameSize;
+    };
+
+    BufferRing ring(m_options.ringDepth, static_cast<size_t>(std::max<int64_t>({m_options.bufferBytes, 4096, frameSize})),
+                    static_cast<size_t>(frameSize), m_options.bufferPool);
+    std::string readError;
+    std::thread reader(&SplitEngine::readInto, this, std::ref(ring), inFd, int64_t(0), totalSize, int64_t(1),
+                       &readError);
+
+    std::vector<char> carry;
+    carry.reserve(static_cast<size_t>(frameSize));
+    int64_t bytesDone = 0;
+    uint32_t inputCrc = 0;
+
+    while (BufferRing::Slot *slot = ring.beginRead()) {
+        // The channel bulks interleave the input, so hash it on the way through.
+        if (m_options.checksums) {
+            StageTimer timer(m_stats, SplitStage::Hash, static_cast<int64_t>(slot->size));
+            inputCrc = crc32c(inputCrc, slot->data, slot->size);
+        }
+        char *start = slot->data - carry.size();
+        std::memcpy(start, carry.data(), carry.size());
+        const int64_t size = static_cast<int64_t>(carry.size() + slot->size);
+        const int64_t used = routeFrames(start, size, slot->offset - static_cast<int64_t>(carry.size()));
+        const int64_t slotSize = static_cast<int64_t>(slot->size);
+        if (used >= 0) carry.assign(start + used, start + size);
+        ring.endRead();
+        if (used < 0) {
+            ring.cancel();
+            break;
+        }
+        bytesDone += slotSize;
+        if (!report(bytesDone, totalSize)) {
+            m_cancelled = true;
+            ring.cancel();
+            break;
+        }
+    }
+    reader.join();
+
+    if (!writeError.empty()) return fail(writeError);
+    if (!readError.empty()) return fail(readError);
+    if (m_cancelled) return false;
+
+    // A trailing partial frame goes to its channel, as a plain split keeps it in
+    // the last bulk, unless it ends before the channel field.
+    if (!carry.empty()) {
+        const int64_t tailOffset = totalSize - static_cast<int64_t>(carry.size());
+        if (static_cast<int64_t>(carry.size()) >= field.headerBytes()) {
+            if (!appendRun(streamFor(carry.data()), carry.data(), 1, static_cast<int64_t>(carry.size()), tailOffset)) {
+                return fail(writeError);
+            }
+        } else {
+            addSkipped(tailOffset, static_cast<int64_t>(carry.size()));
+        }
+    }
+    for (size_t i = 0; i < channels.size(); ++i) {
+        if (channels[i].framesInBulk > 0 && !finishChannelBulk(static_cast<int>(i))) return fail(writeError);
+    }
+    m_demuxChannels = static_cast<int>(channels.size());
+    if (m_options.checksums) {
+        m_inputCrc = inputCrc;
+        m_hasInputCrc = true;
+    }
+    return true;
+}
+
+namespace {
+// Input read per scan step. Large enough that a bulk spans few steps, small
+// enough that a finished bulk is still in the page cache when it is copied.
+const int64_t kChunkScanBytes = 8 * 1024 * 1024;
+}
+
+// Content-defined split. The input is read once, front to back, in steps of
+// whole frames; each step is searched for cuts and hashed with CRC32C and
+// XXH64. A finished bulk is then copied from the input with copyFileRange(),
+// whose pages are still cached, unless a file of its name and size already
+// exists: then it is only recorded. Identical stretches within one input thus
+// also share a file.
+bool SplitEngine::runChunked(int inFd, int64_t totalSize) {
+    const int64_t frameSize = m_options.frameSizeBytes;
+    const FrameChunker chunker(m_options.chunking, frameSize);
+    const int64_t stepFrames = std::max<int64_t>(1, std::max(kChunkScanBytes, m_options.bufferBytes) / frameSize);
+    std::vector<char> step(static_cast<size_t>(stepFrames * frameSize));
+    posix_fadvise(inFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    int bulkIndex = 0;
+    int64_t bulkOffset = 0;
+    int64_t bulkBytes = 0;
+    uint32_t bulkCrc = 0;
+    Xxh64 bulkHash;
+    std::string error;
+
+    const auto finishChunk = [&]() {
+        ++bulkIndex;
+        m_chunkHashes.push_back(bulkHash.digest());
+        const std::string outPath = bulkFilePath(bulkIndex);
+        m_index.addFrames(bulkOffset, (bulkBytes + frameSize - 1) / frameSize, bulkIndex, 0);
+        struct stat st;
+        if (::stat(outPath.c_str(), &st) == 0) {
+            if (st.st_size != bulkBytes) {
+                error = "A bulk of another size already has the name " + outPath;
+                return false;
+            }
+            ++m_reusedBulks;
+            m_reusedBytes += bulkBytes;
+            m_finished.push_back({bulkIndex, bulkOffset, bulkBytes, bulkCrc});
+            return true;
+        }
+        // Concurrent splits into one directory may write the same bulk at
+        // once, so each writes its own temporary file. Renaming one complete
+        // copy over another is harmless.
+        const int64_t openedNs = SplitStats::nowNs();
+        static std::atomic<uint64_t> partSerial(0);
+        const std::string partPath = outPath + "." + std::to_string(::getpid()) + "-"
+                                     + std::to_string(partSerial.fetch_add(1)) + ".part";
+        UniqueFd outFd;
+        {
+            StageTimer timer(m_stats, SplitStage::Open);
+            outFd.reset(::open(partPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666));
+        }
+        if (!outFd.isValid()) {
+            error = "Cannot create output file: " + outPath;
+            return false;
+        }
+        bool ok;
+        {
+            StageTimer timer(m_stats, SplitStage::Copy, bulkBytes);
+            ok = copyFileRange(inFd, bulkOffset, outFd.get(), 0, bulkBytes, nullptr, nullptr);
+        }
+        {
+            StageTimer timer(m_stats, SplitStage::Close);
+            outFd.reset();
+            ok = ok && std::rename(partPath.c_str(), outPath.c_str()) == 0;
+        }
+        if (!ok) {
+            error = "Failed to write output file: " + outPath + " (" + std::strerror(errno) + ")";
+            ::unlink(partPath.c_str());
+            return false;
+        }
+        m_stats.addBulkLatency(SplitStats::nowNs() - openedNs);
+        m_finished.push_back({bulkIndex, bulkOffset, bulkBytes, bulkCrc});
+        return true;
+    };
+    const auto addToBulk = [&](const char *data, int64_t bytes) {
+        StageTimer timer(m_stats, SplitStage::Hash, bytes);
+        bulkCrc = crc32c(bulkCrc, data, static_cast<size_t>(bytes));
+        bulkHash.update(data, static_cast<size_t>(bytes));
+        bulkBytes += bytes;
+    };
+
+    for (int64_t offset = 0; offset < totalSize;) {
+        if (!report(offset, totalSize)) {
+            m_cancelled = true;
+            return false;
+        }
+        const int64_t want = std::min<int64_t>(static_cast<int64_t>(step.size()), totalSize - offset);
+        {
+            StageTimer timer(m_stats, SplitStage::Read, want);
+            const int64_t got = preadFully(inFd, step.data(), want, offset);
+            if (got != want) {
+                return fail(got < 0 ? "Failed to read input file: " + m_options.inputPath + " (" + std::strerror(errno) + ")"
+                                    : "Input file shrank while splitting: " + m_options.inputPath);
+            }
+        }
+        const size_t frames = static_cast<size_t>(want / frameSize);
+        size_t done = 0;
+        while (done < frames) {
+            const size_t cut = chunker.findCut(step.data() + done * frameSize, frames - done, bulkBytes);
+            const size_t take = cut > 0 ? cut : frames - done;
+            addToBulk(step.data() + done * frameSize, static_cast<int64_t>(take) * frameSize);
+            done += take;
+            if (cut == 0) break;
+            if (!finishChunk()) return fail(error);
+            bulkOffset = offset + static_cast<int64_t>(done) * frameSize;
+            bulkBytes = 0;
+            bulkCrc = 0;
+            bulkHash = Xxh64();
+        }
+        // Only the end of the input can hold a partial frame; it joins the last bulk.
+        if (want % frameSize != 0) addToBulk(step.data() + frames * frameSize, want % frameSize);
+        offset += want;
+    }
+    if (bulkBytes > 0 && !finishChunk()) return fail(error);
+
+    for (const FinishedBulk &bulk : m_finished) m_inputCrc = crc32cCombine(m_inputCrc, bulk.crc32c, bulk.length);
+    m_hasInputCrc = true;
+    report(totalSize, totalSize);
+    return true;
+}
+
+namespace {
+// Slots per compression thread: one being compressed, one read ahead, and
+// the writer's share spread over all of them.
+const size_t kCodecSlotsPerThread = 2;
+}
+
+// Compressed split. Every bulk of the plan is cut into blocks of whole frames
+// that never span two bulks. The calling thread reads blocks into a ring of
+// slots and hands them to a pool of threads that compress them and hash the
+// raw data; it writes the finished blocks back in order, so the output is the
+// same whatever the thread count. Each slot is reused only once its block is
+// written, which bounds memory at a few blocks per thread. The input is read
+// exactly once and the bulks written exactly once; their own checksums are
+// taken from the bytes on their way out.
+bool SplitEngine::runCompressed(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize) {
+    const std::unique_ptr<BulkCodec> codec = createBulkCodec(m_options.codec);
+    const int64_t frameSize = m_options.frameSizeBytes;
+    const int64_t blockBytes = std::min<int64_t>(std::max<int64_t>(1, m_options.codecBlockBytes / frameSize),
+                                                 std::max<int64_t>(1, (int64_t(1) << 30) / frameSize))
+                               * frameSize;
+    size_t threadCount = m_options.codecThreads > 0 ? static_cast<size_t>(m_options.codecThreads)
+                                                    : std::max(1u, std::thread::hardware_concurrency());
+
+    struct Block {
+        size_t bulk;  // Position in plan
+        int64_t offset;
+        int64_t length;
+        bool last;  // Of its bulk
+    };
+    std::vector<Block> blocks;
+    for (size_t i = 0; i < plan.size(); ++i) {
+        for (int64_t at = 0; at < plan[i].length; at += blockBytes) {
+            const int64_t length = std::min(blockBytes, plan[i].length - at);
+            blocks.push_back({i, plan[i].offset + at, length, at + length == plan[i].length});
+        }
+    }
+    threadCount = std::min(threadCount, blocks.size());
+
+    struct Slot {
+        std::vector<char> raw;
+        std::vector<char> packed;
+        size_t packedSize = 0;  // 0 when stored raw
+        uint32_t crc = 0;
+        bool done = false;
+    };
+    std::vector<Slot> slots(threadCount * kCodecSlotsPerThread + 2);
+    const size_t packedBytes = codec->bound(static_cast<size_t>(blockBytes));
+    for (Slot &slot : slots) {
+        slot.raw.resize(static_cast<size_t>(blockBytes));
+        slot.packed.resize(packedBytes);
+    }
+
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable blockDone;
+    std::vector<size_t> queue;  // Blocks read and waiting for a thread
+    bool stop = false;
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            workReady.wait(lock, [&] { return stop || !queue.empty(); });
+            if (stop) return;
+            const size_t n = queue.front();
+            queue.erase(queue.begin());
+            lock.unlock();
+            Slot &slot = slots[n % slots.size()];
+            const size_t length = static_cast<size_t>(blocks[n].length);
+            {
+                StageTimer timer(m_stats, SplitStage::Hash, blocks[n].length);
+                slot.crc = crc32c(0, slot.raw.data(), length);
+            }
+            {
+                StageTimer timer(m_stats, SplitStage::Compress, blocks[n].length);
+                slot.packedSize = codec->compress(slot.raw.data(), length, slot.packed.data(), slot.packed.size());
+            }
+            lock.lock();
+            slot.done = true;
+            blockDone.notify_one();
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) workers.emplace_back(worker);
+
+    CompressedBulkWriter writer;
+    UniqueFd outFd;
+    uint32_t inputCrc = 0;
+    int64_t rawBytes = 0;
+    int64_t packedTotal = 0;
+    std::string error;
+    posix_fadvise(inFd, plan.front().offset, 0, POSIX_FADV_SEQUENTIAL);
+
+    const auto writeBlock = [&](const Block &block, Slot &slot) {
+        const BulkRange &bulk = plan[block.bulk];
+        const std::string outPath = bulkFilePath(bulk.index);
+        const bool stored = slot.packedSize == 0;
+        bool ok = true;
+        if (!outFd.isValid()) {
+            outFd.reset(openBulk(bulk.index));
+            if (!outFd.isValid()) {
+                error = "Cannot create output file: " + outPath;
+                return false;
+            }
+            ok = writer.begin(outFd.get(), codec->id(), static_cast<uint32_t>(blockBytes),
+                              static_cast<uint32_t>(frameSize), bulk.length);
+        }
+        {
+            const uint32_t size = static_cast<uint32_t>(stored ? block.length : slot.packedSize);
+            StageTimer timer(m_stats, SplitStage::Write, size);
+            ok = ok && writer.addBlock(stored ? slot.raw.data() : slot.packed.data(), size,
+                                       static_cast<uint32_t>(block.length), slot.crc, stored);
+            ok = ok && (!block.last || writer.finish());
+        }
+        if (!ok) {
+            error = "Failed to write output file: " + outPath + " (" + std::strerror(errno) + ")";
+            return false;
+        }
+        inputCrc = crc32cCombine(inputCrc, slot.crc, block.length);
+        rawBytes += block.length;
+        if (!block.last) return true;
+        const uint32_t fileCrc = writer.fileCrc32c();
+        if (!finishBulk(outFd, bulk.index, bulk.offset, writer.fileSize(), &fileCrc, &error)) return false;
+        packedTotal += writer.fileSize();
+        if (m_options.checksums) m_finished.back().rawLength = bulk.length;
+        return true;
+    };
+
+    size_t readNext = 0;
+    for (size_t written = 0; written < blocks.size() && error.empty(); ++written) {
+        // Refill every slot whose block is written before waiting on the next.
+        for (; readNext < blocks.size() && readNext - written < slots.size(); ++readNext) {
+            Slot &slot = slots[readNext % slots.size()];
+            const Block &block = blocks[readNext];
+            StageTimer timer(m_stats, SplitStage::Read, block.length);
+            const int64_t got = preadFully(inFd, slot.raw.data(), block.length, block.offset);
+            if (got != block.length) {
+                error = got < 0 ? "Failed to read input file: " + m_options.inputPath + " (" + std::strerror(errno) + ")"
+                                : "Input file shrank while splitting: " + m_options.inputPath;
+                break;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.done = false;
+            queue.push_back(readNext);
+            workReady.notify_one();
+        }
+        if (!error.empty()) break;
+        Slot &slot = slots[written % slots.size()];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            blockDone.wait(lock, [&] { return slot.done; });
+        }
+        if (!writeBlock(blocks[written], slot)) break;
+        if (!report(blocks[written].offset + blocks[written].length, totalSize)) {
+            m_cancelled = true;
+            break;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+        workReady.notify_all();
+    }
+    for (std::thread &thread : workers) thread.join();
+
+    if (!error.empty()) return fail(error);
+    if (m_cancelled) return false;
+    m_compressedBytes = packedTotal;
+    if (m_options.checksums && plan.front().offset == 0 && rawBytes == totalSize) {
+        m_inputCrc = inputCrc;
+        m_hasInputCrc = true;
+    }
+    return true;
+}
+
+#ifdef __linux__
+namespace {
+// Output bulks that may be open at once; slot 0 of the file table is the input.
+const unsigned kUringFileSlots = 65;
+}
+
+// Every buffer cycles through read -> write -> idle, identified by its index in
+// the CQE user_data. Reads run ahead into the next bulks while earlier ones are
+// still being written, and each io_uring_enter() submits the whole batch.
+bool SplitEngine::runUring(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize, bool *started) {
+    const unsigned depth = static_cast<unsigned>(std::max(2, std::min(m_options.ringDepth, 4096)));
+    const size_t bufferBytes = static_cast<size_t>(std::max<int64_t>(m_options.bufferBytes, 4096));
+
+    const PooledBlock buffers = allocateBlock(m_options.bufferPool, bufferBytes * depth);
+    if (!buffers) return false;
+
+    // Declared after the buffers so the ring is torn down before they are freed.
+    IoUring ring;
+    if (!ring.init(depth)) return false;
+    *started = true;
+
+    std::vector<iovec> iovecs(depth);
+    for (unsigned i = 0; i < depth; ++i) {
+        iovecs[i].iov_base = buffers.get() + i * bufferBytes;
+        iovecs[i].iov_len = bufferBytes;
+    }
+    // Both registrations are optimizations; RLIMIT_MEMLOCK or an old kernel may refuse them.
+    const bool fixedBuffers = ring.registerBuffers(iovecs.data(), depth);
+    std::vector<int> fileTable(kUringFileSlots, -1);
+    fileTable[0] = inFd;
+    const bool fixedFiles = ring.registerFiles(fileTable.data(), kUringFileSlots);
+
+    struct BulkState {
+        UniqueFd fd;
+        int slot = -1;
+        int64_t unwritten = 0;
+        std::vector<uint32_t> chunkCrcs;  // One per buffer-sized chunk, filled as reads complete
+    };
+    struct Transfer {
+        size_t bulk = 0;
+        int64_t offset = 0;  // Relative to the start of the bulk
+        int64_t length = 0;
+        int64_t done = 0;
+        bool writing = false;
+    };
+
+    std::vector<BulkState> bulks(plan.size());
+    std::vector<Transfer> transfers(depth);
+    std::vector<unsigned> idle;
+    std::vector<int> freeSlots;
+    for (unsigned i = depth; i > 0; --i) idle.push_back(i - 1);
+    for (unsigned slot = kUringFileSlots - 1; slot > 0; --slot) freeSlots.push_back(static_cast<int>(slot));
+
+    size_t nextBulk = 0;
+    int64_t nextOffset = 0;
+    unsigned inFlight = 0;
+    int64_t bytesDone = plan.front().offset;
+    bool stopping = false;
+    std::string error;
+    // Reads complete out of order, so each chunk is hashed on its own while it
+    // is still in cache and the chunk checksums are chained once the bulk is done.
+    const bool hashing = wantsChecksums();
+    const Crc32cAppender appendChunk(bufferBytes);
+
+    auto queue = [&](unsigned id) {
+        const Transfer &t = transfers[id];
+        io_uring_sqe *sqe = ring.getSqe();  // Never null: at most one SQE per buffer
+        const BulkState &bulk = bulks[t.bulk];
+        if (t.writing) {
+            sqe->opcode = fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            sqe->fd = fixedFiles ? bulk.slot : bulk.fd.get();
+            sqe->off = static_cast<uint64_t>(t.offset + t.done);
+        } else {
+            sqe->opcode = fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+            sqe->fd = fixedFiles ? 0 : inFd;
+            sqe->off = static_cast<uint64_t>(plan[t.bulk].offset + t.offset + t.done);
+        }
+        sqe->flags = fixedFiles ? IOSQE_FIXED_FILE : 0;
+        sqe->addr = reinterpret_cast<uint64_t>(buffers.get() + id * bufferBytes + t.done);
+        sqe->len = static_cast<uint32_t>(t.length - t.done);
+        sqe->buf_index = static_cast<uint16_t>(fixedBuffers ? id : 0);
+        sqe->user_data = id;
+        ++inFlight;
+    };
+
+    auto startReads = [&]() {
+        while (!idle.empty() && nextBulk < plan.size()) {
+            BulkState &bulk = bulks[nextBulk];
+            if (!bulk.fd.isValid()) {
+                if (freeSlots.empty()) break;  // Wait until an earlier bulk is complete
+                const std::string outPath = bulkFilePath(plan[nextBulk].index);
+                bulk.fd.reset(openBulk(plan[nextBulk].index));
+                if (!bulk.fd.isValid()) {
+                    error = "Cannot create output file: " + outPath;
+                    return false;
+                }
+                bulk.slot = freeSlots.back();
+                freeSlots.pop_back();
+                bulk.unwritten = plan[nextBulk].length;
+                if (hashing) bulk.chunkCrcs.resize((plan[nextBulk].length + bufferBytes - 1) / bufferBytes);
+                if (fixedFiles && !ring.updateFile(static_cast<unsigned>(bulk.slot), bulk.fd.get())) {
+                    error = "Cannot register output file: " + outPath;
+                    return false;
+                }
+            }
+
+            const unsigned id = idle.back();
+            idle.pop_back();
+            Transfer &t = transfers[id];
+            t.bulk = nextBulk;
+            t.offset = nextOffset;
+            t.length = std::min<int64_t>(bufferBytes, plan[nextBulk].length - nextOffset);
+            t.done = 0;
+            t.writing = false;
+            queue(id);
+
+            nextOffset += t.length;
+            if (nextOffset == plan[nextBulk].length) {
+                ++nextBulk;
+                nextOffset = 0;
+            }
+        }
+        return true;
+    };
+
+    auto completeWrite = [&](const Transfer &t) {
+        bytesDone += t.length;
+        BulkState &bulk = bulks[t.bulk];
+        bulk.unwritten -= t.length;
+        if (bulk.unwritten == 0) {
+            if (fixedFiles) ring.updateFile(static_cast<unsigned>(bulk.slot), -1);
+            freeSlots.push_back(bulk.slot);
+            const BulkRange &range = plan[t.bulk];
+            if (!hashing) return finishBulk(bulk.fd, range.index, range.offset, range.length, nullptr, &error);
+            uint32_t crc = 0;
+            for (size_t i = 0; i + 1 < bulk.chunkCrcs.size(); ++i) crc = appendChunk.combine(crc, bulk.chunkCrcs[i]);
+            const int64_t lastLength = range.length - int64_t(bulk.chunkCrcs.size() - 1) * bufferBytes;
+            crc = crc32cCombine(crc, bulk.chunkCrcs.back(), lastLength);
+            return finishBulk(bulk.fd, range.index, range.offset, range.length, &crc, &error);
+        }
+        return true;
+    };
+
+    stopping = !startReads();
+    while (inFlight > 0) {
+        int submitted;
+        {
+            StageTimer timer(m_stats, SplitStage::UringWait);
+            submitted = ring.submitAndWait(1);
+        }
+        if (submitted < 0) {
+            // Not recoverable; destroying the ring cancels whatever is still in flight.
+            error = std::string("io_uring submission failed (") + std::strerror(-submitted) + ")";
+            break;
+        }
+
+        io_uring_cqe cqe;
+        while (ring.popCompletion(&cqe)) {
+            --inFlight;
+            const unsigned id = static_cast<unsigned>(cqe.user_data);
+            Transfer &t = transfers[id];
+            if (cqe.res <= 0 && !stopping) {
+                const char *reason = cqe.res < 0 ? std::strerror(-cqe.res) : "unexpected end of file";
+                error = t.writing ? "Failed to write output file: " + bulkFilePath(plan[t.bulk].index)
+                                  : "Failed to read input file: " + m_options.inputPath;
+                error += std::string(" (") + reason + ")";
+                stopping = true;
+            }
+            if (stopping) {
+                idle.push_back(id);
+                continue;
+            }
+
+            // The kernel did the I/O asynchronously; only bytes and requests are counted.
+            m_stats.add(t.writing ? SplitStage::Write : SplitStage::Read, 0, cqe.res);
+            t.done += cqe.res;
+            if (t.done < t.length) {
+                queue(id);  // Short transfer: issue the remainder
+            } else if (!t.writing) {
+                if (hashing) {
+                    StageTimer timer(m_stats, SplitStage::Hash, t.length);
+                    bulks[t.bulk].chunkCrcs[static_cast<size_t>(t.offset) / bufferBytes] =
+                        crc32c(0, buffers.get() + id * bufferBytes, static_cast<size_t>(t.length));
+                }
+                t.writing = true;
+                t.done = 0;
+                queue(id);
+            } else {
+                idle.push_back(id);
+                if (!completeWrite(t)) stopping = true;
+            }
+        }
+
+        if (!stopping && !report(bytesDone, totalSize)) {
+            m_cancelled = true;
+            stopping = true;
+        }
+        if (!stopping && !startReads()) stopping = true;
+    }
+
+    if (!error.empty()) return fail(error);
+    return !m_cancelled;
+}
+#endif
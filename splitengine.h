@@ -0,0 +1,219 @@
+#ifndef SPLITENGINE_H
+#define SPLITENGINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "bulkcodec.h"
+#include "bulkplan.h"
+#include "contentchunk.h"
+#include "framedemux.h"
+#include "frameextract.h"
+#include "frameindex.h"
+#include "framesync.h"
+#include "frametransform.h"
+#include "posixio.h"
+#include "splitjournal.h"
+#include "splitprogress.h"
+#include "splitstats.h"
+
+class BufferPool;
+class BufferRing;
+
+enum class IoBackend {
+    Posix,  // Kernel copy or pread/write pipeline, chosen by SplitOptions::pipelined
+    Uring   // io_uring with registered buffers and files (Linux 5.6+)
+};
+
+struct SplitOptions {
+    std::string inputPath;
+    std::string outputDir;
+    std::string prefix;
+    int64_t bulkSizeBytes = 0;
+    int frameSizeBytes = 0;
+    int jobs = 1;  // Bulks written concurrently; each worker copies whole bulks
+    bool pipelined = false;  // Stream through a BufferRing instead of copying in the kernel
+    int ringDepth = 4;
+    int64_t bufferBytes = 1024 * 1024;
+    IoBackend ioBackend = IoBackend::Posix;  // Uring uses ringDepth buffers as its queue depth
+    bool resync = false;  // Validate syncWord at every frame start and skip corrupted data
+    std::string syncWord;  // Raw bytes
+    bool writeIndex = false;  // Write a frameIndexPath() sidecar describing every frame
+    bool resume = false;  // Journal finished bulks and skip the ones an earlier run completed
+    // On resume, read every journaled bulk back and compare its checksum
+    // instead of trusting a file whose size and modification time still
+    // match the journal.
+    bool verifyResumed = false;
+    bool checksums = false;  // CRC32C every bulk and the whole input while the data streams through
+    // Read the input front to back as it grows instead of splitting what is
+    // there now. Implied for inputPath "-" (stdin) and FIFOs, which end at
+    // EOF. A followed file ends once no process has had it open for writing
+    // for a couple of seconds and everything written has been read, or after
+    // followIdleSeconds without growth, 0 meaning never; the idle limit is the
+    // only end where writers cannot be seen (see writerStateOf()).
+    bool follow = false;
+    int followIdleSeconds = 600;
+    // Supplies the ring and io_uring buffers when set, so concurrent batch jobs
+    // share warm memory; must outlive run(). Null allocates per run.
+    BufferPool *bufferPool = nullptr;
+    // Read the input and write the bulks with O_DIRECT, past the page cache,
+    // into preallocated files. Applies to planned splits; falls back to
+    // buffered I/O with steady writeback where a filesystem refuses O_DIRECT.
+    bool directIo = false;
+    // Leave holes of the input (SEEK_HOLE) and frames that are all zeros as
+    // holes in the bulks instead of writing them. Planned splits then read the
+    // data to check it instead of copying in the kernel, bulk by bulk, even
+    // when pipelined, io_uring or direct I/O is requested.
+    bool sparse = false;
+    // When active, only the frames the filter selects are read and written to
+    // the bulks, in input order. Needs a seekable input; excludes resync and resume.
+    FrameFilter extract;
+    // When active, each frame is appended to the bulk series of the channel
+    // its header names, <prefix>_chNN_NNN.bin, through write-combining
+    // buffers that together use at most demuxMemoryBytes.
+    ChannelField demux;
+    int64_t demuxMemoryBytes = 64 * 1024 * 1024;
+    // When active, bulks are cut where the content says rather than every
+    // bulkSizeBytes, and named chunk_<xxh64>.bin after it. A bulk whose file
+    // is already in outputDir is not written again. Implies checksums, since
+    // the finished bulks are the only record of how to reassemble the input.
+    ContentChunking chunking;
+    // Names a BulkCodec when set: each bulk is compressed in independent
+    // blocks of codecBlockBytes (rounded to whole frames) on codecThreads
+    // threads, 0 meaning one per CPU, and written as <prefix>_NNN.cbin with a
+    // block index that CompressedBulkReader seeks through. Planned splits only.
+    std::string codec;
+    int codecThreads = 0;
+    int64_t codecBlockBytes = 1024 * 1024;
+    // When active, only the payload of each frame is written, transformed on
+    // its way through userspace; see FrameTransform. Applies to planned and
+    // resync splits. The bulks then no longer tile the input byte for byte.
+    FrameTransform transform;
+};
+
+// Qt-free split engine for POSIX systems. Each bulk is moved with copyFileRange(),
+// so on Linux the data normally never passes through userspace. With jobs > 1 the
+// bulks are handed to a pool of worker threads that all read the shared input
+// descriptor at explicit offsets. The pipelined mode instead streams the input
+// through a ring of preallocated buffers: a reader thread fills them while the
+// calling thread drains them into the current bulk, so reads and writes overlap.
+// The io_uring backend keeps ringDepth reads and writes in flight across bulk
+// files and falls back to the POSIX path when io_uring is unavailable. With resync
+// set, frames are checked against the sync word on their way through the ring,
+// unless a matching frame index from an earlier resync already lists them.
+// Bulks are written under a ".part" name and renamed once complete; with resume
+// set, each finished bulk is also checksummed into a journal that lets a rerun
+// skip every bulk that is still as it was written.
+class SplitEngine {
+public:
+    explicit SplitEngine(const SplitOptions &options);
+
+    // Receives the position of run() between chunks; a cancel requested on it
+    // stops the split within one chunk, even in the middle of a bulk. Must
+    // outlive run(). totalBytes is -1 while streaming an input of unknown length.
+    void setProgress(SplitProgress *progress) { m_progress = progress; }
+
+    bool run();
+    bool wasCancelled() const { return m_cancelled; }
+    const std::string &errorString() const { return m_error; }
+    IoBackend ioBackendUsed() const { return m_backendUsed; }
+    const std::vector<SyncGap> &syncGaps() const { return m_syncGaps; }
+    int64_t skippedBytes() const { return m_skippedBytes; }
+    bool usedFrameIndex() const { return m_usedIndex; }  // Resync took the frames from the sidecar
+    int resumedBulks() const { return m_resumedBulks; }  // Bulks kept from an earlier run
+    bool streamed() const { return m_streamed; }  // The input was read as a stream
+    int64_t extractedFrames() const { return m_extractedFrames; }  // Frames kept by SplitOptions::extract
+    int demuxChannels() const { return m_demuxChannels; }  // Channels seen by SplitOptions::demux
+    int demuxBulks() const { return m_demuxBulks; }
+    // Content-defined bulks found already written, and their size.
+    int reusedBulks() const { return m_reusedBulks; }
+    int64_t reusedBytes() const { return m_reusedBytes; }
+    uint64_t chunkHash(int index) const { return m_chunkHashes[index - 1]; }  // XXH64 of a content-defined bulk
+    int64_t sparseBytes() const { return m_sparseBytes; }  // Left as holes by SplitOptions::sparse
+    int64_t compressedBytes() const { return m_compressedBytes; }  // Written by SplitOptions::codec
+    // Bytes a whole frame takes in the bulks: the payload of SplitOptions::transform, else the frame size.
+    int64_t outputFrameBytes() const;
+    int64_t inputBytes() const { return m_inputBytes; }  // Size of the input that was split
+    // Per-stage counters of the current or last run; safe to read while it runs.
+    const SplitStats &stats() const { return m_stats; }
+    // With SplitOptions::checksums: every bulk of the output, by index, and the input's CRC32C.
+    const std::vector<FinishedBulk> &finishedBulks() const { return m_finished; }
+    bool hasInputCrc() const { return m_hasInputCrc; }
+    uint32_t inputCrc32c() const { return m_inputCrc; }
+
+    // Bulk index of the channel's own series when channel >= 0. Content-defined
+    // bulks are named after their hash once it is known.
+    std::string bulkFilePath(int index, int64_t channel = -1) const;
+    std::string journalPath() const;
+
+private:
+    bool fail(const std::string &message);
+    bool report(int64_t bytesDone, int64_t totalBytes);  // False once a cancel was requested
+    bool cancelRequested() const;
+    int openBulk(int index);
+    bool wantsChecksums() const;
+    bool finishBulk(UniqueFd &fd, int index, int64_t offset, int64_t length, const uint32_t *crc,
+                    std::string *error);
+    std::vector<BulkRange> pendingBulks(const std::vector<BulkRange> &plan, int64_t totalSize);
+    bool copyBulk(int inFd, const BulkRange &bulk, const CopyProgress &progress, std::string *error);
+    bool copySparseBulk(int inFd, const BulkRange &bulk, UniqueFd &outFd, const CopyProgress &progress,
+                        std::string *error);
+    bool transformBulk(int inFd, const BulkRange &bulk, UniqueFd &outFd, const CopyProgress &progress,
+                       std::string *error);
+    bool runPlanned(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize);
+    bool runBulkByBulk(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize);
+    bool runParallel(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize);
+    // With alignment > 1, reads are sized for O_DIRECT and each range read is
+    // dropped from the page cache; startOffset must then be aligned.
+    void readInto(BufferRing &ring, int inFd, int64_t startOffset, int64_t totalSize, int64_t alignment,
+                  std::string *error);
+    bool runPipelined(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize);
+    bool runDirect(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize);
+    bool runResync(int inFd, int64_t totalSize);
+    bool runIndexed(int inFd, const FrameIndex &index, int64_t totalSize);
+    bool runStream(int inFd);
+    bool runExtract(int inFd, int64_t totalSize);
+    bool runDemux(int inFd, int64_t totalSize);
+    bool runChunked(int inFd, int64_t totalSize);
+    bool runCompressed(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize);
+    void addSkipped(int64_t offset, int64_t length);
+#ifdef __linux__
+    // Leaves started false, with nothing written, when the ring cannot be set up.
+    bool runUring(int inFd, const std::vector<BulkRange> &plan, int64_t totalSize, bool *started);
+#endif
+
+    SplitOptions m_options;
+    SplitProgress *m_progress = nullptr;
+    bool m_cancelled = false;
+    std::string m_error;
+    IoBackend m_backendUsed = IoBackend::Posix;
+    std::vector<SyncGap> m_syncGaps;
+    int64_t m_skippedBytes = 0;
+    FrameIndexWriter m_index;
+    bool m_usedIndex = false;
+    SplitJournal m_journal;
+    int m_resumedBulks = 0;
+    bool m_streamed = false;
+    int64_t m_extractedFrames = 0;
+    int m_demuxChannels = 0;
+    int m_demuxBulks = 0;
+    int m_reusedBulks = 0;
+    int64_t m_reusedBytes = 0;
+    std::vector<uint64_t> m_chunkHashes;  // By bulk index - 1
+    int64_t m_inputBytes = 0;
+    std::atomic<int64_t> m_sparseBytes{0};
+    int64_t m_compressedBytes = 0;
+    std::unique_ptr<FrameTransformer> m_transformer;  // Built by run() from SplitOptions::transform
+    std::vector<uint32_t> m_sourceCrcs;  // By bulk index: CRC32C of the input a transformed bulk holds
+    SplitStats m_stats;
+    std::vector<int64_t> m_bulkOpenedNs;  // By bulk index, for the open-to-publish latency
+    std::vector<FinishedBulk> m_finished;
+    std::mutex m_finishedMutex;
+    bool m_hasInputCrc = false;
+    uint32_t m_inputCrc = 0;
+};
+
+#endif // SPLITENGINE_H
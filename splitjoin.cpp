@@ -0,0 +1,230 @@
+#include "splitjoin.h"
+#include "splitprogress.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Unit of work a thread claims. Large enough that opening the part and the
+// per-piece bookkeeping vanish next to the copy, small enough that a join of
+// two huge bulks still keeps every thread busy.
+const int64_t kJoinPieceBytes = 64 * 1024 * 1024;
+
+// Copied, then hashed back while it is still in the page cache.
+const int64_t kJoinChunkBytes = 8 * 1024 * 1024;
+
+struct JoinPiece {
+    size_t part;
+    int64_t partOffset;
+    int64_t outputOffset;
+    int64_t length;
+};
+
+} // namespace
+
+JoinEngine::JoinEngine(const JoinOptions &options) : m_options(options) {}
+
+bool JoinEngine::fail(const std::string &message) {
+    m_error = message;
+    return false;
+}
+
+// Parts are checked up front so a missing or truncated bulk fails the join
+// before anything is written. Pieces are hashed independently and folded into
+// each part's CRC with crc32cCombine() afterwards, which is what lets several
+// threads work inside one part.
+bool JoinEngine::run() {
+    m_cancelled = false;
+    m_error.clear();
+    m_failures.clear();
+    m_outputBytes = 0;
+    m_copyMethod = CopyMethod::None;
+    m_stats.reset();
+    if (m_options.parts.empty()) return fail("No bulks to join");
+
+    std::vector<int64_t> lengths(m_options.parts.size());
+    for (size_t i = 0; i < m_options.parts.size(); ++i) {
+        const JoinPart &part = m_options.parts[i];
+        struct stat st;
+        if (::stat(part.path.c_str(), &st) != 0) {
+            m_failures.push_back({i, std::string("cannot open (") + std::strerror(errno) + ")"});
+            continue;
+        }
+        if (part.length >= 0 && st.st_size != part.length) {
+            m_failures.push_back({i, "size is " + std::to_string(static_cast<long long>(st.st_size))
+                                         + " bytes, expected " + std::to_string(static_cast<long long>(part.length))});
+            continue;
+        }
+        lengths[i] = st.st_size;
+        m_outputBytes += st.st_size;
+    }
+    if (!m_failures.empty()) return fail("Bulks are missing or have the wrong size");
+
+    std::vector<JoinPiece> pieces;
+    int64_t outputOffset = 0;
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        for (int64_t offset = 0; offset < lengths[i]; offset += kJoinPieceBytes) {
+            pieces.push_back({i, offset, outputOffset + offset, std::min(kJoinPieceBytes, lengths[i] - offset)});
+        }
+        outputOffset += lengths[i];
+    }
+
+    const std::string partPath = m_options.outputPath + ".part";
+    UniqueFd outFd;
+    {
+        StageTimer timer(m_stats, SplitStage::Open);
+        outFd.reset(::open(partPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666));
+    }
+    if (!outFd.isValid()) return fail("Cannot create output file: " + partPath);
+    // Fixing the size first means no writer ever extends the file, so workers
+    // at different offsets do not serialize on the inode size.
+    preallocate(outFd.get(), m_outputBytes);
+    if (::ftruncate(outFd.get(), m_outputBytes) != 0) {
+        const std::string reason = std::strerror(errno);
+        std::remove(partPath.c_str());
+        return fail("Cannot size output file: " + partPath + " (" + reason + ")");
+    }
+
+    std::vector<uint32_t> pieceCrcs(pieces.size(), 0);
+    std::vector<std::string> reasons(m_options.parts.size());
+    std::mutex reasonMutex;
+    std::atomic<size_t> nextPiece(0);
+    std::atomic<int64_t> bytesDone(0);
+    std::atomic<int> slowestMethod(static_cast<int>(CopyMethod::None));
+    std::atomic<bool> failed(false);
+    std::mutex mutex;
+    std::condition_variable finished;
+    const size_t workerCount = std::max<size_t>(1, std::min(pieces.size(), static_cast<size_t>(std::max(m_options.jobs, 1))));
+    size_t running = workerCount;
+
+    const auto stopping = [&]() {
+        return failed.load(std::memory_order_relaxed) || (m_progress && m_progress->cancelRequested());
+    };
+    const auto partFailed = [&](size_t part, const std::string &reason) {
+        std::lock_guard<std::mutex> lock(reasonMutex);
+        if (reasons[part].empty()) reasons[part] = reason;
+        failed = true;
+    };
+
+    auto worker = [&]() {
+        std::vector<char> buffer;
+        for (size_t i = nextPiece++; i < pieces.size() && !stopping(); i = nextPiece++) {
+            const JoinPiece &piece = pieces[i];
+            const JoinPart &part = m_options.parts[piece.part];
+            UniqueFd inFd;
+            {
+                StageTimer timer(m_stats, SplitStage::Open);
+                inFd.reset(::open(part.path.c_str(), O_RDONLY | O_CLOEXEC));
+            }
+            if (!inFd.isValid()) {
+                partFailed(piece.part, std::string("cannot open (") + std::strerror(errno) + ")");
+                break;
+            }
+            posix_fadvise(inFd.get(), piece.partOffset, piece.length, POSIX_FADV_SEQUENTIAL);
+            uint32_t crc = 0;
+            for (int64_t done = 0; done < piece.length && !stopping();) {
+                const int64_t length = std::min(kJoinChunkBytes, piece.length - done);
+                CopyMethod method = CopyMethod::None;
+                bool copied;
+                {
+                    StageTimer timer(m_stats, SplitStage::Copy, length);
+                    copied = copyFileRange(inFd.get(), piece.partOffset + done, outFd.get(),
+                                           piece.outputOffset + done, length, &method);
+                }
+                if (!copied) {
+                    partFailed(piece.part, std::string("copy failed (") + std::strerror(errno) + ")");
+                    break;
+                }
+                int slowest = slowestMethod.load(std::memory_order_relaxed);
+                while (static_cast<int>(method) > slowest
+                       && !slowestMethod.compare_exchange_weak(slowest, static_cast<int>(method))) {
+                }
+                if (part.hasChecksum) {
+                    StageTimer timer(m_stats, SplitStage::Hash, length);
+                    buffer.resize(static_cast<size_t>(kJoinChunkBytes));
+                    if (preadFully(outFd.get(), buffer.data(), length, piece.outputOffset + done) != length) {
+                        partFailed(piece.part, std::string("read back failed (") + std::strerror(errno) + ")");
+                        break;
+                    }
+                    crc = crc32c(crc, buffer.data(), static_cast<size_t>(length));
+                }
+                done += length;
+                bytesDone += length;
+            }
+            pieceCrcs[i] = crc;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        --running;
+        finished.notify_one();
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) workers.emplace_back(worker);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running > 0) {
+            finished.wait_for(lock, std::chrono::milliseconds(100));
+            lock.unlock();
+            if (m_progress) m_progress->publish(bytesDone.load(), m_outputBytes);
+            lock.lock();
+        }
+    }
+    for (std::thread &thread : workers) thread.join();
+    m_copyMethod = static_cast<CopyMethod>(slowestMethod.load());
+
+    if (!failed && m_progress && m_progress->cancelRequested()) {
+        m_cancelled = true;
+        std::remove(partPath.c_str());
+        return false;
+    }
+
+    // Fold the piece CRCs into one per part, and the parts into the output's.
+    uint32_t outputCrc = 0;
+    bool outputHashed = true;
+    for (size_t i = 0, p = 0; i < m_options.parts.size(); ++i) {
+        uint32_t crc = 0;
+        for (; p < pieces.size() && pieces[p].part == i; ++p) crc = crc32cCombine(crc, pieceCrcs[p], pieces[p].length);
+        const JoinPart &part = m_options.parts[i];
+        if (reasons[i].empty() && part.hasChecksum && crc != part.crc32c) reasons[i] = "checksum mismatch";
+        if (!reasons[i].empty()) m_failures.push_back({i, reasons[i]});
+        outputHashed = outputHashed && part.hasChecksum;
+        outputCrc = crc32cCombine(outputCrc, crc, lengths[i]);
+    }
+    if (!m_failures.empty()) {
+        std::remove(partPath.c_str());
+        return fail("Bulks failed to join");
+    }
+    if (m_options.hasOutputChecksum && outputHashed && outputCrc != m_options.outputCrc32c) {
+        std::remove(partPath.c_str());
+        return fail("The joined file does not match the checksum of the split input");
+    }
+
+    bool ok;
+    {
+        StageTimer timer(m_stats, SplitStage::Sync);
+        ok = ::fdatasync(outFd.get()) == 0;
+    }
+    if (ok) {
+        StageTimer timer(m_stats, SplitStage::Close);
+        outFd.reset();
+        ok = std::rename(partPath.c_str(), m_options.outputPath.c_str()) == 0;
+    }
+    if (!ok) {
+        const std::string reason = std::strerror(errno);
+        std::remove(partPath.c_str());
+        return fail("Failed to finish output file: " + m_options.outputPath + " (" + reason + ")");
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef SPLITJOIN_H
+#define SPLITJOIN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "checksum.h"
+#include "posixio.h"
+#include "splitstats.h"
+
+class SplitProgress;
+
+// One bulk of the file being reassembled, in output order.
+struct JoinPart {
+    std::string path;
+    int64_t length = -1;  // Expected size; -1 takes the size of the file
+    bool hasChecksum = false;
+    uint32_t crc32c = 0;
+};
+
+struct JoinOptions {
+    std::vector<JoinPart> parts;
+    std::string outputPath;
+    int jobs = 1;
+    // CRC32C the whole output must have, known when the parts tile a split input.
+    bool hasOutputChecksum = false;
+    uint32_t outputCrc32c = 0;
+};
+
+// Concatenates bulks back into one file. Every part's output offset is known
+// from the sizes before anything is written, so the output is preallocated at
+// its final size and up to jobs threads fill disjoint pieces of it at once with
+// copyFileRange(). Parts with a checksum are hashed from the output as each
+// piece lands, so the check covers what was written and costs a page-cache read
+// rather than a second pass. The output is built under <outputPath>.part and
+// only renamed into place once every check passed.
+class JoinEngine {
+public:
+    explicit JoinEngine(const JoinOptions &options);
+
+    // Receives the bytes joined so far; its cancel request stops the workers
+    // within one piece.
+    void setProgress(SplitProgress *progress) { m_progress = progress; }
+
+    bool run();
+
+    const std::string &errorString() const { return m_error; }
+    bool wasCancelled() const { return m_cancelled; }
+    int64_t outputBytes() const { return m_outputBytes; }
+    // The slowest kernel path any piece needed, for the stats report.
+    CopyMethod copyMethodUsed() const { return m_copyMethod; }
+    // Parts that were missing, had another size or another checksum, in part order.
+    const std::vector<VerifyFailure> &failures() const { return m_failures; }
+    const SplitStats &stats() const { return m_stats; }
+
+private:
+    bool fail(const std::string &message);
+
+    JoinOptions m_options;
+    SplitProgress *m_progress = nullptr;
+    SplitStats m_stats;
+    std::string m_error;
+    bool m_cancelled = false;
+    int64_t m_outputBytes = 0;
+    CopyMethod m_copyMethod = CopyMethod::None;
+    std::vector<VerifyFailure> m_failures;
+};
+
+#endif // SPLITJOIN_H
@@ -0,0 +1,91 @@
+#include "splitjournal.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+const char kJournalMagic[] = "binarysplitter-journal 1";
+
+std::string formatEntry(const FinishedBulk &entry) {
+    char line[128];
+    std::snprintf(line, sizeof(line), "done %d %" PRId64 " %" PRId64 " %08" PRIx32 " %" PRId64 "\n",
+                  entry.index, entry.offset, entry.length, entry.crc32c, entry.mtimeNs);
+    return line;
+}
+
+// Makes a rename in the directory holding path durable.
+void syncParentDirectory(const std::string &path) {
+    const size_t slash = path.rfind('/');
+    const std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    UniqueFd fd(::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd.isValid()) ::fsync(fd.get());
+}
+}
+
+bool SplitJournal::open(const std::string &path, const std::string &identity, bool resume, std::string *error) {
+    m_path = path;
+    m_entries.clear();
+
+    bool keep = false;
+    if (resume) {
+        std::ifstream in(path);
+        std::string magic;
+        std::string storedIdentity;
+        keep = std::getline(in, magic) && std::getline(in, storedIdentity) && magic == kJournalMagic
+               && storedIdentity == identity;
+        std::string line;
+        while (keep && std::getline(in, line)) {
+            // A torn last line from a crash mid-append is simply not a finished bulk.
+            // Lines without a modification time are verified by their checksum.
+            FinishedBulk entry;
+            if (std::sscanf(line.c_str(), "done %d %" SCNd64 " %" SCNd64 " %" SCNx32 " %" SCNd64, &entry.index,
+                            &entry.offset, &entry.length, &entry.crc32c, &entry.mtimeNs) >= 4) {
+                m_entries.push_back(entry);
+            }
+        }
+    }
+
+    // Rewritten rather than appended to, which also drops a torn last line.
+    // The new journal is synced under a temporary name and renamed over the
+    // old one, so a crash at any point leaves one of the two complete; the
+    // descriptor then keeps appending to the renamed file.
+    const std::string tmpPath = path + ".tmp";
+    m_fd.reset(::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666));
+    if (!m_fd.isValid()) {
+        *error = "Cannot create journal: " + tmpPath + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+
+    std::string content = std::string(kJournalMagic) + "\n" + identity + "\n";
+    for (const FinishedBulk &entry : m_entries) content += formatEntry(entry);
+    if (!writeFully(m_fd.get(), content.data(), static_cast<int64_t>(content.size())) || ::fsync(m_fd.get()) != 0
+        || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        *error = "Failed to write journal: " + path + " (" + std::strerror(errno) + ")";
+        m_fd.reset();
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    syncParentDirectory(path);
+    return true;
+}
+
+bool SplitJournal::append(const FinishedBulk &entry, std::string *error) {
+    const std::string line = formatEntry(entry);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!writeFully(m_fd.get(), line.data(), static_cast<int64_t>(line.size())) || ::fdatasync(m_fd.get()) != 0) {
+        *error = "Failed to write journal: " + m_path + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+    m_entries.push_back(entry);
+    return true;
+}
+
+void SplitJournal::remove() {
+    m_fd.reset();
+    ::unlink(m_path.c_str());
+}
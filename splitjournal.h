@@ -0,0 +1,49 @@
+#ifndef SPLITJOURNAL_H
+#define SPLITJOURNAL_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "posixio.h"
+
+// A bulk that was completely written, synced and renamed to its final name.
+struct FinishedBulk {
+    int index;
+    int64_t offset;  // Input offset of the first byte in the bulk
+    int64_t length;
+    uint32_t crc32c;
+    int64_t channel = -1;  // Demultiplexed channel the bulk belongs to; -1 for plain splits
+    int64_t rawLength = -1;  // Size before compression when length is that of a compressed bulk
+    int64_t mtimeNs = -1;  // Modification time of the renamed bulk file, recorded in the journal
+};
+
+// Append-only text log of the bulks a split has finished. The first line
+// identifies the split (input size and mtime, frame and bulk size); every
+// finished bulk adds one "done" line, with its checksum and the file's
+// modification time, that is synced before the split moves on, so after a
+// crash the journal never lists a bulk that is not on disk.
+class SplitJournal {
+public:
+    // Creates the journal at path. With resume set and an identity line equal
+    // to identity, the entries already in the file are kept; otherwise the
+    // journal starts empty.
+    bool open(const std::string &path, const std::string &identity, bool resume, std::string *error);
+    bool isOpen() const { return m_fd.isValid(); }
+
+    const std::vector<FinishedBulk> &entries() const { return m_entries; }
+
+    // Thread-safe; returns once the line is on disk.
+    bool append(const FinishedBulk &entry, std::string *error);
+
+    // Deletes the journal after the split completed.
+    void remove();
+
+private:
+    std::string m_path;
+    UniqueFd m_fd;
+    std::vector<FinishedBulk> m_entries;
+    std::mutex m_mutex;
+};
+
+#endif // SPLITJOURNAL_H
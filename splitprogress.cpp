@@ -0,0 +1,36 @@
+#include "splitprogress.h"
+#include "splitstats.h"
+
+void SplitProgress::reset() {
+    m_bytesDone.store(0, std::memory_order_relaxed);
+    m_totalBytes.store(0, std::memory_order_relaxed);
+    m_firstBytes.store(-1, std::memory_order_relaxed);
+    m_firstNs.store(0, std::memory_order_relaxed);
+    m_lastNs.store(0, std::memory_order_relaxed);
+    m_cancel.store(false, std::memory_order_relaxed);
+}
+
+void SplitProgress::publish(int64_t bytesDone, int64_t totalBytes) {
+    const int64_t now = SplitStats::nowNs();
+    if (m_firstBytes.load(std::memory_order_relaxed) < 0) {
+        m_firstNs.store(now, std::memory_order_relaxed);
+        m_firstBytes.store(bytesDone, std::memory_order_relaxed);
+    }
+    m_totalBytes.store(totalBytes, std::memory_order_relaxed);
+    m_lastNs.store(now, std::memory_order_relaxed);
+    // Release pairs with the acquire in sample(), so a sampler that sees these
+    // bytes also sees the total and timestamps stored before them.
+    m_bytesDone.store(bytesDone, std::memory_order_release);
+}
+
+SplitProgress::Sample SplitProgress::sample() const {
+    Sample sample;
+    sample.bytesDone = m_bytesDone.load(std::memory_order_acquire);
+    sample.totalBytes = m_totalBytes.load(std::memory_order_relaxed);
+    const int64_t firstBytes = m_firstBytes.load(std::memory_order_relaxed);
+    const int64_t elapsedNs = m_lastNs.load(std::memory_order_relaxed) - m_firstNs.load(std::memory_order_relaxed);
+    if (firstBytes >= 0 && elapsedNs > 0) {
+        sample.bytesPerSecond = (sample.bytesDone - firstBytes) * 1e9 / elapsedNs;
+    }
+    return sample;
+}
@@ -0,0 +1,41 @@
+#ifndef SPLITPROGRESS_H
+#define SPLITPROGRESS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Progress counters and cancellation token shared by the thread running a
+// split and the threads watching it. The runner publishes its position with
+// relaxed stores and polls cancelRequested() between chunks; observers sample()
+// on their own timer and may requestCancel() from any thread. Neither side
+// blocks, allocates or needs an event loop.
+class SplitProgress {
+public:
+    struct Sample {
+        int64_t bytesDone = 0;
+        int64_t totalBytes = 0;  // -1 while streaming an input of unknown length
+        double bytesPerSecond = 0.0;
+
+        int percentage() const { return totalBytes > 0 ? static_cast<int>(bytesDone * 100 / totalBytes) : 0; }
+    };
+
+    // Clears the counters and any pending cancel before the next operation.
+    void reset();
+    // The rate is measured from the first call, so a resumed split does not
+    // count the bulks it kept as transferred.
+    void publish(int64_t bytesDone, int64_t totalBytes);
+    Sample sample() const;
+
+    void requestCancel() { m_cancel.store(true, std::memory_order_relaxed); }
+    bool cancelRequested() const { return m_cancel.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_bytesDone{0};
+    std::atomic<int64_t> m_totalBytes{0};
+    std::atomic<int64_t> m_firstBytes{-1};
+    std::atomic<int64_t> m_firstNs{0};
+    std::atomic<int64_t> m_lastNs{0};
+    std::atomic<bool> m_cancel{false};
+};
+
+#endif // SPLITPROGRESS_H
@@ -0,0 +1,47 @@
+#include "splitstats.h"
+
+const char *splitStageName(SplitStage stage) {
+    switch (stage) {
+    case SplitStage::Read: return "read";
+    case SplitStage::Write: return "write";
+    case SplitStage::Copy: return "copy";
+    case SplitStage::Hash: return "hash";
+    case SplitStage::Open: return "open";
+    case SplitStage::Close: return "close";
+    case SplitStage::Sync: return "sync";
+    case SplitStage::UringWait: return "uring_wait";
+    case SplitStage::Compress: return "compress";
+    case SplitStage::Transform: return "transform";
+    default: return "unknown";
+    }
+}
+
+void SplitStats::reset() {
+    for (Counters &counters : m_stages) {
+        counters.nanos.store(0, std::memory_order_relaxed);
+        counters.bytes.store(0, std::memory_order_relaxed);
+        counters.calls.store(0, std::memory_order_relaxed);
+    }
+    for (std::atomic<int64_t> &bucket : m_latency) bucket.store(0, std::memory_order_relaxed);
+    m_bulkCount.store(0, std::memory_order_relaxed);
+    m_bulkLatencySum.store(0, std::memory_order_relaxed);
+    m_bulkLatencyMax.store(0, std::memory_order_relaxed);
+}
+
+void SplitStats::add(SplitStage stage, int64_t nanos, int64_t bytes, int64_t calls) {
+    Counters &counters = m_stages[static_cast<int>(stage)];
+    counters.nanos.fetch_add(nanos, std::memory_order_relaxed);
+    counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    counters.calls.fetch_add(calls, std::memory_order_relaxed);
+}
+
+void SplitStats::addBulkLatency(int64_t nanos) {
+    int bucket = 0;
+    for (int64_t ms = nanos / 1000000; ms > 0 && bucket < kLatencyBuckets - 1; ms >>= 1) ++bucket;
+    m_latency[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_bulkCount.fetch_add(1, std::memory_order_relaxed);
+    m_bulkLatencySum.fetch_add(nanos, std::memory_order_relaxed);
+    int64_t max = m_bulkLatencyMax.load(std::memory_order_relaxed);
+    while (nanos > max && !m_bulkLatencyMax.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+    }
+}
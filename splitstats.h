@@ -0,0 +1,78 @@
+#ifndef SPLITSTATS_H
+#define SPLITSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Engine stages that are timed separately. Copy is an in-kernel move that is
+// both the read and the write; UringWait is time blocked in io_uring_enter.
+// Compress is summed over the codec threads, so it can exceed the wall time.
+// Transform is the work of SplitOptions::transform on the frames.
+enum class SplitStage { Read, Write, Copy, Hash, Open, Close, Sync, UringWait, Compress, Transform, Count };
+
+const char *splitStageName(SplitStage stage);
+
+// Per-stage time, bytes and calls plus a histogram of how long each bulk took
+// from open to publish. Every counter is a relaxed atomic, so worker threads
+// record without locks and the cost per call is a clock read and a few adds;
+// it is always on.
+class SplitStats {
+public:
+    static const int kLatencyBuckets = 32;  // Bucket i counts bulks under 2^i ms
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void reset();
+    void add(SplitStage stage, int64_t nanos, int64_t bytes, int64_t calls = 1);
+    void addBulkLatency(int64_t nanos);
+
+    int64_t nanos(SplitStage stage) const { return counters(stage).nanos.load(std::memory_order_relaxed); }
+    int64_t bytes(SplitStage stage) const { return counters(stage).bytes.load(std::memory_order_relaxed); }
+    int64_t calls(SplitStage stage) const { return counters(stage).calls.load(std::memory_order_relaxed); }
+
+    int64_t bulkCount() const { return m_bulkCount.load(std::memory_order_relaxed); }
+    int64_t bulkLatencySumNs() const { return m_bulkLatencySum.load(std::memory_order_relaxed); }
+    int64_t bulkLatencyMaxNs() const { return m_bulkLatencyMax.load(std::memory_order_relaxed); }
+    int64_t latencyBucket(int i) const { return m_latency[i].load(std::memory_order_relaxed); }
+
+private:
+    struct Counters {
+        std::atomic<int64_t> nanos{0};
+        std::atomic<int64_t> bytes{0};
+        std::atomic<int64_t> calls{0};
+    };
+
+    const Counters &counters(SplitStage stage) const { return m_stages[static_cast<int>(stage)]; }
+
+    Counters m_stages[static_cast<int>(SplitStage::Count)];
+    std::atomic<int64_t> m_latency[kLatencyBuckets] = {};
+    std::atomic<int64_t> m_bulkCount{0};
+    std::atomic<int64_t> m_bulkLatencySum{0};
+    std::atomic<int64_t> m_bulkLatencyMax{0};
+};
+
+// Adds the time from construction to destruction to one stage.
+class StageTimer {
+public:
+    StageTimer(SplitStats &stats, SplitStage stage, int64_t bytes = 0)
+        : m_stats(stats), m_stage(stage), m_bytes(bytes), m_start(SplitStats::nowNs()) {}
+    ~StageTimer() { m_stats.add(m_stage, SplitStats::nowNs() - m_start, m_bytes, m_calls); }
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+
+    void setBytes(int64_t bytes) { m_bytes = bytes; }
+    void setCalls(int64_t calls) { m_calls = calls; }
+
+private:
+    SplitStats &m_stats;
+    SplitStage m_stage;
+    int64_t m_bytes;
+    int64_t m_calls = 1;
+    int64_t m_start;
+};
+
+#endif // SPLITSTATS_H
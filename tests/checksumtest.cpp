@@ -0,0 +1,133 @@
+// CRC32C against the standard check value and a bitwise reference, the
+// combine and zero-run shortcuts, and verifyFiles().
+
+#include <cstring>
+#include <fcntl.h>
+#include "checksum.h"
+#include "posixio.h"
+#include "testsupport.h"
+
+namespace {
+
+uint32_t referenceCrc32c(const std::string &data) {
+    uint32_t crc = 0xffffffffu;
+    for (unsigned char byte : data) {
+        crc ^= byte;
+        for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+uint32_t crcOf(const std::string &data) {
+    return crc32c(0, data.data(), data.size());
+}
+
+} // namespace
+
+TEST_CASE(crc32cCheckValue) {
+    CHECK(crcOf("123456789") == 0xe3069283u);
+    CHECK(crcOf("") == 0);
+    TestRandom random(3);
+    for (int round = 0; round < 200; ++round) {
+        std::string data(random.below(5000), '\0');
+        random.fill(&data[0], data.size());
+        // Unaligned starts and every tail length go through the wide loops.
+        const size_t skip = std::min<size_t>(data.size(), random.below(8));
+        CHECK(crcOf(data.substr(skip)) == referenceCrc32c(data.substr(skip)));
+    }
+}
+
+TEST_CASE(crc32cContinues) {
+    TestRandom random(5);
+    std::string data(100000, '\0');
+    random.fill(&data[0], data.size());
+    uint32_t crc = 0;
+    for (size_t at = 0; at < data.size();) {
+        const size_t step = std::min<size_t>(data.size() - at, 1 + random.below(3000));
+        crc = crc32c(crc, data.data() + at, step);
+        at += step;
+    }
+    CHECK(crc == crcOf(data));
+}
+
+TEST_CASE(crc32cCombines) {
+    TestRandom random(9);
+    for (int round = 0; round < 500; ++round) {
+        std::string data(random.below(20000), '\0');
+        random.fill(&data[0], data.size());
+        const size_t cut = random.below(data.size() + 1);
+        const std::string a = data.substr(0, cut);
+        const std::string b = data.substr(cut);
+        CHECK(crc32cCombine(crcOf(a), crcOf(b), int64_t(b.size())) == crcOf(data));
+        const Crc32cAppender appender(int64_t(b.size()));
+        CHECK(appender.combine(crcOf(a), crcOf(b)) == crcOf(data));
+    }
+    // Combining is associative, so bulks chain into the input's checksum in order.
+    const std::string parts[] = {"first bulk", "", "second", "third bulk of three"};
+    uint32_t chained = 0;
+    std::string whole;
+    for (const std::string &part : parts) {
+        chained = crc32cCombine(chained, crcOf(part), int64_t(part.size()));
+        whole += part;
+    }
+    CHECK(chained == crcOf(whole));
+}
+
+TEST_CASE(crc32cZeroRuns) {
+    for (int64_t length : {int64_t(0), int64_t(1), int64_t(7), int64_t(4096), int64_t(1000003)}) {
+        const std::string zeros(static_cast<size_t>(length), '\0');
+        CHECK(crc32cZeros(0, length) == crcOf(zeros));
+        const uint32_t start = crcOf("prefix");
+        CHECK(crc32cZeros(start, length) == crc32c(start, zeros.data(), zeros.size()));
+    }
+}
+
+TEST_CASE(crc32cFileMatchesMemory) {
+    TempDir dir;
+    REQUIRE(dir.isValid());
+    std::string data(300000, '\0');
+    TestRandom(17).fill(&data[0], data.size());
+    REQUIRE(writeFile(dir.file("data.bin"), data));
+    UniqueFd fd(::open(dir.file("data.bin").c_str(), O_RDONLY | O_CLOEXEC));
+    REQUIRE(fd.isValid());
+    uint32_t crc = 0;
+    REQUIRE(crc32cFile(fd.get(), int64_t(data.size()), &crc));
+    CHECK(crc == crcOf(data));
+    CHECK(!crc32cFile(fd.get(), int64_t(data.size()) + 1, &crc));
+}
+
+// Missing, resized and altered files are reported in file order.
+TEST_CASE(verifyFilesReportsDamage) {
+    TempDir dir;
+    REQUIRE(dir.isValid());
+    std::vector<FileChecksum> files;
+    TestRandom random(19);
+    for (int i = 0; i < 6; ++i) {
+        std::string data(10000 + i * 1000, '\0');
+        random.fill(&data[0], data.size());
+        const std::string path = dir.file("bulk_" + std::to_string(i) + ".bin");
+        REQUIRE(writeFile(path, data));
+        files.push_back({path, int64_t(data.size()), crcOf(data)});
+    }
+    std::vector<VerifyFailure> failures;
+    CHECK(verifyFiles(files, 3, nullptr, &failures));
+    CHECK(failures.empty());
+
+    std::string data;
+    REQUIRE(readFile(files[1].path, &data));
+    data[500] ^= 0x40;
+    REQUIRE(writeFile(files[1].path, data));
+    REQUIRE(writeFile(files[3].path, data.substr(0, 100)));
+    REQUIRE(std::remove(files[4].path.c_str()) == 0);
+
+    CHECK(verifyFiles(files, 3, nullptr, &failures));
+    REQUIRE(failures.size() == 3);
+    CHECK(failures[0].file == 1);
+    CHECK(failures[1].file == 3);
+    CHECK(failures[2].file == 4);
+    for (const VerifyFailure &failure : failures) CHECK(!failure.reason.empty());
+}
+
+int main(int argc, char **argv) {
+    return runTests(argc, argv);
+}
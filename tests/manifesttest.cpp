@@ -0,0 +1,145 @@
+// Splits through BinarySplitterCore with a manifest, checks the manifest
+// against the bulks on disk, and verifies and joins from it.
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "binarysplittercore.h"
+#include "checksum.h"
+#include "testsupport.h"
+
+namespace {
+
+const int kFrameSize = 500;
+const double kBulkSizeGb = 256.0 / (1024 * 1024);  // 256 KiB
+
+// Records what the core reported for the last operation.
+struct Outcome {
+    bool finished = false;
+    bool failed = false;
+    QString message;
+};
+
+void watch(BinarySplitterCore &core, Outcome *outcome) {
+    QObject::connect(&core, &BinarySplitterCore::splitFinished, [outcome](const QString &message) {
+        outcome->finished = true;
+        outcome->message = message;
+    });
+    QObject::connect(&core, &BinarySplitterCore::splitError, [outcome](const QString &error) {
+        outcome->failed = true;
+        outcome->message = error;
+    });
+}
+
+QJsonObject readManifest(const QString &path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? QJsonDocument::fromJson(file.readAll()).object() : QJsonObject();
+}
+
+uint32_t crcOf(const std::string &data) {
+    return crc32c(0, data.data(), data.size());
+}
+
+QString hex(uint32_t crc) {
+    return QString("%1").arg(crc, 8, 16, QChar('0'));
+}
+
+} // namespace
+
+TEST_CASE(manifestDescribesBulks) {
+    TempDir dir;
+    REQUIRE(dir.isValid());
+    const std::string input = makeCapture(4096, kFrameSize);
+    const QString inputPath = QString::fromStdString(dir.file("capture.bin"));
+    REQUIRE(writeFile(dir.file("capture.bin"), input));
+
+    BinarySplitterCore core;
+    Outcome outcome;
+    watch(core, &outcome);
+    core.setWriteManifest(true);
+    core.splitBinaryFile(inputPath, kBulkSizeGb, kFrameSize);
+    REQUIRE(outcome.finished);
+
+    const QJsonObject manifest = readManifest(QString::fromStdString(dir.file("capture_manifest.json")));
+    CHECK(manifest["algorithm"].toString() == "crc32c");
+    CHECK(manifest["input_size"].toDouble() == double(input.size()));
+    CHECK(manifest["input_crc32c"].toString() == hex(crcOf(input)));
+    CHECK(manifest["frame_size_bytes"].toInt() == kFrameSize);
+
+    const QJsonArray bulks = manifest["bulks"].toArray();
+    REQUIRE(bulks.size() == int((input.size() + 256 * 1024 - 1) / (256 * 1024)));
+    qint64 offset = 0;
+    for (const QJsonValue &value : bulks) {
+        const QJsonObject bulk = value.toObject();
+        std::string data;
+        REQUIRE(readFile(dir.file(bulk["name"].toString().toStdString()), &data));
+        CHECK(qint64(bulk["offset"].toDouble()) == offset);
+        CHECK(qint64(bulk["length"].toDouble()) == qint64(data.size()));
+        CHECK(bulk["crc32c"].toString() == hex(crcOf(data)));
+        CHECK(data == input.substr(size_t(offset), data.size()));
+        offset += qint64(data.size());
+    }
+    CHECK(offset == qint64(input.size()));
+}
+
+// A verify of fresh bulks passes; one flipped bit names the damaged bulk.
+TEST_CASE(verifyFindsDamagedBulk) {
+    TempDir dir;
+    REQUIRE(dir.isValid());
+    const std::string input = makeCapture(4096, kFrameSize);
+    const QString inputPath = QString::fromStdString(dir.file("capture.bin"));
+    REQUIRE(writeFile(dir.file("capture.bin"), input));
+
+    BinarySplitterCore core;
+    Outcome outcome;
+    watch(core, &outcome);
+    core.setWriteManifest(true);
+    core.setJobs(3);
+    core.splitBinaryFile(inputPath, kBulkSizeGb, kFrameSize);
+    REQUIRE(outcome.finished);
+
+    outcome = Outcome();
+    core.verifyBulks(inputPath);
+    CHECK(outcome.finished);
+    CHECK(outcome.message.contains("all checksums match"));
+
+    const std::string damaged = dir.file("capture_002.bin");
+    std::string bulk;
+    REQUIRE(readFile(damaged, &bulk));
+    bulk[100] ^= 0x10;
+    REQUIRE(writeFile(damaged, bulk));
+    outcome = Outcome();
+    core.verifyBulks(inputPath);
+    CHECK(outcome.failed);
+    CHECK(outcome.message.contains("capture_002.bin"));
+}
+
+TEST_CASE(joinFromManifest) {
+    TempDir dir;
+    REQUIRE(dir.isValid());
+    const std::string input = makeCapture(4096, kFrameSize);
+    const QString inputPath = QString::fromStdString(dir.file("capture.bin"));
+    REQUIRE(writeFile(dir.file("capture.bin"), input));
+
+    BinarySplitterCore core;
+    Outcome outcome;
+    watch(core, &outcome);
+    core.setWriteManifest(true);
+    core.splitBinaryFile(inputPath, kBulkSizeGb, kFrameSize);
+    REQUIRE(outcome.finished);
+
+    const QString joinedPath = QString::fromStdString(dir.file("joined.bin"));
+    outcome = Outcome();
+    core.joinBulks(inputPath, "output_bulk", joinedPath);
+    CHECK(outcome.finished);
+    std::string joined;
+    CHECK(readFile(joinedPath.toStdString(), &joined));
+    CHECK(joined == input);
+}
+
+int main(int argc, char **argv) {
+    QCoreApplication app(argc, argv);
+    return runTests(argc, argv);
+}
@@ -0,0 +1,248 @@
+// Option parsers, frame transform kernels and bulk codecs, checked against
+// plain reference code on fixed cases and on random inputs.
+
+#include <cstring>
+#include "bulkcodec.h"
+#include "framedemux.h"
+#include "frameextract.h"
+#include "frametransform.h"
+#include "testsupport.h"
+
+namespace {
+
+const int kFuzzRounds = 2000;
+
+// Byte-at-a-time version of what FrameTransformer does to one frame.
+std::string referenceTransform(const char *frame, int64_t strip, int64_t payload, int swap) {
+    std::string out(frame + strip, static_cast<size_t>(payload));
+    if (swap > 1) {
+        for (size_t word = 0; word + swap <= out.size(); word += swap) {
+            for (int i = 0; i < swap / 2; ++i) std::swap(out[word + i], out[word + swap - 1 - i]);
+        }
+    }
+    return out;
+}
+
+// Inputs that exercise a codec's paths: empty, tiny, runs, repeats at
+// various distances, noise, and mixtures of them.
+std::string codecInput(TestRandom &random) {
+    const size_t size = random.below(4) == 0 ? random.below(16) : random.below(256 * 1024);
+    std::string data(size, '\0');
+    size_t at = 0;
+    while (at < size) {
+        const size_t run = std::min<size_t>(size - at, 1 + random.below(4096));
+        switch (random.below(4)) {
+        case 0:
+            std::memset(&data[at], static_cast<int>(random.below(256)), run);
+            break;
+        case 1:
+            random.fill(&data[at], run);
+            break;
+        case 2:
+            if (at > 0) {
+                const size_t distance = 1 + random.below(std::min<size_t>(at, 65536));
+                for (size_t i = 0; i < run; ++i) data[at + i] = data[at + i - distance];
+                break;
+            }
+            // fall through
+        default:
+            for (size_t i = 0; i < run; ++i) data[at + i] = "frame"[i % 5];
+            break;
+        }
+        at += run;
+    }
+    return data;
+}
+
+} // namespace
+
+TEST_CASE(frameTransformParses) {
+    FrameTransform transform;
+    std::string error;
+    REQUIRE(parseFrameTransform("strip=sync,swap=16", &transform, &error));
+    CHECK(transform.stripSyncWord);
+    CHECK(transform.swapBytes == 2);
+    CHECK(transform.payloadBytes == -1);
+
+    REQUIRE(parseFrameTransform("strip=4,payload=100,swap=64", &transform, &error));
+    CHECK(!transform.stripSyncWord);
+    CHECK(transform.stripBytes == 4);
+    CHECK(transform.payloadBytes == 100);
+    CHECK(transform.swapBytes == 8);
+    CHECK(transform.isActive());
+
+    for (const char *bad : {"", "strip", "strip=", "strip=-1", "payload=0", "swap=24", "swap=8", "bogus=1",
+                            "strip=4,", "strip=4,,swap=16"}) {
+        FrameTransform untouched;
+        error.clear();
+        CHECK(!parseFrameTransform(bad, &untouched, &error));
+        CHECK(!error.empty());
+        CHECK(!untouched.isActive());
+    }
+}
+
+TEST_CASE(frameTransformChecksFrameSize) {
+    FrameTransform transform;
+    transform.stripBytes = 8;
+    CHECK(FrameTransformer::check(transform, 100).empty());
+    CHECK(!FrameTransformer::check(transform, 8).empty());
+    transform.payloadBytes = 92;
+    CHECK(FrameTransformer::check(transform, 100).empty());
+    transform.payloadBytes = 93;
+    CHECK(!FrameTransformer::check(transform, 100).empty());
+}
+
+// Every kernel variant against the reference, on frame sizes and offsets
+// that leave partial words and unaligned payloads.
+TEST_CASE(frameTransformFuzz) {
+    TestRandom random(7);
+    for (int round = 0; round < kFuzzRounds; ++round) {
+        const int frameSize = 1 + static_cast<int>(random.below(300));
+        FrameTransform transform;
+        transform.stripBytes = static_cast<int>(random.below(frameSize));
+        if (random.below(2)) transform.payloadBytes = 1 + static_cast<int>(random.below(frameSize - transform.stripBytes));
+        const int swaps[] = {0, 2, 4, 8};
+        transform.swapBytes = swaps[random.below(4)];
+        REQUIRE(FrameTransformer::check(transform, frameSize).empty());
+
+        const FrameTransformer transformer(transform, frameSize);
+        const int64_t payload = transformer.payloadBytes();
+        const size_t count = random.below(40);
+        std::string frames(count * frameSize + 1, '\0');
+        random.fill(&frames[1], count * frameSize);
+        // Start one byte in, so the kernels also see misaligned frames.
+        const char *input = frames.data() + 1;
+        std::string out(count * payload, '\0');
+        transformer.apply(input, count, &out[0]);
+
+        std::string expected;
+        for (size_t n = 0; n < count; ++n) {
+            expected += referenceTransform(input + n * frameSize, transform.stripBytes, payload, transform.swapBytes);
+        }
+        CHECK(out == expected);
+        CHECK(transformer.outputBytes(int64_t(count) * frameSize) == int64_t(expected.size()));
+        if (out != expected) return;
+    }
+}
+
+TEST_CASE(channelFieldParses) {
+    ChannelField field;
+    std::string error;
+    REQUIRE(parseChannelField("3", &field, &error));
+    CHECK(field.offset == 3);
+    CHECK(field.bytes == 1);
+    CHECK(field.mask == 0xff);
+    CHECK(field.headerBytes() == 4);
+
+    REQUIRE(parseChannelField("4/0fc0", &field, &error));
+    CHECK(field.offset == 4);
+    CHECK(field.bytes == 2);
+    CHECK(field.mask == 0x0fc0);
+    // Bits 6-11 of the big-endian field at offset 4.
+    const char frame[] = {0, 0, 0, 0, 0x05, static_cast<char>(0x40 | 0x3f), 0};
+    CHECK(field.channelOf(frame) == ((0x0540 & 0x0fc0) >> 6));
+
+    for (const char *bad : {"", "/ff", "x", "3x", "-1", "4/", "4/0", "4/00", "4/0g", "4/0102030405"}) {
+        ChannelField untouched;
+        error.clear();
+        CHECK(!parseChannelField(bad, &untouched, &error));
+        CHECK(!error.empty());
+        CHECK(!untouched.isActive());
+    }
+}
+
+TEST_CASE(channelFieldFuzz) {
+    TestRandom random(11);
+    for (int round = 0; round < kFuzzRounds; ++round) {
+        const int offset = static_cast<int>(random.below(16));
+        const int bytes = 1 + static_cast<int>(random.below(4));
+        uint32_t mask = static_cast<uint32_t>(random.next()) & (bytes == 4 ? 0xffffffffu : (1u << (8 * bytes)) - 1);
+        if (mask == 0) mask = 1;
+        char spec[32];
+        std::snprintf(spec, sizeof(spec), "%d/%0*x", offset, 2 * bytes, mask);
+        ChannelField field;
+        std::string error;
+        REQUIRE(parseChannelField(spec, &field, &error));
+
+        char frame[32];
+        random.fill(frame, sizeof(frame));
+        uint32_t value = 0;
+        for (int i = 0; i < bytes; ++i) value = value << 8 | static_cast<unsigned char>(frame[offset + i]);
+        int shift = 0;
+        while (!(mask >> shift & 1)) ++shift;
+        CHECK(field.channelOf(frame) == (value & mask) >> shift);
+    }
+}
+
+TEST_CASE(headerPredicateParses) {
+    HeaderPredicate predicate;
+    std::string error;
+    REQUIRE(parseHeaderPredicate("6=1200/ff00", &predicate, &error));
+    CHECK(predicate.offset == 6);
+    CHECK(predicate.length == 2);
+
+    FrameFilter filter;
+    filter.predicates.push_back(predicate);
+    char frames[2][16] = {};
+    frames[0][6] = 0x12;
+    frames[0][7] = 0x34;
+    frames[1][6] = 0x13;
+    uint32_t matches[2];
+    CHECK(filter.match(frames[0], 2, 16, matches) == 1);
+    CHECK(matches[0] == 0);
+
+    for (const char *bad : {"", "6", "6=", "=12", "6=123", "6=12/ffff", "6=0102030405060708090a"}) {
+        CHECK(!parseHeaderPredicate(bad, &predicate, &error));
+    }
+}
+
+TEST_CASE(codecRoundTrip) {
+    CHECK(createBulkCodec("lz") != nullptr);
+    CHECK(createBulkCodec("no-such-codec") == nullptr);
+    for (const std::string &name : bulkCodecNames()) {
+        const std::unique_ptr<BulkCodec> codec = createBulkCodec(name);
+        REQUIRE(codec);
+        CHECK(createBulkCodec(codec->id()) != nullptr);
+        CHECK(name == codec->name());
+
+        const std::string zeros(1 << 20, '\0');
+        std::string packed(codec->bound(zeros.size()), '\0');
+        const size_t size = codec->compress(zeros.data(), zeros.size(), &packed[0], packed.size());
+        REQUIRE(size > 0);
+        CHECK(size < zeros.size() / 100);
+        std::string restored(zeros.size(), '\1');
+        CHECK(codec->decompress(packed.data(), size, &restored[0], restored.size()));
+        CHECK(restored == zeros);
+    }
+}
+
+// Random blocks must come back exactly, or be refused as incompressible;
+// damaged blocks may be rejected but must never be read or written past.
+TEST_CASE(codecFuzz) {
+    for (const std::string &name : bulkCodecNames()) {
+        const std::unique_ptr<BulkCodec> codec = createBulkCodec(name);
+        REQUIRE(codec);
+        TestRandom random(13);
+        for (int round = 0; round < kFuzzRounds / 10; ++round) {
+            const std::string data = codecInput(random);
+            std::string packed(codec->bound(data.size()), '\0');
+            const size_t size = codec->compress(data.data(), data.size(), &packed[0], packed.size());
+            if (size == 0) continue;
+            CHECK(size < data.size());
+            std::string restored(data.size(), '\0');
+            CHECK(codec->decompress(packed.data(), size, &restored[0], restored.size()));
+            CHECK(restored == data);
+
+            std::string damaged = packed.substr(0, size);
+            for (int flips = 1 + static_cast<int>(random.below(4)); flips > 0; --flips) {
+                damaged[random.below(damaged.size())] ^= static_cast<char>(1 + random.below(255));
+            }
+            if (random.below(4) == 0) damaged.resize(random.below(damaged.size()));
+            codec->decompress(damaged.data(), damaged.size(), &restored[0], restored.size());
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    return runTests(argc, argv);
+}
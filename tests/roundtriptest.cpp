@@ -0,0 +1,398 @@
+// Splits synthetic captures with every engine mode, reassembles the bulks and
+// compares the result with the input, byte for byte and by CRC32C.
+
+#include <atomic>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checksum.h"
+#include "compressedbulk.h"
+#include "frameindex.h"
+#include "splitengine.h"
+#include "splitjoin.h"
+#include "splitprogress.h"
+#include "testsupport.h"
+
+namespace {
+
+const int kFrameSize = 500;
+const int64_t kFrameCount = 8192;  // About 4 MiB
+const int64_t kBulkSize = 256 * 1024;
+
+// An input written to a fresh directory and the options to split it there.
+struct Fixture {
+    TempDir dir;
+    std::string input;
+    SplitOptions options;
+
+    explicit Fixture(const std::string &data) {
+        options.inputPath = dir.file("capture.bin");
+        options.outputDir = dir.path();
+        options.prefix = "capture";
+        options.bulkSizeBytes = kBulkSize;
+        options.frameSizeBytes = kFrameSize;
+        options.syncWord.assign(kSyncWord, 2);
+        input = data;
+        writeFile(options.inputPath, input);
+    }
+};
+
+uint32_t crcOf(const std::string &data) {
+    return crc32c(0, data.data(), data.size());
+}
+
+// The numbered bulks of a split, or of one of its channels, concatenated in order.
+std::string concatBulks(const SplitEngine &engine, int64_t channel = -1) {
+    std::string joined;
+    std::string bulk;
+    for (int index = 1; readFile(engine.bulkFilePath(index, channel), &bulk); ++index) joined += bulk;
+    return joined;
+}
+
+// A capture whose sync word is damaged in four frames, two of them adjacent.
+std::string damagedCapture() {
+    std::string data = makeCapture(kFrameCount, kFrameSize);
+    for (int64_t frame : {100, 101, 4000, 8000}) data[static_cast<size_t>(frame * kFrameSize)] = 0;
+    return data;
+}
+
+// Joins the bulks engine wrote with JoinEngine, checking every part's and the
+// whole output's CRC32C when the split recorded them.
+bool joinBulks(const SplitEngine &engine, const std::string &outputPath, int jobs, std::string *joined) {
+    JoinOptions options;
+    options.outputPath = outputPath;
+    options.jobs = jobs;
+    for (const FinishedBulk &bulk : engine.finishedBulks()) {
+        JoinPart part;
+        part.path = engine.bulkFilePath(bulk.index);
+        part.length = bulk.length;
+        part.hasChecksum = true;
+        part.crc32c = bulk.crc32c;
+        options.parts.push_back(part);
+    }
+    options.hasOutputChecksum = engine.hasInputCrc();
+    options.outputCrc32c = engine.inputCrc32c();
+    JoinEngine join(options);
+    return join.run() && readFile(outputPath, joined);
+}
+
+void checkPlainRoundTrip(SplitOptions options) {
+    Fixture fixture(makeCapture(kFrameCount, kFrameSize));
+    options.inputPath = fixture.options.inputPath;
+    options.outputDir = fixture.options.outputDir;
+    options.checksums = true;
+    SplitEngine engine(options);
+    REQUIRE(engine.run());
+    CHECK(engine.finishedBulks().size() == size_t((fixture.input.size() + kBulkSize - 1) / kBulkSize));
+    CHECK(engine.hasInputCrc() && engine.inputCrc32c() == crcOf(fixture.input));
+    CHECK(concatBulks(engine) == fixture.input);
+    std::string joined;
+    CHECK(joinBulks(engine, fixture.dir.file("joined.bin"), 4, &joined));
+    CHECK(crcOf(joined) == crcOf(fixture.input));
+}
+
+SplitOptions defaults() {
+    SplitOptions options;
+    options.prefix = "capture";
+    options.bulkSizeBytes = kBulkSize;
+    options.frameSizeBytes = kFrameSize;
+    options.syncWord.assign(kSyncWord, 2);
+    return options;
+}
+
+} // namespace
+
+TEST_CASE(plannedRoundTrip) {
+    checkPlainRoundTrip(defaults());
+}
+
+TEST_CASE(parallelRoundTrip) {
+    SplitOptions options = defaults();
+    options.jobs = 4;
+    checkPlainRoundTrip(options);
+}
+
+TEST_CASE(pipelinedRoundTrip) {
+    SplitOptions options = defaults();
+    options.pipelined = true;
+    options.bufferBytes = 64 * 1024;
+    checkPlainRoundTrip(options);
+}
+
+// Falls back to the POSIX path where io_uring is unavailable; either way the
+// bulks must come out the same.
+TEST_CASE(uringRoundTrip) {
+    SplitOptions options = defaults();
+    options.ioBackend = IoBackend::Uring;
+    options.bufferBytes = 64 * 1024;
+    checkPlainRoundTrip(options);
+}
+
+// Filesystems without O_DIRECT, such as tmpfs, take the buffered fallback.
+TEST_CASE(directRoundTrip) {
+    SplitOptions options = defaults();
+    options.directIo = true;
+    checkPlainRoundTrip(options);
+}
+
+TEST_CASE(streamedRoundTrip) {
+    Fixture fixture(makeCapture(kFrameCount, kFrameSize));
+    const std::string fifo = fixture.dir.file("capture.fifo");
+    REQUIRE(::mkfifo(fifo.c_str(), 0600) == 0);
+    std::thread writer([&] {
+        UniqueFd fd(::open(fifo.c_str(), O_WRONLY | O_CLOEXEC));
+        if (fd.isValid()) writeFully(fd.get(), fixture.input.data(), static_cast<int64_t>(fixture.input.size()));
+    });
+    fixture.options.inputPath = fifo;
+    fixture.options.checksums = true;
+    SplitEngine engine(fixture.options);
+    const bool ok = engine.run();
+    writer.join();
+    REQUIRE(ok);
+    CHECK(engine.streamed());
+    CHECK(concatBulks(engine) == fixture.input);
+    CHECK(engine.hasInputCrc() && engine.inputCrc32c() == crcOf(fixture.input));
+}
+
+// Damaged sync words are cut out as gaps; what is left is the input without them.
+TEST_CASE(resyncSkipsCorruption) {
+    const std::string data = damagedCapture();
+    Fixture fixture(data);
+    fixture.options.resync = true;
+    SplitEngine engine(fixture.options);
+    REQUIRE(engine.run());
+    CHECK(engine.skippedBytes() > 0);
+    REQUIRE(!engine.syncGaps().empty());
+
+    std::string expected;
+    int64_t at = 0;
+    for (const SyncGap &gap : engine.syncGaps()) {
+        expected.append(data, static_cast<size_t>(at), static_cast<size_t>(gap.offset - at));
+        at = gap.offset + gap.length;
+    }
+    expected.append(data, static_cast<size_t>(at), std::string::npos);
+    const std::string joined = concatBulks(engine);
+    CHECK(joined == expected);
+    CHECK(int64_t(joined.size()) == int64_t(data.size()) - engine.skippedBytes());
+}
+
+// The index a resync writes lets the next resync skip checking the frames and
+// still cut the same bulks.
+TEST_CASE(resyncReusesFrameIndex) {
+    Fixture fixture(damagedCapture());
+    fixture.options.resync = true;
+    fixture.options.writeIndex = true;
+    SplitEngine first(fixture.options);
+    REQUIRE(first.run());
+    CHECK(!first.usedFrameIndex());
+    CHECK(fileExists(frameIndexPath(fixture.options.inputPath)));
+    const std::string firstBulks = concatBulks(first);
+
+    SplitEngine indexed(fixture.options);
+    REQUIRE(indexed.run());
+    CHECK(indexed.usedFrameIndex());
+    CHECK(indexed.skippedBytes() == first.skippedBytes());
+    CHECK(concatBulks(indexed) == firstBulks);
+}
+
+// Holes in the input and all-zero frames stay holes in the bulks.
+TEST_CASE(sparseLeavesHoles) {
+    const int64_t dataBytes = kFrameCount / 2 * kFrameSize;
+    const int64_t holeBytes = 16 * kBulkSize / kFrameSize * kFrameSize;
+    Fixture fixture(makeCapture(kFrameCount / 2, kFrameSize));
+    {
+        UniqueFd fd(::open(fixture.options.inputPath.c_str(), O_WRONLY | O_CLOEXEC));
+        REQUIRE(fd.isValid());
+        REQUIRE(::ftruncate(fd.get(), dataBytes + holeBytes) == 0);
+    }
+    std::string input;
+    REQUIRE(readFile(fixture.options.inputPath, &input));
+    fixture.options.sparse = true;
+    fixture.options.checksums = true;
+    SplitEngine engine(fixture.options);
+    REQUIRE(engine.run());
+    CHECK(engine.sparseBytes() >= holeBytes - kBulkSize);
+    CHECK(concatBulks(engine) == input);
+    CHECK(engine.inputCrc32c() == crcOf(input));
+
+    // A bulk that lies entirely in the hole takes no space, wherever the
+    // filesystem can store holes at all.
+    const std::string lastBulk = engine.bulkFilePath(static_cast<int>(engine.finishedBulks().size()));
+    if (allocatedBytes(fixture.options.inputPath) < fileSize(fixture.options.inputPath)) {
+        CHECK(allocatedBytes(lastBulk) < fileSize(lastBulk));
+    }
+}
+
+TEST_CASE(compressedRoundTrip) {
+    Fixture fixture(makeCapture(kFrameCount, kFrameSize));
+    fixture.options.codec = "lz";
+    fixture.options.codecBlockBytes = 64 * 1024;
+    fixture.options.codecThreads = 2;
+    SplitEngine engine(fixture.options);
+    REQUIRE(engine.run());
+    CHECK(engine.compressedBytes() > 0);
+    CHECK(engine.compressedBytes() < engine.inputBytes());
+
+    std::string restored;
+    for (int index = 1; fileExists(engine.bulkFilePath(index)); ++index) {
+        CompressedBulkReader reader;
+        std::string error;
+        REQUIRE(reader.open(engine.bulkFilePath(index), &error));
+        CHECK(reader.frameSize() == kFrameSize);
+        std::string raw;
+        REQUIRE(reader.read(0, reader.rawLength(), &raw, &error));
+        restored += raw;
+
+        // Frames are reachable one at a time, in any order.
+        std::string frame;
+        const int64_t last = reader.frameCount() - 1;
+        REQUIRE(reader.readFrame(last, &frame, &error));
+        CHECK(frame == raw.substr(static_cast<size_t>(last * kFrameSize)));
+    }
+    CHECK(restored == fixture.input);
+}
+
+TEST_CASE(transformWritesPayloads) {
+    Fixture fixture(makeCapture(kFrameCount, kFrameSize));
+    std::string error;
+    REQUIRE(parseFrameTransform("strip=sync,swap=16", &fixture.options.transform, &error));
+    fixture.options.checksums = true;
+    SplitEngine engine(fixture.options);
+    REQUIRE(engine.run());
+    CHECK(engine.outputFrameBytes() == kFrameSize - 2);
+    // The input checksum still describes the input, not the payloads.
+    CHECK(engine.inputCrc32c() == crcOf(fixture.input));
+
+    std::string expected;
+    for (int64_t n = 0; n < kFrameCount; ++n) {
+        std::string payload = fixture.input.substr(static_cast<size_t>(n * kFrameSize + 2), kFrameSize - 2);
+        for (size_t i = 0; i + 1 < payload.size(); i += 2) std::swap(payload[i], payload[i + 1]);
+        expected += payload;
+    }
+    CHECK(concatBulks(engine) == expected);
+}
+
+// A second content-defined split of an edited copy only writes the bulks
+// around the edit.
+TEST_CASE(chunkedReusesBulks) {
+    Fixture fixture(makeCapture(kFrameCount, kFrameSize));
+    fixture.options.chunking.minBytes = 32 * 1024;
+    fixture.options.chunking.avgBytes = 128 * 1024;
+    fixture.options.chunking.maxBytes = 512 * 1024;
+    SplitEngine first(fixture.options);
+    REQUIRE(first.run());
+    CHECK(first.reusedBulks() == 0);
+
+    std::string edited = fixture.input;
+    edited[edited.size() / 2 + 20] ^= 0x5a;
+    REQUIRE(writeFile(fixture.options.inputPath, edited));
+    SplitEngine second(fixture.options);
+    REQUIRE(second.run());
+    CHECK(second.reusedBulks() > 0);
+    CHECK(second.reusedBulks() < int(second.finishedBulks().size()));
+
+    std::string joined;
+    for (const FinishedBulk &bulk : second.finishedBulks()) {
+        std::string data;
+        CHECK(readFile(second.bulkFilePath(bulk.index), &data));
+        CHECK(crcOf(data) == bulk.crc32c);
+        joined += data;
+    }
+    CHECK(joined == edited);
+}
+
+TEST_CASE(extractEveryNthFrame) {
+    Fixture fixture(makeCapture(kFrameCount, kFrameSize));
+    fixture.options.extract.firstFrame = 10;
+    fixture.options.extract.everyNth = 3;
+    SplitEngine engine(fixture.options);
+    REQUIRE(engine.run());
+
+    std::string expected;
+    for (int64_t n = 10; n < kFrameCount; n += 3) expected += fixture.input.substr(size_t(n * kFrameSize), kFrameSize);
+    CHECK(engine.extractedFrames() == (kFrameCount - 10 + 2) / 3);
+    CHECK(concatBulks(engine) == expected);
+}
+
+TEST_CASE(demuxByChannel) {
+    const int channels = 4;
+    Fixture fixture(makeCapture(kFrameCount, kFrameSize, channels));
+    std::string error;
+    REQUIRE(parseChannelField("2", &fixture.options.demux, &error));
+    SplitEngine engine(fixture.options);
+    REQUIRE(engine.run());
+    CHECK(engine.demuxChannels() == channels);
+    for (int channel = 0; channel < channels; ++channel) {
+        std::string expected;
+        for (int64_t n = channel; n < kFrameCount; n += channels) {
+            expected += fixture.input.substr(size_t(n * kFrameSize), kFrameSize);
+        }
+        CHECK(concatBulks(engine, channel) == expected);
+    }
+}
+
+// A damaged bulk fails its part checksum and leaves no output behind.
+TEST_CASE(joinRejectsDamagedBulk) {
+    Fixture fixture(makeCapture(kFrameCount, kFrameSize));
+    fixture.options.checksums = true;
+    SplitEngine engine(fixture.options);
+    REQUIRE(engine.run());
+
+    const std::string damaged = engine.bulkFilePath(3);
+    std::string bulk;
+    REQUIRE(readFile(damaged, &bulk));
+    bulk[bulk.size() / 2] ^= 1;
+    REQUIRE(writeFile(damaged, bulk));
+
+    std::string joined;
+    const std::string outputPath = fixture.dir.file("joined.bin");
+    CHECK(!joinBulks(engine, outputPath, 4, &joined));
+    CHECK(!fileExists(outputPath));
+    CHECK(!fileExists(outputPath + ".part"));
+
+    std::vector<FileChecksum> files;
+    for (const FinishedBulk &finished : engine.finishedBulks()) {
+        files.push_back({engine.bulkFilePath(finished.index), finished.length, finished.crc32c});
+    }
+    std::vector<VerifyFailure> failures;
+    CHECK(verifyFiles(files, 2, nullptr, &failures));
+    REQUIRE(failures.size() == 1);
+    CHECK(failures[0].file == 2);
+}
+
+// A split cancelled part way keeps its finished bulks in the journal; the
+// rerun skips them and the bulks add up to the input again.
+TEST_CASE(cancelThenResume) {
+    Fixture fixture(makeCapture(kFrameCount * 4, kFrameSize));
+    fixture.options.resume = true;
+    fixture.options.pipelined = true;
+    fixture.options.bufferBytes = 16 * 1024;
+    fixture.options.checksums = true;
+
+    SplitProgress progress;
+    std::atomic<bool> done(false);
+    std::thread canceller([&] {
+        while (!done.load() && progress.sample().bytesDone < int64_t(fixture.input.size()) / 2) std::this_thread::yield();
+        progress.requestCancel();
+    });
+    SplitEngine first(fixture.options);
+    first.setProgress(&progress);
+    const bool finished = first.run();
+    done = true;
+    canceller.join();
+    REQUIRE(!finished);
+    REQUIRE(first.wasCancelled());
+    CHECK(fileExists(first.journalPath()));
+
+    SplitEngine second(fixture.options);
+    REQUIRE(second.run());
+    CHECK(second.resumedBulks() > 0);
+    CHECK(!fileExists(second.journalPath()));
+    CHECK(concatBulks(second) == fixture.input);
+    CHECK(second.hasInputCrc() && second.inputCrc32c() == crcOf(fixture.input));
+}
+
+int main(int argc, char **argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,130 @@
+#include "testsupport.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+struct RegisteredTest {
+    const char *name;
+    TestFunction function;
+};
+
+std::vector<RegisteredTest> &registeredTests() {
+    static std::vector<RegisteredTest> tests;
+    return tests;
+}
+
+int g_failures = 0;
+
+int removeEntry(const char *path, const struct stat *, int, struct FTW *) {
+    return ::remove(path);
+}
+
+} // namespace
+
+bool registerTest(const char *name, TestFunction function) {
+    registeredTests().push_back({name, function});
+    return true;
+}
+
+void recordFailure(const char *file, int line, const std::string &what) {
+    std::fprintf(stderr, "%s:%d: %s failed\n", file, line, what.c_str());
+    ++g_failures;
+}
+
+int runTests(int argc, char **argv) {
+    int run = 0;
+    int failedCases = 0;
+    for (const RegisteredTest &test : registeredTests()) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc && !selected; ++i) selected = std::strcmp(argv[i], test.name) == 0;
+        if (!selected) continue;
+        const int before = g_failures;
+        test.function();
+        ++run;
+        const bool passed = g_failures == before;
+        if (!passed) ++failedCases;
+        std::printf("%s %s\n", passed ? "PASS" : "FAIL", test.name);
+    }
+    std::printf("%d of %d cases passed\n", run - failedCases, run);
+    return run > 0 && failedCases == 0 ? 0 : 1;
+}
+
+TempDir::TempDir() {
+    const char *base = std::getenv("TMPDIR");
+    std::string pattern = std::string(base && *base ? base : "/tmp") + "/splittertest.XXXXXX";
+    if (::mkdtemp(&pattern[0])) m_path = pattern;
+}
+
+TempDir::~TempDir() {
+    if (!m_path.empty()) ::nftw(m_path.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+uint64_t TestRandom::next() {
+    m_state ^= m_state >> 12;
+    m_state ^= m_state << 25;
+    m_state ^= m_state >> 27;
+    return m_state * 0x2545f4914f6cdd1dULL;
+}
+
+void TestRandom::fill(char *data, size_t size) {
+    for (size_t i = 0; i < size; i += 8) {
+        const uint64_t word = next();
+        std::memcpy(data + i, &word, std::min<size_t>(8, size - i));
+    }
+}
+
+std::string makeCapture(int64_t frameCount, int frameSize, int channels, uint64_t seed) {
+    TestRandom random(seed);
+    std::string data(static_cast<size_t>(frameCount * frameSize), '\0');
+    const int header = 11;
+    for (int64_t n = 0; n < frameCount; ++n) {
+        char *frame = &data[static_cast<size_t>(n * frameSize)];
+        const int body = frameSize - header;
+        if (body > 0) {
+            random.fill(frame + header, static_cast<size_t>(body / 2));
+            for (int i = body / 2; i < body; ++i) frame[header + i] = static_cast<char>("pattern"[i % 7]);
+        }
+        frame[0] = kSyncWord[0];
+        frame[1] = kSyncWord[1];
+        if (frameSize > 2) frame[2] = static_cast<char>(n % channels);
+        for (int i = 0; i < 8 && 3 + i < frameSize; ++i) frame[3 + i] = static_cast<char>(n >> (56 - 8 * i));
+    }
+    return data;
+}
+
+bool writeFile(const std::string &path, const std::string &data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+
+bool readFile(const std::string &path, std::string *data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    *data = contents.str();
+    return true;
+}
+
+bool fileExists(const std::string &path) {
+    return ::access(path.c_str(), F_OK) == 0;
+}
+
+int64_t fileSize(const std::string &path) {
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 ? static_cast<int64_t>(st.st_size) : -1;
+}
+
+int64_t allocatedBytes(const std::string &path) {
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 ? static_cast<int64_t>(st.st_blocks) * 512 : -1;
+}
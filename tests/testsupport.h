@@ -0,0 +1,83 @@
+#ifndef TESTSUPPORT_H
+#define TESTSUPPORT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A minimal harness for the ctest executables. TEST_CASE functions register
+// themselves, CHECK reports a failed condition and carries on, REQUIRE also
+// returns from the case. runTests() runs every case, or the ones named on the
+// command line, and returns nonzero if any check failed.
+
+using TestFunction = void (*)();
+
+bool registerTest(const char *name, TestFunction function);
+int runTests(int argc, char **argv);
+void recordFailure(const char *file, int line, const std::string &what);
+
+#define TEST_CASE(name)                                                 \
+    static void name();                                                 \
+    static const bool name##_registered = registerTest(#name, &name);  \
+    static void name()
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) recordFailure(__FILE__, __LINE__, "CHECK(" #condition ")"); \
+    } while (0)
+
+#define REQUIRE(condition)                                                    \
+    do {                                                                      \
+        if (!(condition)) {                                                   \
+            recordFailure(__FILE__, __LINE__, "REQUIRE(" #condition ")");     \
+            return;                                                           \
+        }                                                                     \
+    } while (0)
+
+// A fresh directory under $TMPDIR (or /tmp), removed with everything in it
+// when the object goes away. Tests write their inputs and bulks here, so
+// every engine runs against regular files on a real filesystem.
+class TempDir {
+public:
+    TempDir();
+    ~TempDir();
+    TempDir(const TempDir &) = delete;
+    TempDir &operator=(const TempDir &) = delete;
+
+    bool isValid() const { return !m_path.empty(); }
+    const std::string &path() const { return m_path; }
+    std::string file(const std::string &name) const { return m_path + "/" + name; }
+
+private:
+    std::string m_path;
+};
+
+// Deterministic xorshift64* stream, so a failing case fails the same way again.
+class TestRandom {
+public:
+    explicit TestRandom(uint64_t seed) : m_state(seed ? seed : 1) {}
+    uint64_t next();
+    uint64_t below(uint64_t bound) { return bound ? next() % bound : 0; }
+    void fill(char *data, size_t size);
+
+private:
+    uint64_t m_state;
+};
+
+// Synthetic capture of frameCount frames of frameSize bytes. Each frame opens
+// with the sync word 47 11, then a channel byte (frame % channels) and the
+// frame number as 8 big-endian bytes; the rest is random in the first half and
+// a repeating pattern in the second, so codecs find something to compress.
+std::string makeCapture(int64_t frameCount, int frameSize, int channels = 4, uint64_t seed = 1);
+
+const char kSyncWord[] = "\x47\x11";
+
+bool writeFile(const std::string &path, const std::string &data);
+bool readFile(const std::string &path, std::string *data);
+bool fileExists(const std::string &path);
+int64_t fileSize(const std::string &path);
+// Bytes the file occupies on disk, from st_blocks; less than its size when it has holes.
+int64_t allocatedBytes(const std::string &path);
+
+#endif // TESTSUPPORT_H
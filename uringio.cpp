@@ -0,0 +1,140 @@
+#include "uringio.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+int ringSetup(unsigned entries, io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ringRegister(int fd, unsigned opcode, const void *arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template <typename T>
+T *ringField(void *ring, uint32_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+} // namespace
+
+IoUring::~IoUring() {
+    if (m_sqes) munmap(m_sqes, m_sqesSize);
+    if (m_cqRing && m_cqRing != m_sqRing) munmap(m_cqRing, m_cqRingSize);
+    if (m_sqRing) munmap(m_sqRing, m_sqRingSize);
+    if (m_fd >= 0) ::close(m_fd);
+}
+
+bool IoUring::isAvailable() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    const int fd = ringSetup(2, &params);
+    if (fd < 0) return false;
+    ::close(fd);
+    return true;
+}
+
+bool IoUring::init(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    m_fd = ringSetup(entries, &params);
+    if (m_fd < 0) return false;
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+    }
+
+    void *sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) return false;
+    m_sqRing = sqRing;
+
+    if (singleMmap) {
+        m_cqRing = m_sqRing;
+    } else {
+        void *cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            m_fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) return false;
+        m_cqRing = cqRing;
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+    m_sqHead = ringField<unsigned>(m_sqRing, params.sq_off.head);
+    m_sqTail = ringField<unsigned>(m_sqRing, params.sq_off.tail);
+    m_sqMask = *ringField<unsigned>(m_sqRing, params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_sqArray = ringField<unsigned>(m_sqRing, params.sq_off.array);
+
+    m_cqHead = ringField<unsigned>(m_cqRing, params.cq_off.head);
+    m_cqTail = ringField<unsigned>(m_cqRing, params.cq_off.tail);
+    m_cqMask = *ringField<unsigned>(m_cqRing, params.cq_off.ring_mask);
+    m_cqes = ringField<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+    return true;
+}
+
+bool IoUring::registerBuffers(const iovec *buffers, unsigned count) {
+    return ringRegister(m_fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+}
+
+bool IoUring::registerFiles(const int *fds, unsigned count) {
+    return ringRegister(m_fd, IORING_REGISTER_FILES, fds, count) == 0;
+}
+
+bool IoUring::updateFile(unsigned slot, int fd) {
+    io_uring_files_update update;
+    std::memset(&update, 0, sizeof(update));
+    update.offset = slot;
+    update.fds = reinterpret_cast<uint64_t>(&fd);
+    return ringRegister(m_fd, IORING_REGISTER_FILES_UPDATE, &update, 1) == 1;
+}
+
+io_uring_sqe *IoUring::getSqe() {
+    const unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    const unsigned tail = *m_sqTail + m_sqPending;
+    if (tail - head >= m_sqEntries) return nullptr;
+
+    const unsigned index = tail & m_sqMask;
+    io_uring_sqe *sqe = &m_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    m_sqArray[index] = index;
+    ++m_sqPending;
+    return sqe;
+}
+
+int IoUring::submitAndWait(unsigned waitFor) {
+    const unsigned toSubmit = m_sqPending;
+    __atomic_store_n(m_sqTail, *m_sqTail + toSubmit, __ATOMIC_RELEASE);
+    m_sqPending = 0;
+
+    int submitted;
+    do {
+        submitted = ringEnter(m_fd, toSubmit, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0);
+    } while (submitted < 0 && errno == EINTR);
+    return submitted < 0 ? -errno : submitted;
+}
+
+bool IoUring::popCompletion(io_uring_cqe *cqe) {
+    const unsigned head = *m_cqHead;
+    if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) return false;
+    *cqe = m_cqes[head & m_cqMask];
+    __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
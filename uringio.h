@@ -0,0 +1,61 @@
+#ifndef URINGIO_H
+#define URINGIO_H
+
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+// Minimal io_uring wrapper on top of the raw syscalls, so the engine does not
+// need liburing. Covers what the splitter uses: one submission and completion
+// queue, registered buffers and a registered file table.
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring();
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    // False when the kernel has no io_uring or it is blocked (seccomp, sysctl).
+    static bool isAvailable();
+
+    // Sets up a ring with room for entries submissions. Returns false with errno set.
+    bool init(unsigned entries);
+
+    bool registerBuffers(const iovec *buffers, unsigned count);
+    // Entries may be -1 to reserve slots that updateFile() fills in later.
+    bool registerFiles(const int *fds, unsigned count);
+    bool updateFile(unsigned slot, int fd);
+
+    // Returns a zeroed SQE, or nullptr when the submission queue is full.
+    io_uring_sqe *getSqe();
+
+    // Submits queued SQEs and waits for at least waitFor completions.
+    // Returns the number submitted, or -errno.
+    int submitAndWait(unsigned waitFor);
+
+    // Copies out the oldest completion, if any, and releases its CQ slot.
+    bool popCompletion(io_uring_cqe *cqe);
+
+private:
+    int m_fd = -1;
+    void *m_sqRing = nullptr;
+    void *m_cqRing = nullptr;
+    size_t m_sqRingSize = 0;
+    size_t m_cqRingSize = 0;
+    io_uring_sqe *m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+
+    unsigned *m_sqHead = nullptr;
+    unsigned *m_sqTail = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+    unsigned *m_sqArray = nullptr;
+    unsigned m_sqPending = 0;
+
+    unsigned *m_cqHead = nullptr;
+    unsigned *m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    io_uring_cqe *m_cqes = nullptr;
+};
+
+#endif // URINGIO_H
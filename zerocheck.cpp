@@ -0,0 +1,63 @@
+#include "zerocheck.h"
+
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SPLITTER_HAVE_X86_ZERO_CHECK 1
+#endif
+
+namespace {
+
+bool isAllZeroScalar(const unsigned char *p, size_t size) {
+    uint64_t any = 0;
+    for (; size >= 32; p += 32, size -= 32) {
+        uint64_t words[4];
+        std::memcpy(words, p, 32);
+        any |= words[0] | words[1] | words[2] | words[3];
+        if (any) return false;
+    }
+    while (size--) any |= *p++;
+    return any == 0;
+}
+
+#ifdef SPLITTER_HAVE_X86_ZERO_CHECK
+// Four vectors are ORed before each test, so the branch is taken once per 64
+// or 128 bytes rather than per load.
+bool isAllZeroSse2(const unsigned char *p, size_t size) {
+    for (; size >= 64; p += 64, size -= 64) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 48));
+        const __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xffff) return false;
+    }
+    return isAllZeroScalar(p, size);
+}
+
+__attribute__((target("avx2")))
+bool isAllZeroAvx2(const unsigned char *p, size_t size) {
+    for (; size >= 128; p += 128, size -= 128) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 64));
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 96));
+        const __m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+        if (!_mm256_testz_si256(any, any)) return false;
+    }
+    return isAllZeroSse2(p, size);
+}
+#endif
+
+} // namespace
+
+bool isAllZero(const void *data, size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+#ifdef SPLITTER_HAVE_X86_ZERO_CHECK
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2 ? isAllZeroAvx2(p, size) : isAllZeroSse2(p, size);
+#else
+    return isAllZeroScalar(p, size);
+#endif
+}
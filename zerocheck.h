@@ -0,0 +1,11 @@
+#ifndef ZEROCHECK_H
+#define ZEROCHECK_H
+
+#include <cstddef>
+
+// True when all size bytes at data are zero. Uses AVX2 when the CPU has it,
+// SSE2 on other x86-64 CPUs and a word-at-a-time loop elsewhere; a nonzero
+// byte near the start returns after the first vector.
+bool isAllZero(const void *data, size_t size);
+
+#endif // ZEROCHECK_H